@@ -36,22 +36,70 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 
-CONFIG += c++11
+CONFIG += c++14
 
 SOURCES += \
+    bitpack.cpp \
+    bytescan.cpp \
+    bytestuffing.cpp \
+    checksum.cpp \
     commmanager.cpp \
+    crc16.cpp \
+    framereassembler.cpp \
+    iothread.cpp \
+    latencyhistogram.cpp \
     main.cpp \
     mainwindow.cpp \
     modbus.cpp \
+    packettrace.cpp \
+    reconnectpolicy.cpp \
+    registerconvert.cpp \
+    rtuframer.cpp \
+    rxbufferpool.cpp \
+    rxchannel.cpp \
+    sendqueue.cpp \
     serial.cpp \
-    tcp.cpp
+    serialmanager.cpp \
+    serialpollloop.cpp \
+    serialportoptions.cpp \
+    tcp.cpp \
+    tcpconnectionmanager.cpp \
+    tcpendpointgroup.cpp \
+    tcpsocketoptions.cpp \
+    udp.cpp \
+    unixsocket.cpp
 
 HEADERS += \
+    bitpack.h \
+    bytescan.h \
+    bytestuffing.h \
+    checksum.h \
     commmanager.h \
+    crc16.h \
+    framecodec.h \
+    framereassembler.h \
+    iothread.h \
+    latencyhistogram.h \
     mainwindow.h \
     modbus.h \
+    packettrace.h \
+    reconnectpolicy.h \
+    registerconvert.h \
+    rtuframer.h \
+    rxbufferpool.h \
+    rxchannel.h \
+    sendqueue.h \
     serial.h \
-    tcp.h
+    serialmanager.h \
+    serialpollloop.h \
+    serialportoptions.h \
+    spscqueue.h \
+    tcp.h \
+    tcpconnectionmanager.h \
+    tcpendpointgroup.h \
+    tcpsocketoptions.h \
+    udp.h \
+    unixsocket.h
 
 
 
@@ -0,0 +1,241 @@
+#include "bitpack.h"
+#include <QtEndian>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BITPACK_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef void (*PackFn)(const quint16 *, int, uchar *);
+
+//lut[b] holds the 8 bits of b as 0/1 bytes, lowest bit first
+struct UnpackTable
+{
+    quint64 lut[256];
+
+    UnpackTable()
+    {
+        for (int b = 0; b < 256; ++b) {
+            uchar bytes[8];
+            for (int i = 0; i < 8; ++i)
+                bytes[i] = (b >> i) & 1;
+            std::memcpy(&lut[b], bytes, sizeof(bytes));
+        }
+    }
+};
+
+const UnpackTable &unpackTable()
+{
+    static const UnpackTable t;
+    return t;
+}
+
+void packScalar(const quint16 *values, int count, uchar *bits)
+{
+    const int full = count / 8;
+    for (int i = 0; i < full; ++i) {
+        const quint16 *v = values + i * 8;
+        bits[i] = uchar((v[0] != 0) | ((v[1] != 0) << 1) | ((v[2] != 0) << 2) | ((v[3] != 0) << 3)
+                      | ((v[4] != 0) << 4) | ((v[5] != 0) << 5) | ((v[6] != 0) << 6) | ((v[7] != 0) << 7));
+    }
+    if (count % 8) {
+        uchar last = 0;
+        for (int i = full * 8; i < count; ++i)
+            last |= uchar((values[i] != 0) << (i & 7));
+        bits[full] = last;
+    }
+}
+
+#ifdef BITPACK_X86
+//16 values per step: compare against zero, narrow to bytes and take the sign bits
+__attribute__((target("sse2")))
+void packSse2(const quint16 *values, int count, uchar *bits)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m128i a = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)), zero);
+        const __m128i b = _mm_cmpeq_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i + 8)), zero);
+        const quint16 mask = quint16(~_mm_movemask_epi8(_mm_packs_epi16(a, b)));
+        bits[i / 8] = uchar(mask & 0xFF);
+        bits[i / 8 + 1] = uchar(mask >> 8);
+    }
+    packScalar(values + i, count - i, bits + i / 8);
+}
+
+__attribute__((target("avx2")))
+void packAvx2(const quint16 *values, int count, uchar *bits)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const __m256i a = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i)), zero);
+        const __m256i b = _mm256_cmpeq_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + i + 16)), zero);
+        //packs works per 128 bit lane, restore value order before taking the mask
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), 0xD8);
+        const quint32 mask = ~static_cast<quint32>(_mm256_movemask_epi8(packed));
+        std::memcpy(bits + i / 8, &mask, sizeof(mask)); //x86 is little endian, byte 0 holds values 0..7
+    }
+    packSse2(values + i, count - i, bits + i / 8);
+}
+#endif
+
+struct Kernel
+{
+    PackFn pack;
+    const char *name;
+};
+
+Kernel resolveKernel()
+{
+#ifdef BITPACK_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Kernel{packAvx2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+        return Kernel{packSse2, "sse2"};
+#endif
+    return Kernel{packScalar, "scalar"};
+}
+
+const Kernel &kernel()
+{
+    static const Kernel k = resolveKernel();
+    return k;
+}
+
+int popCount(quint64 v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    int n = 0;
+    for (; v; v &= v - 1)
+        ++n;
+    return n;
+#endif
+}
+
+int lowestBit(quint64 v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+}
+
+void BitPack::pack(const quint16 *values, int count, uchar *bits)
+{
+    if (!values || !bits || count <= 0)
+        return;
+    kernel().pack(values, count, bits);
+}
+
+void BitPack::unpack(const uchar *bits, int count, uchar *values)
+{
+    if (!bits || !values || count <= 0)
+        return;
+    const quint64 *lut = unpackTable().lut;
+    const int full = count / 8;
+    for (int i = 0; i < full; ++i)
+        std::memcpy(values + i * 8, &lut[bits[i]], 8);
+    for (int i = full * 8; i < count; ++i)
+        values[i] = testBit(bits, i) ? 1 : 0;
+}
+
+void BitPack::unpack(const uchar *bits, int count, quint16 *values)
+{
+    if (!bits || !values || count <= 0)
+        return;
+    const quint64 *lut = unpackTable().lut;
+    const int full = count / 8;
+    for (int i = 0; i < full; ++i) {
+        uchar bytes[8];
+        std::memcpy(bytes, &lut[bits[i]], 8);
+        for (int j = 0; j < 8; ++j)
+            values[i * 8 + j] = bytes[j];
+    }
+    for (int i = full * 8; i < count; ++i)
+        values[i] = testBit(bits, i) ? 1 : 0;
+}
+
+//word wise XOR, the loop is simple enough for the compiler to vectorise
+int BitPack::changed(const uchar *previous, const uchar *current, int count, uchar *changed)
+{
+    if (!previous || !current || !changed || count <= 0)
+        return 0;
+    const int bytes = byteCount(count);
+    int total = 0;
+    int i = 0;
+    for (; i + 8 <= bytes; i += 8) {
+        quint64 a, b;
+        std::memcpy(&a, previous + i, 8);
+        std::memcpy(&b, current + i, 8);
+        const quint64 x = a ^ b;
+        std::memcpy(changed + i, &x, 8);
+        total += popCount(x);
+    }
+    for (; i < bytes; ++i) {
+        changed[i] = previous[i] ^ current[i];
+        total += popCount(changed[i]);
+    }
+    if (count & 7) {
+        //ignore padding bits after the last value
+        const uchar padding = uchar(changed[bytes - 1] & ~((1u << (count & 7)) - 1));
+        changed[bytes - 1] ^= padding;
+        total -= popCount(padding);
+    }
+    return total;
+}
+
+//skips 64 clear bits at a time so sparse edges are found without walking every bit
+int BitPack::nextSetBit(const uchar *bits, int count, int from)
+{
+    if (!bits || from < 0 || from >= count)
+        return -1;
+    const int bytes = byteCount(count);
+    int byte = from >> 3;
+    quint64 word = bits[byte] & uchar(0xFFu << (from & 7));
+    if (word) {
+        const int index = byte * 8 + lowestBit(word);
+        return index < count ? index : -1;
+    }
+    ++byte;
+    while (byte < bytes) {
+        if (byte + 8 <= bytes) {
+            std::memcpy(&word, bits + byte, 8);
+            if (!word) {
+                byte += 8;
+                continue;
+            }
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+            word = qbswap(word);
+#endif
+        } else {
+            word = bits[byte];
+            if (!word) {
+                ++byte;
+                continue;
+            }
+        }
+        const int index = byte * 8 + lowestBit(word);
+        return index < count ? index : -1;
+    }
+    return -1;
+}
+
+const char *BitPack::kernelName()
+{
+    return kernel().name;
+}
@@ -0,0 +1,28 @@
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include <QtGlobal>
+
+//packed bitsets for coils and discrete inputs, same layout as the Modbus wire format
+//(bit 0 of byte 0 is the first coil), a bitset of count bits takes (count + 7) / 8 bytes
+class BitPack
+{
+public:
+    static int byteCount(int bitCount) { return (bitCount + 7) / 8; }
+
+    static void pack(const quint16 *values, int count, uchar *bits); //non zero value sets the bit
+    static void unpack(const uchar *bits, int count, quint16 *values); //0 or 1 per value
+    static void unpack(const uchar *bits, int count, uchar *values);
+
+    //XOR of two snapshots into changed, returns number of changed bits
+    static int changed(const uchar *previous, const uchar *current, int count, uchar *changed);
+    static int nextSetBit(const uchar *bits, int count, int from); //-1 when no bit is set from "from" on
+    static bool testBit(const uchar *bits, int index) { return (bits[index >> 3] >> (index & 7)) & 1; }
+
+    static const char *kernelName(); //"avx2", "sse2" or "scalar"
+
+private:
+    BitPack() {}
+};
+
+#endif // BITPACK_H
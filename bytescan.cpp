@@ -0,0 +1,134 @@
+#include "bytescan.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define BYTESCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef int (*AnyOf2Fn)(const char *, int, char, char);
+
+int anyOf2Scalar(const char *data, int size, char a, char b)
+{
+    for (int i = 0; i < size; ++i) {
+        if (data[i] == a || data[i] == b)
+            return i;
+    }
+    return -1;
+}
+
+#ifdef BYTESCAN_X86
+__attribute__((target("sse2")))
+int anyOf2Sse2(const char *data, int size, char a, char b)
+{
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    int i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, va), _mm_cmpeq_epi8(x, vb)));
+        if (mask)
+            return i + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+    const int rest = anyOf2Scalar(data + i, size - i, a, b);
+    return rest < 0 ? -1 : i + rest;
+}
+
+__attribute__((target("avx2")))
+int anyOf2Avx2(const char *data, int size, char a, char b)
+{
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    int i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(x, va), _mm256_cmpeq_epi8(x, vb))));
+        if (mask)
+            return i + __builtin_ctz(mask);
+    }
+    const int rest = anyOf2Sse2(data + i, size - i, a, b);
+    return rest < 0 ? -1 : i + rest;
+}
+#endif
+
+struct Dispatch
+{
+    AnyOf2Fn anyOf2;
+    const char *name;
+};
+
+bool cpuSupports(ByteScan::Kernel kernel)
+{
+#ifdef BYTESCAN_X86
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    static const bool sse2 = (__builtin_cpu_init(), __builtin_cpu_supports("sse2"));
+    switch (kernel) {
+    case ByteScan::Kernel::Avx2:
+        return avx2;
+    case ByteScan::Kernel::Sse2:
+        return sse2;
+    case ByteScan::Kernel::Scalar:
+        return true;
+    }
+    return false;
+#else
+    return kernel == ByteScan::Kernel::Scalar;
+#endif
+}
+
+Dispatch dispatchFor(ByteScan::Kernel kernel)
+{
+#ifdef BYTESCAN_X86
+    if (kernel == ByteScan::Kernel::Avx2 && cpuSupports(kernel))
+        return Dispatch{anyOf2Avx2, "avx2"};
+    if (kernel != ByteScan::Kernel::Scalar && cpuSupports(ByteScan::Kernel::Sse2))
+        return Dispatch{anyOf2Sse2, "sse2"};
+#else
+    Q_UNUSED(kernel)
+#endif
+    return Dispatch{anyOf2Scalar, "scalar"};
+}
+
+const Dispatch &dispatch()
+{
+    static const Dispatch d = dispatchFor(ByteScan::Kernel::Avx2);
+    return d;
+}
+
+}
+
+int ByteScan::indexOf(const char *data, int size, char c)
+{
+    if (!data || size <= 0)
+        return -1;
+    //libc memchr is already vectorised for a single byte
+    const void *hit = std::memchr(data, static_cast<unsigned char>(c), static_cast<size_t>(size));
+    return hit ? static_cast<int>(static_cast<const char *>(hit) - data) : -1;
+}
+
+int ByteScan::indexOfAny(const char *data, int size, char a, char b)
+{
+    if (!data || size <= 0)
+        return -1;
+    return dispatch().anyOf2(data, size, a, b);
+}
+
+const char *ByteScan::kernelName()
+{
+    return dispatch().name;
+}
+
+bool ByteScan::supports(Kernel kernel)
+{
+    return cpuSupports(kernel);
+}
+
+int ByteScan::indexOfAny(Kernel kernel, const char *data, int size, char a, char b)
+{
+    if (!data || size <= 0)
+        return -1;
+    return dispatchFor(kernel).anyOf2(data, size, a, b);
+}
@@ -0,0 +1,25 @@
+#ifndef BYTESCAN_H
+#define BYTESCAN_H
+
+#include <QtGlobal>
+
+//bulk delimiter search used by the CommManager framing helpers
+//x86 builds pick AVX2 or SSE2 at runtime, other targets use the scalar loop
+class ByteScan
+{
+public:
+    enum class Kernel { Scalar, Sse2, Avx2 };
+
+    static int indexOf(const char *data, int size, char c); //first c, -1 if not found
+    static int indexOfAny(const char *data, int size, char a, char b); //first a or b, -1 if not found
+    static const char *kernelName(); //"avx2", "sse2" or "scalar"
+
+    //force one path, for tests and benchmarks; a path the CPU lacks falls back to the next one down
+    static bool supports(Kernel kernel);
+    static int indexOfAny(Kernel kernel, const char *data, int size, char a, char b);
+
+private:
+    ByteScan() {}
+};
+
+#endif // BYTESCAN_H
@@ -0,0 +1,317 @@
+#include "bytestuffing.h"
+#include "bytescan.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+const uchar SlipEnd = 0xC0;
+const uchar SlipEsc = 0xDB;
+const uchar SlipEscEnd = 0xDC;
+const uchar SlipEscEsc = 0xDD;
+}
+
+//one shot helpers ---------------------------
+
+int ByteStuffing::maxEncodedSize(Mode mode, int size)
+{
+    if (mode == Mode::Cobs)
+        return size + size / 254 + 2; //code bytes plus the 0x00 delimiter
+    return size * 2 + 2; //every byte escaped plus END on both sides
+}
+
+int ByteStuffing::encode(Mode mode, const char *data, int size, char *out)
+{
+    ByteStuffingEncoder encoder(mode, out);
+    encoder.write(data, size);
+    return encoder.finish();
+}
+
+QByteArray ByteStuffing::encode(Mode mode, const QByteArray &payload)
+{
+    QByteArray out;
+    out.resize(maxEncodedSize(mode, payload.size()));
+    out.resize(encode(mode, payload.constData(), payload.size(), out.data()));
+    return out;
+}
+
+int ByteStuffing::decode(Mode mode, const char *frame, int size, char *out)
+{
+    const uchar *in = reinterpret_cast<const uchar *>(frame);
+    int o = 0;
+    if (mode == Mode::Cobs) {
+        int i = 0;
+        while (i < size) {
+            const uchar code = in[i++];
+            if (code == 0 || i + code - 1 > size)
+                return -1;
+            for (int j = 1; j < code; ++j) {
+                if (in[i] == 0)
+                    return -1;
+                out[o++] = static_cast<char>(in[i++]);
+            }
+            if (code < 0xFF && i < size)
+                out[o++] = 0;
+        }
+        return o;
+    }
+
+    for (int i = 0; i < size; ++i) {
+        uchar b = in[i];
+        if (b == SlipEnd)
+            continue; //leading/trailing END
+        if (b == SlipEsc) {
+            if (++i >= size)
+                return -1;
+            if (in[i] == SlipEscEnd)
+                b = SlipEnd;
+            else if (in[i] == SlipEscEsc)
+                b = SlipEsc;
+            else
+                return -1;
+        }
+        out[o++] = static_cast<char>(b);
+    }
+    return o;
+}
+
+QByteArray ByteStuffing::decode(Mode mode, const QByteArray &frame)
+{
+    QByteArray out;
+    out.resize(frame.size());
+    const int size = decode(mode, frame.constData(), frame.size(), out.data());
+    if (size < 0)
+        return QByteArray();
+    out.resize(size);
+    return out;
+}
+
+//encoder ---------------------------
+
+ByteStuffingEncoder::ByteStuffingEncoder(ByteStuffing::Mode stuffingMode, char *buffer)
+    : mode(stuffingMode),
+      out(reinterpret_cast<uchar *>(buffer))
+{
+    if (mode == ByteStuffing::Mode::Cobs) {
+        codePos = 0;
+        pos = 1;
+        code = 1;
+    } else {
+        out[pos++] = SlipEnd; //flushes line noise in front of the frame
+    }
+}
+
+//copies runs between special bytes instead of handling byte by byte
+void ByteStuffingEncoder::write(const char *data, int size)
+{
+    if (!data || size <= 0)
+        return;
+
+    if (mode == ByteStuffing::Mode::Cobs) {
+        while (size > 0) {
+            const int room = 0xFF - code; //data bytes left before the block is full
+            const int scan = qMin(size, room);
+            const int zero = ByteScan::indexOf(data, scan, 0);
+            const int run = zero == -1 ? scan : zero;
+            std::memcpy(out + pos, data, static_cast<size_t>(run));
+            pos += run;
+            code = static_cast<uchar>(code + run);
+            data += run;
+            size -= run;
+            if (zero != -1 || code == 0xFF) {
+                //close the block, a zero byte is implied by a code below 0xFF
+                out[codePos] = code;
+                codePos = pos++;
+                code = 1;
+                if (zero != -1) {
+                    ++data;
+                    --size;
+                }
+            }
+        }
+        return;
+    }
+
+    while (size > 0) {
+        const int special = ByteScan::indexOfAny(data, size, static_cast<char>(SlipEnd), static_cast<char>(SlipEsc));
+        const int run = special == -1 ? size : special;
+        std::memcpy(out + pos, data, static_cast<size_t>(run));
+        pos += run;
+        data += run;
+        size -= run;
+        if (special != -1) {
+            out[pos++] = SlipEsc;
+            out[pos++] = static_cast<uchar>(*data) == SlipEnd ? SlipEscEnd : SlipEscEsc;
+            ++data;
+            --size;
+        }
+    }
+}
+
+int ByteStuffingEncoder::finish()
+{
+    if (mode == ByteStuffing::Mode::Cobs) {
+        out[codePos] = code;
+        out[pos++] = 0;
+    } else {
+        out[pos++] = SlipEnd;
+    }
+    return pos;
+}
+
+//decoder ---------------------------
+
+ByteStuffingDecoder::ByteStuffingDecoder(ByteStuffing::Mode mode, int maxFrameSize, QObject *parent)
+    : QObject(parent),
+      stuffingMode(mode),
+      maxSize(maxFrameSize > 0 ? maxFrameSize : 1)
+{
+
+}
+ByteStuffingDecoder::~ByteStuffingDecoder(){
+
+}
+
+QList<QByteArray> ByteStuffingDecoder::feed(const QByteArray &chunk)
+{
+    QList<QByteArray> frames;
+    const char *p = chunk.constData();
+    int size = chunk.size();
+
+    if (stuffingMode == ByteStuffing::Mode::Cobs) {
+        while (size > 0) {
+            if (dropping) {
+                //resync: everything up to the next 0x00 belongs to the broken frame
+                const int zero = ByteScan::indexOf(p, size, 0);
+                if (zero == -1)
+                    return frames;
+                p += zero + 1;
+                size -= zero + 1;
+                reset();
+                continue;
+            }
+            if (remaining == 0) {
+                const uchar code = static_cast<uchar>(*p++);
+                --size;
+                if (code == 0) {
+                    if (started)
+                        endFrame(frames);
+                    continue; //empty frames between delimiters are ignored
+                }
+                if (zeroPending)
+                    append("\0", 1);
+                started = true;
+                remaining = code - 1;
+                zeroPending = code < 0xFF;
+                continue;
+            }
+            //data bytes of the current block, a zero inside means the block was cut short
+            const int scan = qMin(size, remaining);
+            const int zero = ByteScan::indexOf(p, scan, 0);
+            if (zero != -1) {
+                qWarning() << "COBS frame truncated, resynchronising";
+                dropFrame();
+                p += zero + 1;
+                size -= zero + 1;
+                reset();
+                continue;
+            }
+            append(p, scan);
+            p += scan;
+            size -= scan;
+            remaining -= scan;
+        }
+        return frames;
+    }
+
+    while (size > 0) {
+        if (dropping) {
+            const int end = ByteScan::indexOf(p, size, static_cast<char>(SlipEnd));
+            if (end == -1)
+                return frames;
+            p += end + 1;
+            size -= end + 1;
+            reset();
+            continue;
+        }
+        if (escaped) {
+            const uchar b = static_cast<uchar>(*p++);
+            --size;
+            escaped = false;
+            if (b == SlipEscEnd) {
+                append("\xC0", 1);
+            } else if (b == SlipEscEsc) {
+                append("\xDB", 1);
+            } else {
+                qWarning() << "SLIP invalid escape, resynchronising";
+                dropFrame();
+                if (b == SlipEnd)
+                    reset();
+            }
+            continue;
+        }
+        const int special = ByteScan::indexOfAny(p, size, static_cast<char>(SlipEnd), static_cast<char>(SlipEsc));
+        const int run = special == -1 ? size : special;
+        append(p, run);
+        p += run;
+        size -= run;
+        if (special != -1) {
+            const uchar b = static_cast<uchar>(*p++);
+            --size;
+            if (b == SlipEnd) {
+                if (!frame.isEmpty() && !dropping)
+                    endFrame(frames);
+                reset();
+            } else {
+                escaped = true;
+            }
+        }
+    }
+    return frames;
+}
+
+void ByteStuffingDecoder::append(const char *data, int size)
+{
+    if (dropping || size <= 0)
+        return;
+    if (frame.size() + size > maxSize) {
+        qWarning() << "Stuffed frame exceeded" << maxSize << "bytes, dropped";
+        dropFrame();
+        return;
+    }
+    frame.append(data, size);
+}
+
+void ByteStuffingDecoder::endFrame(QList<QByteArray> &frames)
+{
+    if (!dropping) {
+        const QByteArray decoded = frame;
+        frames.append(decoded);
+        emit frameReady(decoded);
+    }
+    reset();
+}
+
+void ByteStuffingDecoder::dropFrame()
+{
+    if (!dropping)
+        emit frameDropped(frame.size());
+    dropping = true;
+    frame.clear();
+}
+
+void ByteStuffingDecoder::reset()
+{
+    frame.clear();
+    dropping = false;
+    escaped = false;
+    remaining = 0;
+    zeroPending = false;
+    started = false;
+}
+
+void ByteStuffingDecoder::setMaxFrameSize(int maxFrameSize)
+{
+    maxSize = maxFrameSize > 0 ? maxFrameSize : 1;
+    if (frame.size() > maxSize)
+        reset();
+}
@@ -0,0 +1,82 @@
+#ifndef BYTESTUFFING_H
+#define BYTESTUFFING_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+
+//binary safe framing by byte stuffing, an alternative to the start/end delimiter frames
+//  Cobs  consistent overhead byte stuffing, frames end with 0x00, at most 1 byte overhead per 254
+//  Slip  RFC 1055, frames are wrapped in 0xC0, 0xC0/0xDB in the payload are escaped
+//a corrupted frame is dropped at the next delimiter byte, so resynchronisation costs nothing extra
+class ByteStuffing
+{
+public:
+    enum class Mode {
+        Cobs,
+        Slip
+    };
+
+    static int maxEncodedSize(Mode mode, int size); //worst case frame size including delimiters
+    static int encode(Mode mode, const char *data, int size, char *out); //out needs maxEncodedSize bytes
+    static QByteArray encode(Mode mode, const QByteArray &payload);
+    static int decode(Mode mode, const char *frame, int size, char *out); //frame without delimiters, -1 if corrupt
+    static QByteArray decode(Mode mode, const QByteArray &frame);
+
+private:
+    ByteStuffing() {}
+};
+
+//streaming encoder, writes straight into a buffer of maxEncodedSize bytes so payload pieces
+//(fields, crc) can be stuffed one after another without joining them first
+class ByteStuffingEncoder
+{
+public:
+    ByteStuffingEncoder(ByteStuffing::Mode mode, char *out);
+
+    void write(const char *data, int size);
+    int finish(); //closes the frame, returns the number of bytes written
+
+private:
+    ByteStuffing::Mode mode;
+    uchar *out;
+    int pos = 0;
+    int codePos = 0; //cobs: where the code byte of the current block goes
+    uchar code = 1;
+};
+
+//streaming decoder, accepts chunks as they are read and keeps the partial frame between calls
+class ByteStuffingDecoder : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ByteStuffingDecoder(ByteStuffing::Mode mode, int maxFrameSize = 4096, QObject *parent = nullptr);
+    ~ByteStuffingDecoder();
+
+    QList<QByteArray> feed(const QByteArray &chunk); //returns the decoded frames and emits frameReady for each
+    void reset();
+
+    ByteStuffing::Mode mode() const { return stuffingMode; }
+    void setMaxFrameSize(int maxFrameSize);
+    int maxFrameSize() const { return maxSize; }
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void frameDropped(int size); //corrupt or larger than maxFrameSize
+
+private:
+    void append(const char *data, int size);
+    void endFrame(QList<QByteArray> &frames);
+    void dropFrame();
+
+    ByteStuffing::Mode stuffingMode;
+    int maxSize;
+    QByteArray frame; //decoded bytes of the current frame
+    bool dropping = false; //skip to the next delimiter
+    bool escaped = false; //slip: previous byte was ESC
+    int remaining = 0; //cobs: data bytes left in the current block
+    bool zeroPending = false; //cobs: the current block ends with an implied zero
+    bool started = false; //cobs: a code byte was seen for this frame
+};
+
+#endif // BYTESTUFFING_H
@@ -0,0 +1,287 @@
+#include "checksum.h"
+#include "crc16.h"
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//CRC-16/CCITT, msb first, slice-by-8 tables, table[k][n] is the crc of byte n followed by k zero bytes
+struct CcittTables
+{
+    quint16 table[8][256];
+
+    CcittTables()
+    {
+        for (int n = 0; n < 256; ++n) {
+            quint16 crc = static_cast<quint16>(n << 8);
+            for (int i = 0; i < 8; ++i)
+                crc = (crc & 0x8000) ? static_cast<quint16>((crc << 1) ^ 0x1021) : static_cast<quint16>(crc << 1);
+            table[0][n] = crc;
+        }
+        for (int n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k)
+                table[k][n] = static_cast<quint16>((table[k - 1][n] << 8) ^ table[0][table[k - 1][n] >> 8]);
+        }
+    }
+};
+
+const CcittTables &ccittTables()
+{
+    static const CcittTables t;
+    return t;
+}
+
+quint16 ccittUpdate(quint16 crc, const uchar *p, int size)
+{
+    const quint16 (*t)[256] = ccittTables().table;
+    while (size >= 8) {
+        crc ^= static_cast<quint16>((p[0] << 8) | p[1]);
+        crc = t[7][crc >> 8] ^ t[6][crc & 0xFF]
+            ^ t[5][p[2]] ^ t[4][p[3]]
+            ^ t[3][p[4]] ^ t[2][p[5]]
+            ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = static_cast<quint16>((crc << 8) ^ t[0][((crc >> 8) ^ *p++) & 0xFF]);
+    return crc;
+}
+
+//CRC-32C reflected (poly 0x82F63B78) slice-by-8 tables for targets without the crc32 instruction
+struct Crc32cTables
+{
+    quint32 table[8][256];
+
+    Crc32cTables()
+    {
+        for (quint32 n = 0; n < 256; ++n) {
+            quint32 crc = n;
+            for (int i = 0; i < 8; ++i)
+                crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+            table[0][n] = crc;
+        }
+        for (int n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k)
+                table[k][n] = (table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF];
+        }
+    }
+};
+
+const Crc32cTables &crc32cTables()
+{
+    static const Crc32cTables t;
+    return t;
+}
+
+typedef quint32 (*Crc32cFn)(quint32, const uchar *, int);
+
+quint32 crc32cTable(quint32 crc, const uchar *p, int size)
+{
+    const quint32 (*t)[256] = crc32cTables().table;
+    while (size >= 8) {
+        const quint32 lo = crc ^ (quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24));
+        crc = t[7][lo & 0xFF] ^ t[6][(lo >> 8) & 0xFF]
+            ^ t[5][(lo >> 16) & 0xFF] ^ t[4][lo >> 24]
+            ^ t[3][p[4]] ^ t[2][p[5]]
+            ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+    return crc;
+}
+
+#ifdef CHECKSUM_X86
+__attribute__((target("sse4.2")))
+quint32 crc32cSse42(quint32 crc, const uchar *p, int size)
+{
+#if defined(__x86_64__)
+    quint64 crc64 = crc;
+    while (size >= 8) {
+        quint64 word;
+        std::memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<quint32>(crc64);
+#endif
+    while (size >= 4) {
+        quint32 word;
+        std::memcpy(&word, p, sizeof(word));
+        crc = _mm_crc32_u32(crc, word);
+        p += 4;
+        size -= 4;
+    }
+    while (size-- > 0)
+        crc = _mm_crc32_u8(crc, *p++);
+    return crc;
+}
+#endif
+
+struct Crc32cImpl
+{
+    Crc32cFn update;
+    const char *name;
+};
+
+bool hasSse42()
+{
+#ifdef CHECKSUM_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+#else
+    return false;
+#endif
+}
+
+Crc32cImpl resolveCrc32c()
+{
+#ifdef CHECKSUM_X86
+    if (hasSse42())
+        return Crc32cImpl{crc32cSse42, "sse4.2"};
+#endif
+    return Crc32cImpl{crc32cTable, "slice-by-8"};
+}
+
+const Crc32cImpl &crc32cKernel()
+{
+    static const Crc32cImpl k = resolveCrc32c();
+    return k;
+}
+
+quint32 initialState(Checksum::Algorithm algorithm)
+{
+    return algorithm == Checksum::Algorithm::Crc32c ? 0xFFFFFFFFu : 0xFFFFu;
+}
+
+quint32 updateState(Checksum::Algorithm algorithm, quint32 state, const char *data, int size)
+{
+    if (!data || size <= 0)
+        return state;
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+    switch (algorithm) {
+    case Checksum::Algorithm::Crc16Modbus:
+        return Crc16::update(static_cast<quint16>(state), data, size);
+    case Checksum::Algorithm::Crc16Ccitt:
+        return ccittUpdate(static_cast<quint16>(state), p, size);
+    case Checksum::Algorithm::Crc32c:
+        return crc32cKernel().update(state, p, size);
+    }
+    return state;
+}
+
+quint32 finalValue(Checksum::Algorithm algorithm, quint32 state)
+{
+    return algorithm == Checksum::Algorithm::Crc32c ? ~state : state;
+}
+
+}
+
+Checksum::Checksum(Algorithm algorithm)
+    : algo(algorithm),
+      state(initialState(algorithm))
+{
+
+}
+
+void Checksum::reset()
+{
+    state = initialState(algo);
+}
+
+void Checksum::update(const char *data, int size)
+{
+    state = updateState(algo, state, data, size);
+}
+
+quint32 Checksum::value() const
+{
+    return finalValue(algo, state);
+}
+
+quint32 Checksum::compute(Algorithm algorithm, const char *data, int size)
+{
+    return finalValue(algorithm, updateState(algorithm, initialState(algorithm), data, size));
+}
+
+int Checksum::size(Algorithm algorithm)
+{
+    return algorithm == Algorithm::Crc32c ? 4 : 2;
+}
+
+void Checksum::write(Algorithm algorithm, quint32 value, char *out)
+{
+    switch (algorithm) {
+    case Algorithm::Crc16Modbus:
+        out[0] = static_cast<char>(value & 0xFF);        // low byte
+        out[1] = static_cast<char>((value >> 8) & 0xFF); // high byte
+        break;
+    case Algorithm::Crc16Ccitt:
+        out[0] = static_cast<char>((value >> 8) & 0xFF);
+        out[1] = static_cast<char>(value & 0xFF);
+        break;
+    case Algorithm::Crc32c:
+        for (int i = 0; i < 4; ++i)
+            out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        break;
+    }
+}
+
+quint32 Checksum::read(Algorithm algorithm, const char *in)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(in);
+    switch (algorithm) {
+    case Algorithm::Crc16Modbus:
+        return p[0] | (p[1] << 8);
+    case Algorithm::Crc16Ccitt:
+        return (p[0] << 8) | p[1];
+    case Algorithm::Crc32c:
+        return quint32(p[0]) | (quint32(p[1]) << 8) | (quint32(p[2]) << 16) | (quint32(p[3]) << 24);
+    }
+    return 0;
+}
+
+const char *Checksum::name(Algorithm algorithm)
+{
+    switch (algorithm) {
+    case Algorithm::Crc16Modbus: return "CRC-16/MODBUS";
+    case Algorithm::Crc16Ccitt:  return "CRC-16/CCITT-FALSE";
+    case Algorithm::Crc32c:      return "CRC-32C";
+    }
+    return "unknown";
+}
+
+const char *Checksum::kernelName(Algorithm algorithm)
+{
+    if (algorithm == Algorithm::Crc32c)
+        return crc32cKernel().name;
+    return "slice-by-8";
+}
+
+bool Checksum::supports(Crc32cKernel kernel)
+{
+    return kernel == Crc32cKernel::Table || hasSse42();
+}
+
+quint32 Checksum::crc32c(Crc32cKernel kernel, const char *data, int size)
+{
+    if (!supports(kernel))
+        return 0;
+    quint32 crc = 0xFFFFFFFFu;
+    if (data && size > 0) {
+        const uchar *p = reinterpret_cast<const uchar *>(data);
+#ifdef CHECKSUM_X86
+        crc = kernel == Crc32cKernel::Sse42 ? crc32cSse42(crc, p, size) : crc32cTable(crc, p, size);
+#else
+        crc = crc32cTable(crc, p, size);
+#endif
+    }
+    return ~crc;
+}
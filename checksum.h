@@ -0,0 +1,47 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+//selectable frame checksum, one object can be fed incrementally while bytes arrive
+//  Crc16Modbus  CRC-16/IBM as used by Modbus RTU, 2 bytes low byte first
+//  Crc16Ccitt   CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), 2 bytes high byte first
+//  Crc32c       CRC-32C Castagnoli, SSE4.2 crc32 instruction when available, 4 bytes low byte first
+class Checksum
+{
+public:
+    enum class Algorithm {
+        Crc16Modbus,
+        Crc16Ccitt,
+        Crc32c
+    };
+    enum class Crc32cKernel { Table, Sse42 };
+
+    explicit Checksum(Algorithm algorithm = Algorithm::Crc16Modbus);
+
+    void reset();
+    void update(const char *data, int size);
+    void update(const QByteArray &data) { update(data.constData(), data.size()); }
+    quint32 value() const; //final checksum of everything fed since reset
+    Algorithm algorithm() const { return algo; }
+    int size() const { return size(algo); }
+
+    static quint32 compute(Algorithm algorithm, const char *data, int size);
+    static quint32 compute(Algorithm algorithm, const QByteArray &data) { return compute(algorithm, data.constData(), data.size()); }
+    static int size(Algorithm algorithm); //bytes on the wire
+    static void write(Algorithm algorithm, quint32 value, char *out); //wire byte order of the algorithm
+    static quint32 read(Algorithm algorithm, const char *in);
+    static const char *name(Algorithm algorithm);
+    static const char *kernelName(Algorithm algorithm); //implementation picked at runtime
+
+    //force one CRC-32C path, for tests and benchmarks; false/0 when the CPU lacks it
+    static bool supports(Crc32cKernel kernel);
+    static quint32 crc32c(Crc32cKernel kernel, const char *data, int size);
+
+private:
+    Algorithm algo;
+    quint32 state;
+};
+
+#endif // CHECKSUM_H
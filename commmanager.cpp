@@ -1,4 +1,6 @@
 #include "commmanager.h"
+#include "bytescan.h"
+#include <cstring>
 
 CommManager::CommManager(QObject *parent) : QObject(parent)
 {
@@ -13,75 +15,228 @@ CommManager::~CommManager(){
 
 //package frame with startLimiter and endLimiter
 QByteArray CommManager::addFrameDelimiter(const QByteArray &payload,char startLimiter, char endLimiter){
-    if(payload.length()==0){
+    QByteArray frame;
+    if(writeFrame(frame,payload,startLimiter,endLimiter)==0){
         qCritical()<<"Not valid payload passed to add FrameDelimiter"<<endl;
         return nullptr;
     }
-    QByteArray frame;
-    frame.append(startLimiter);
-    frame.append(payload);
-    frame.append(endLimiter);
     return frame;
 }
 
 //package frame with delimater and seperator
 QByteArray CommManager::addFrameDelimiter(const QList<QByteArray> &payload,char startLimiter, char endLimiter,char seperator){
-    if(payload.length()==0){
+    QByteArray frame;
+    if(writeFrame(frame,payload,startLimiter,endLimiter,seperator)==0){
         qCritical()<<"Not valid payload passed to add FrameDelimiter"<<endl;
         return nullptr;
     }
-    QByteArray frame;
-    frame.append(startLimiter);
-    for(int i=0;i<payload.length();i++){
-        frame.append(seperator);
-        frame.append(payload[i]);
+    return frame;
+}
+
+//write start, payload, end and optional crc with one resize of out, out may be the payload itself
+int CommManager::writeFrame(QByteArray &out,const QByteArray &payload,char startLimiter, char endLimiter,bool withCRC){
+    if(payload.length()==0)
+        return 0;
+
+    const int payloadSize=payload.size();
+    const bool inPlace=&out==&payload; // framing the buffer itself, resize keeps the payload at the front
+    const int frameSize=payloadSize+2;
+    out.resize(frameSize+(withCRC ? Checksum::size(checksumAlgo) : 0));
+    char *p=out.data();
+    if(inPlace)
+        memmove(p+1,p,payloadSize);
+    else
+        memcpy(p+1,payload.constData(),payloadSize);
+    p[0]=startLimiter;
+    p[frameSize-1]=endLimiter;
+    if(withCRC)
+        Checksum::write(checksumAlgo,Checksum::compute(checksumAlgo,p,frameSize),p+frameSize);
+    return out.size();
+}
+
+//write start, seperator before each field, end and optional crc, crc is updated as fields are copied
+int CommManager::writeFrame(QByteArray &out,const QList<QByteArray> &payload,char startLimiter, char endLimiter,char seperator,bool withCRC){
+    if(payload.length()==0)
+        return 0;
+
+    //out passed as one of the fields is overwritten from the front, keep its bytes (one copy, only then)
+    QByteArray aliased;
+    int frameSize=2;
+    for(const QByteArray &field:payload){
+        frameSize+=field.size()+1;
+        if(&field==&out)
+            aliased=out;
+    }
+    out.resize(frameSize+(withCRC ? Checksum::size(checksumAlgo) : 0));
+
+    char *p=out.data();
+    const char *crcFrom=p; // first byte not yet in the checksum
+    Checksum crc(checksumAlgo);
+    *p++=startLimiter;
+    for(const QByteArray &item:payload){
+        const QByteArray &field=&item==&out ? aliased : item;
+        *p++=seperator;
+        memcpy(p,field.constData(),field.size());
+        p+=field.size();
+        if(withCRC){
+            crc.update(crcFrom,static_cast<int>(p-crcFrom)); // while the field is still in cache
+            crcFrom=p;
+        }
+    }
+    *p++=endLimiter;
+    if(withCRC){
+        crc.update(crcFrom,static_cast<int>(p-crcFrom));
+        Checksum::write(checksumAlgo,crc.value(),p);
     }
-    frame.append(endLimiter);
+    return out.size();
+}
+
+//package payload as a COBS or SLIP frame
+QByteArray CommManager::addStuffedFrame(const QByteArray &payload,ByteStuffing::Mode mode){
+    QByteArray frame;
+    writeStuffedFrame(frame,payload,mode);
     return frame;
 }
 
+//stuff payload and optional crc straight into out, sized for the worst case and trimmed once
+int CommManager::writeStuffedFrame(QByteArray &out,const QByteArray &source,ByteStuffing::Mode mode,bool withCRC){
+    //stuffing grows the data, stuffing out into itself needs the original bytes kept aside
+    const QByteArray aliased=&out==&source ? source : QByteArray();
+    const QByteArray &payload=&out==&source ? aliased : source;
+    const int crcSize=withCRC ? Checksum::size(checksumAlgo) : 0;
+    out.resize(ByteStuffing::maxEncodedSize(mode,payload.size()+crcSize));
+
+    ByteStuffingEncoder encoder(mode,out.data());
+    encoder.write(payload.constData(),payload.size());
+    if(withCRC){
+        char crc[4];
+        Checksum::write(checksumAlgo,Checksum::compute(checksumAlgo,payload),crc);
+        encoder.write(crc,crcSize);
+    }
+    out.resize(encoder.finish());
+    return out.size();
+}
+
+//decode all complete COBS/SLIP frames in the buffer, a partial frame at the end is ignored
+QList<QByteArray> CommManager::splitStuffedFrames(const QByteArray &rawBuffer,ByteStuffing::Mode mode){
+    ByteStuffingDecoder decoder(mode,rawBuffer.size()+1);
+    return decoder.feed(rawBuffer);
+}
+
 //extract payload from rawframe
 QByteArray CommManager::stripFrameDelimiter(const QByteArray &rawFrame,char startLimiter, char endLimiter){
-    int startIndex=rawFrame.indexOf(startLimiter);
-    int endIndex=rawFrame.indexOf(endLimiter);
-    if(startIndex==-1||endIndex==-1 || endIndex<startIndex){
+    FrameView view=stripFrameDelimiterView(rawFrame,startLimiter,endLimiter);
+    if(!view.isValid()){
         qCritical() << "No Valid Packet"<<endl;
         return QByteArray();
     }
-    return rawFrame.mid(startIndex+1,endIndex-startIndex-1);
+    return rawFrame.mid(view.offset,view.length);
 
 }
 
 //extract payload seperated with delimator
 QList<QByteArray> CommManager::stripFrameDelimiter(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator){
 
-    int startIndex=rawFrame.indexOf(startLimiter);
-    int endIndex=rawFrame.indexOf(endLimiter);
-
-    if(startIndex==-1||endIndex==-1 || endIndex<startIndex){
+    QVector<FrameView> fields;
+    if(stripFrameDelimiterViews(rawFrame,startLimiter,endLimiter,seperator,fields)==0){
         qCritical() << "No Valid Packet"<<endl;
         return QList<QByteArray>();
     }
-    QByteArray payload=rawFrame.mid(startIndex+1,startIndex-endIndex-1);
-    return payload.split(seperator);
+    QList<QByteArray> list;
+    for(const FrameView &field:fields)
+        list.append(rawFrame.mid(field.offset,field.length));
+    return list;
 
 }
 
 //split multiple frames/packets
 QList<QByteArray> CommManager::splitFrames(const QByteArray &rawBuffer,char startLimiter, char endLimiter){
 
+    QVector<FrameView> frames;
+    splitFrameViews(rawBuffer,startLimiter,endLimiter,frames);
+
     QList<QByteArray> frameList;
+    for(const FrameView &frame:frames)
+        frameList.append(rawBuffer.mid(frame.offset,frame.length));
+    return frameList;
+}
+
+//payload position between the first start and end delimiter, invalid view if there is none
+FrameView CommManager::stripFrameDelimiterView(const QByteArray &rawFrame,char startLimiter, char endLimiter){
+    FrameView whole;
+    whole.offset=0;
+    whole.length=rawFrame.size();
+    return stripFrameDelimiterView(rawFrame,whole,startLimiter,endLimiter);
+}
+
+//same inside one frame of a larger buffer, e.g. a view from splitFrameViews
+FrameView CommManager::stripFrameDelimiterView(const QByteArray &buffer,const FrameView &frame,char startLimiter, char endLimiter){
+    FrameView view;
+    if(!frame.isValid() || frame.offset+frame.length>buffer.size())
+        return view;
+    const char *p=buffer.constData()+frame.offset;
+    int startIndex=ByteScan::indexOf(p,frame.length,startLimiter);
+    int endIndex=ByteScan::indexOf(p,frame.length,endLimiter);
+    if(startIndex==-1||endIndex==-1 || endIndex<startIndex)
+        return view;
+    view.offset=frame.offset+startIndex+1;
+    view.length=endIndex-startIndex-1;
+    return view;
+}
+
+//field positions of a payload seperated with delimator, returns number of fields (0 if no valid packet)
+int CommManager::stripFrameDelimiterViews(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator,QVector<FrameView> &fields){
+    FrameView whole;
+    whole.offset=0;
+    whole.length=rawFrame.size();
+    return stripFrameDelimiterViews(rawFrame,whole,startLimiter,endLimiter,seperator,fields);
+}
+
+int CommManager::stripFrameDelimiterViews(const QByteArray &buffer,const FrameView &frame,char startLimiter, char endLimiter,char seperator,QVector<FrameView> &fields){
+    fields.clear();
+    FrameView payload=stripFrameDelimiterView(buffer,frame,startLimiter,endLimiter);
+    if(!payload.isValid())
+        return 0;
+
+    //same fields as QByteArray::split, an empty payload gives one empty field
+    const char *p=buffer.constData();
+    const int end=payload.offset+payload.length;
+    FrameView field;
+    field.offset=payload.offset;
+    int hit;
+    while((hit=ByteScan::indexOf(p+field.offset,end-field.offset,seperator))!=-1){
+        field.length=hit;
+        fields.append(field);
+        field.offset+=hit+1;
+    }
+    field.length=end-field.offset;
+    fields.append(field);
+    return fields.size();
+}
+
+//positions of all complete frames in the buffer, delimiters included
+int CommManager::splitFrameViews(const QByteArray &rawBuffer,char startLimiter, char endLimiter,QVector<FrameView> &frames){
+    frames.clear();
+    const char *p=rawBuffer.constData();
+    const int size=rawBuffer.size();
     int start=-1;
 
-    for(int i=0;i<rawBuffer.length();i++){
-       if(rawBuffer[i]==startLimiter)start=i;
-       else if(rawBuffer[i]==endLimiter && start!=-1){
-           int end=i-start+1;
-           frameList.append(rawBuffer.mid(start,end));
+    //jump between delimiter bytes instead of testing every byte
+    int i=0;
+    int hit;
+    while(i<size && (hit=ByteScan::indexOfAny(p+i,size-i,startLimiter,endLimiter))!=-1){
+       i+=hit;
+       if(p[i]==startLimiter)start=i;
+       else if(start!=-1){
+           FrameView frame;
+           frame.offset=start;
+           frame.length=i-start+1;
+           frames.append(frame);
            start=-1;
        }
+       i++;
     }
-    return frameList;
+    return frames.size();
 }
 
 
@@ -89,41 +244,64 @@ QList<QByteArray> CommManager::splitFrames(const QByteArray &rawBuffer,char star
 //crc check
 quint16 CommManager::calculateCRC(const QByteArray &data)
 {
-    quint16 crc = 0xFFFF; // initial value
-    for (auto b : data) {
-        crc ^= static_cast<quint8>(b);
-        for (int i = 0; i < 8; ++i) {
-            if (crc & 0x0001)
-                crc = (crc >> 1) ^ 0xA001; // polynomial for CRC-16-IBM
-            else
-                crc >>= 1;
-        }
-    }
-    return crc;
+    return Crc16::compute(data); // CRC-16-IBM, initial value 0xFFFF
 }
+
+quint16 CommManager::calculateCRC(const char *data, int size)
+{
+    return Crc16::compute(data, size);
+}
+
+//continue a crc over more bytes, lets the crc be built while data arrives
+quint16 CommManager::updateCRC(quint16 crc, const QByteArray &data)
+{
+    return Crc16::update(crc, data);
+}
+
 bool CommManager::validateCRC(const QByteArray &frame)
 {
-    if (frame.size() < 3) // at least 1 byte data + 2 bytes CRC
+    const int crcSize = Checksum::size(checksumAlgo);
+    if (frame.size() < crcSize + 1) // at least 1 byte data + CRC
         return false;
 
-    QByteArray data = frame.left(frame.size() - 2); // payload without CRC
-    quint16 crcInFrame = static_cast<quint8>(frame[frame.size() - 2]) |
-                         (static_cast<quint8>(frame[frame.size() - 1]) << 8);
+    quint32 crcInFrame = Checksum::read(checksumAlgo, frame.constData() + frame.size() - crcSize);
 
-    quint16 crcCalc = calculateCRC(data);
+    quint32 crcCalc = Checksum::compute(checksumAlgo, frame.constData(), frame.size() - crcSize); // payload without CRC, no copy
 
     return crcCalc == crcInFrame;
 }
 
+//checksum used for frames of this link, see Checksum::Algorithm
+void CommManager::setChecksumAlgorithm(Checksum::Algorithm algorithm)
+{
+    checksumAlgo = algorithm;
+}
+
+quint32 CommManager::calculateChecksum(const QByteArray &data)
+{
+    return Checksum::compute(checksumAlgo, data);
+}
+
 QByteArray CommManager::appendCRC(const QByteArray &frame)
 {
-    quint16 crc = calculateCRC(frame);
-    QByteArray out = frame;
-    out.append(static_cast<char>(crc & 0xFF));       // low byte
-    out.append(static_cast<char>((crc >> 8) & 0xFF)); // high byte
+    QByteArray out;
+    writeCRCFrame(out, frame);
     return out;
 }
 
+//copy frame and its crc into out with a single resize
+int CommManager::writeCRCFrame(QByteArray &out, const QByteArray &frame)
+{
+    const int size = frame.size();
+    const bool inPlace = &out == &frame; // appending to the frame itself
+    out.resize(size + Checksum::size(checksumAlgo));
+    char *p = out.data();
+    if (!inPlace)
+        memcpy(p, frame.constData(), size);
+    Checksum::write(checksumAlgo, Checksum::compute(checksumAlgo, p, size), p + size);
+    return out.size();
+}
+
 
 
 //Data conversion--------------
@@ -131,14 +309,14 @@ QByteArray CommManager::appendCRC(const QByteArray &frame)
 //extract Integer form raw frame
 int CommManager::extractIntegerValue(const QByteArray &rawFrame,char startLimiter, char endLimiter){
 
-    QByteArray payload = stripFrameDelimiter(rawFrame,startLimiter,endLimiter);
-    QString valuestr=QString::fromUtf8(payload);
-    bool ok = false;
-    int value = valuestr.toInt(&ok);
+    FrameView payload = stripFrameDelimiterView(rawFrame,startLimiter,endLimiter);
+    if (!payload.isValid())
+        qCritical() << "No Valid Packet"<<endl;
 
-    if (!ok)
+    int value = 0;
+    if (!extractIntegerValue(rawFrame,payload,&value))
     {
-        qDebug() << "Failed to convert to integer:" << valuestr;
+        qDebug() << "Failed to convert to integer:" << rawFrame.mid(payload.offset,payload.length);
         return -1;
     }
 
@@ -148,23 +326,86 @@ int CommManager::extractIntegerValue(const QByteArray &rawFrame,char startLimite
 
 //extract intiger from packet with seperator
 QList<int> CommManager::extractIntegerValue(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator){
-    QList<QByteArray> list=stripFrameDelimiter(rawFrame,startLimiter,endLimiter,seperator);
+    QVector<FrameView> fields;
+    if(stripFrameDelimiterViews(rawFrame,startLimiter,endLimiter,seperator,fields)==0)
+        qCritical() << "No Valid Packet"<<endl;
+
     QList<int> values;
-    for (const QByteArray &val:list) {
-        bool ok = false;
-        int value = QString::fromUtf8(val).toInt(&ok);
-        if (ok)
+    for (const FrameView &field:fields) {
+        int value = 0;
+        if (extractIntegerValue(rawFrame,field,&value))
         {
             values.append(value);
         }
         else
         {
-            qDebug() << "Invalid integer conversion for:" << val;
+            qDebug() << "Invalid integer conversion for:" << rawFrame.mid(field.offset,field.length);
         }
     }
     return values;
 }
 
+//parse a decimal integer straight from bytes, optional surrounding whitespace and sign
+bool CommManager::parseInteger(const char *data, int size, int *value){
+    if(!data || size<=0)
+        return false;
+
+    int i=0;
+    while(i<size && (data[i]==' '||(data[i]>='\t'&&data[i]<='\r')))i++;
+    while(size>i && (data[size-1]==' '||(data[size-1]>='\t'&&data[size-1]<='\r')))size--;
+
+    bool negative=false;
+    if(i<size && (data[i]=='-'||data[i]=='+')){
+        negative=data[i]=='-';
+        i++;
+    }
+    if(i>=size)
+        return false;
+
+    //accumulate the magnitude in 64 bits, a negative value may go one past INT_MAX to reach INT_MIN
+    const qint64 limit=negative ? 2147483648LL : 2147483647LL;
+    qint64 result=0;
+    for(;i<size;i++){
+        const char c=data[i];
+        if(c<'0'||c>'9')
+            return false;
+        result=result*10+(c-'0');
+        if(result>limit)
+            return false;
+    }
+    if(value)
+        *value=static_cast<int>(negative ? -result : result);
+    return true;
+}
+
+//integer value of a frame or field view
+bool CommManager::extractIntegerValue(const QByteArray &buffer,const FrameView &view,int *value){
+    if(!view.isValid() || view.offset+view.length>buffer.size())
+        return false;
+    return parseInteger(view.data(buffer),view.length,value);
+}
+
+//all integer fields of a packet with seperator, invalid fields are skipped
+int CommManager::extractIntegerValues(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator,QVector<int> &values){
+    values.clear();
+    FrameView payload=stripFrameDelimiterView(rawFrame,startLimiter,endLimiter);
+    if(!payload.isValid())
+        return 0;
+
+    const char *p=rawFrame.constData();
+    const int end=payload.offset+payload.length;
+    int fieldStart=payload.offset;
+    while(fieldStart<=end){
+        int hit=ByteScan::indexOf(p+fieldStart,end-fieldStart,seperator);
+        int fieldEnd=hit==-1 ? end : fieldStart+hit;
+        int value=0;
+        if(parseInteger(p+fieldStart,fieldEnd-fieldStart,&value))
+            values.append(value);
+        fieldStart=fieldEnd+1;
+    }
+    return values.size();
+}
+
 //convert bytes to int
 int CommManager::bytesToInt(const QByteArray &data, bool littleEndian, bool sign){
 
@@ -173,34 +414,21 @@ int CommManager::bytesToInt(const QByteArray &data, bool littleEndian, bool sign
         return 0;
     }
 
-    QDataStream ds(data);
-    ds.setByteOrder(littleEndian ? QDataStream::LittleEndian : QDataStream::BigEndian);
-
+    // Assemble directly from the bytes, no stream object per value
+    const uchar *p = reinterpret_cast<const uchar *>(data.constData());
+    const int size = data.size();
     quint32 value = 0;
-
-    // Read according to size
-    switch (data.size()) {
-        case 1: { quint8 v; ds >> v; value = v; break; }
-        case 2: { quint16 v; ds >> v; value = v; break; }
-        case 3: {
-            // No native 24-bit type, read manually
-            quint8 b1, b2, b3;
-            ds >> b1 >> b2 >> b3;
-            if (littleEndian)
-                value = b1 | (b2 << 8) | (b3 << 16);
-            else
-                value = (b1 << 16) | (b2 << 8) | b3;
-            break;
-        }
-        case 4: { quint32 v; ds >> v; value = v; break; }
+    for (int i = 0; i < size; ++i) {
+        const uchar b = littleEndian ? p[size - 1 - i] : p[i];
+        value = (value << 8) | b;
     }
 
     // Handle signed conversion
     if (sign) {
-        switch (data.size()) {
+        switch (size) {
             case 1: return static_cast<qint8>(value);
             case 2: return static_cast<qint16>(value);
-            case 3: return static_cast<qint32>((value << 8) >> 8); // sign extend 24-bit
+            case 3: return static_cast<qint32>(value << 8) >> 8; // sign extend 24-bit
             case 4: return static_cast<qint32>(value);
         }
     }
@@ -216,15 +444,14 @@ QByteArray CommManager::intToBytes(int value, int size, bool littleEndian){
         return QByteArray();
     }
 
-    QByteArray data;
-    data.resize(size);
-
-    for (int i = 0; i < size; ++i) {
-        int shift = littleEndian ? i * 8 : (size - 1 - i) * 8;
-        data[i] = static_cast<char>((value >> shift) & 0xFF);
+    // Low "size" bytes of the value in the requested order
+    uchar bytes[4];
+    if (littleEndian) {
+        qToLittleEndian(static_cast<quint32>(value), bytes);
+        return QByteArray(reinterpret_cast<const char *>(bytes), size);
     }
-
-    return data;
+    qToBigEndian(static_cast<quint32>(value), bytes);
+    return QByteArray(reinterpret_cast<const char *>(bytes) + 4 - size, size);
 }
 
 //convert byte to bits array
@@ -4,8 +4,21 @@
 #include <QObject>
 #include <QBitArray>
 #include <QDebug>
-#include <QDataStream>
+#include <QtEndian>
+#include <QVector>
+#include "crc16.h"
+#include "checksum.h"
+#include "bytestuffing.h"
 
+//position of a frame or field inside the caller's receive buffer, nothing is copied
+struct FrameView
+{
+    int offset = -1;
+    int length = 0;
+
+    bool isValid() const { return offset >= 0; }
+    const char *data(const QByteArray &buffer) const { return buffer.constData() + offset; }
+};
 
 class CommManager : public QObject
 {
@@ -23,9 +36,41 @@ public:
     int extractIntegerValue(const QByteArray &rawFrame,char startLimiter, char endLimiter);
     QList<int> extractIntegerValue(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator);
 
+    //single pass frame writers into a caller owned buffer, the buffer is sized once and its capacity
+    //is reused across calls while it is not shared, returns the frame size or 0 for an invalid payload
+    //out may be the payload itself (or one of the fields), e.g. writeFrame(buf,buf,...) frames buf in place
+    int writeFrame(QByteArray &out,const QByteArray &payload,char startLimiter, char endLimiter,bool withCRC=false);
+    int writeFrame(QByteArray &out,const QList<QByteArray> &payload,char startLimiter, char endLimiter,char seperator,bool withCRC=false);
+    int writeCRCFrame(QByteArray &out,const QByteArray &frame); //frame followed by its crc
+
+    //byte stuffed framing (COBS/SLIP), binary safe alternative to the delimiter frames
+    //withCRC stuffs the checksum of the payload after it
+    QByteArray addStuffedFrame(const QByteArray &payload,ByteStuffing::Mode mode);
+    int writeStuffedFrame(QByteArray &out,const QByteArray &payload,ByteStuffing::Mode mode,bool withCRC=false);
+    QList<QByteArray> splitStuffedFrames(const QByteArray &rawBuffer,ByteStuffing::Mode mode); //decoded payloads
+
+    //view based framing, results point into the passed buffer which must outlive them
+    //output vectors are cleared but keep their capacity, reuse them to decode without allocating
+    FrameView stripFrameDelimiterView(const QByteArray &rawFrame,char startLimiter, char endLimiter);
+    int stripFrameDelimiterViews(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator,QVector<FrameView> &fields);
+    //the same for one frame of a larger buffer, e.g. each view from splitFrameViews
+    FrameView stripFrameDelimiterView(const QByteArray &buffer,const FrameView &frame,char startLimiter, char endLimiter);
+    int stripFrameDelimiterViews(const QByteArray &buffer,const FrameView &frame,char startLimiter, char endLimiter,char seperator,QVector<FrameView> &fields);
+    int splitFrameViews(const QByteArray &rawBuffer,char startLimiter, char endLimiter,QVector<FrameView> &frames);
+    bool parseInteger(const char *data, int size, int *value); //decimal, same rules as QString::toInt
+    bool extractIntegerValue(const QByteArray &buffer,const FrameView &view,int *value);
+    int extractIntegerValues(const QByteArray &rawFrame,char startLimiter, char endLimiter,char seperator,QVector<int> &values);
+
 
     //crc
+    //appendCRC, validateCRC and the frame writers use the selected algorithm (CRC-16/IBM by default),
+    //calculateCRC/updateCRC are always CRC-16/IBM
+    void setChecksumAlgorithm(Checksum::Algorithm algorithm);
+    Checksum::Algorithm checksumAlgorithm() const { return checksumAlgo; }
+    quint32 calculateChecksum(const QByteArray &data);
     quint16 calculateCRC(const QByteArray &data);
+    quint16 calculateCRC(const char *data, int size);
+    quint16 updateCRC(quint16 crc, const QByteArray &data); //incremental, start with Crc16::InitialValue
     bool validateCRC(const QByteArray &frame);
     QByteArray appendCRC(const QByteArray &frame);
 
@@ -41,6 +86,9 @@ public:
 signals:
 
 public slots:
+
+private:
+    Checksum::Algorithm checksumAlgo = Checksum::Algorithm::Crc16Modbus;
 };
 
 #endif // COMMMANAGER_H
@@ -0,0 +1,42 @@
+#include "crc16.h"
+
+constexpr Crc16Table Crc16::lookup;
+
+quint16 Crc16::update(quint16 crc, const char *data, int size)
+{
+    if (!data || size <= 0)
+        return crc;
+
+    const quint16 (*t)[256] = lookup.table;
+    const uchar *p = reinterpret_cast<const uchar *>(data);
+
+    //8 bytes per step, only the first two bytes mix with the running crc
+    while (size >= 8) {
+        crc ^= static_cast<quint16>(p[0] | (p[1] << 8));
+        crc = t[7][crc & 0xFF] ^ t[6][crc >> 8]
+            ^ t[5][p[2]] ^ t[4][p[3]]
+            ^ t[3][p[4]] ^ t[2][p[5]]
+            ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0)
+        crc = static_cast<quint16>((crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF]);
+
+    return crc;
+}
+
+quint16 Crc16::update(quint16 crc, const QByteArray &data)
+{
+    return update(crc, data.constData(), data.size());
+}
+
+quint16 Crc16::compute(const char *data, int size)
+{
+    return update(InitialValue, data, size);
+}
+
+quint16 Crc16::compute(const QByteArray &data)
+{
+    return update(InitialValue, data.constData(), data.size());
+}
@@ -0,0 +1,45 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <QtGlobal>
+#include <QByteArray>
+
+//slice-by-8 lookup tables built by the compiler, table[k][n] is the crc of byte n followed by k zero bytes
+//the single copy of the polynomial tables, FrameCodec reads its slices from here as well
+struct Crc16Table
+{
+    quint16 table[8][256];
+
+    constexpr Crc16Table() : table()
+    {
+        for (int n = 0; n < 256; ++n) {
+            quint16 crc = static_cast<quint16>(n);
+            for (int i = 0; i < 8; ++i)
+                crc = (crc & 0x0001) ? static_cast<quint16>((crc >> 1) ^ 0xA001) : static_cast<quint16>(crc >> 1);
+            table[0][n] = crc;
+        }
+        for (int n = 0; n < 256; ++n) {
+            for (int k = 1; k < 8; ++k)
+                table[k][n] = static_cast<quint16>((table[k - 1][n] >> 8) ^ table[0][table[k - 1][n] & 0xFF]);
+        }
+    }
+};
+
+//table driven CRC-16/IBM (poly 0xA001 reflected, init 0xFFFF) as used by Modbus RTU
+//update() can be called repeatedly while bytes arrive, feed the result back as state
+class Crc16
+{
+public:
+    static const quint16 InitialValue = 0xFFFF;
+    static constexpr Crc16Table lookup{};
+
+    static quint16 update(quint16 crc, const char *data, int size);
+    static quint16 update(quint16 crc, const QByteArray &data);
+    static quint16 compute(const char *data, int size);
+    static quint16 compute(const QByteArray &data);
+
+private:
+    Crc16() {}
+};
+
+#endif // CRC16_H
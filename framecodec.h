@@ -0,0 +1,216 @@
+#ifndef FRAMECODEC_H
+#define FRAMECODEC_H
+
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+#include <cstring>
+#include "commmanager.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+//compile time specialised framing for protocols fixed at build time, e.g.
+//    typedef FrameCodec<'$', '#', ','> PlcCodec;
+//    PlcCodec::split(buffer, frames);
+//same frame layout as the CommManager helpers, which stay the runtime configurable path
+
+//framing descriptor, available as FrameCodec<...>::format
+struct FrameFormat
+{
+    char startLimiter;
+    char endLimiter;
+    char seperator; //'\0' when frames carry a single payload
+};
+
+template<char Start, char End, char Seperator = '\0'>
+class FrameCodec
+{
+public:
+    static_assert(Start != End, "start and end delimiter must differ");
+    static_assert(Seperator != Start && Seperator != End, "seperator must differ from the delimiters");
+
+    static constexpr FrameFormat format = { Start, End, Seperator };
+    static constexpr bool hasSeperator = Seperator != '\0';
+
+    //encoding ---------------------------
+    static constexpr int encodedSize(int payloadSize) { return payloadSize + 2; }
+
+    static void encode(const char *payload, int size, QByteArray &out)
+    {
+        out.resize(encodedSize(size));
+        char *p = out.data();
+        p[0] = Start;
+        std::memcpy(p + 1, payload, static_cast<size_t>(size));
+        p[size + 1] = End;
+    }
+
+    static QByteArray encode(const QByteArray &payload)
+    {
+        QByteArray out;
+        encode(payload.constData(), payload.size(), out);
+        return out;
+    }
+
+    //start, then seperator before each field, then end, like CommManager::addFrameDelimiter
+    static void encode(const QList<QByteArray> &fields, QByteArray &out)
+    {
+        static_assert(hasSeperator, "field encoding needs a seperator");
+        int size = 2;
+        for (const QByteArray &field : fields)
+            size += field.size() + 1;
+        out.resize(size);
+        char *p = out.data();
+        *p++ = Start;
+        for (const QByteArray &field : fields) {
+            *p++ = Seperator;
+            std::memcpy(p, field.constData(), static_cast<size_t>(field.size()));
+            p += field.size();
+        }
+        *p = End;
+    }
+
+    static QByteArray encode(const QList<QByteArray> &fields)
+    {
+        QByteArray out;
+        encode(fields, out);
+        return out;
+    }
+
+    //decoding ---------------------------
+    //complete frames in the buffer (delimiters included), a new start byte restarts the frame
+    static int split(const char *data, int size, QVector<FrameView> &frames)
+    {
+        frames.clear();
+        int start = -1;
+        int i = 0;
+        int hit;
+        while (i < size && (hit = findDelimiter(data + i, size - i)) != -1) {
+            i += hit;
+            if (data[i] == Start) {
+                start = i;
+            } else if (start != -1) {
+                FrameView frame;
+                frame.offset = start;
+                frame.length = i - start + 1;
+                frames.append(frame);
+                start = -1;
+            }
+            ++i;
+        }
+        return frames.size();
+    }
+
+    static int split(const QByteArray &buffer, QVector<FrameView> &frames)
+    {
+        return split(buffer.constData(), buffer.size(), frames);
+    }
+
+    //payload between the first start and end byte
+    static FrameView payload(const char *data, int size)
+    {
+        FrameView view;
+        const void *start = std::memchr(data, static_cast<unsigned char>(Start), static_cast<size_t>(size));
+        const void *end = std::memchr(data, static_cast<unsigned char>(End), static_cast<size_t>(size));
+        if (!start || !end || end < start)
+            return view;
+        view.offset = static_cast<int>(static_cast<const char *>(start) - data) + 1;
+        view.length = static_cast<int>(static_cast<const char *>(end) - data) - view.offset;
+        return view;
+    }
+
+    static FrameView payload(const QByteArray &frame)
+    {
+        return payload(frame.constData(), frame.size());
+    }
+
+    //field positions of the payload, same split as CommManager::stripFrameDelimiterViews
+    static int fields(const char *data, int size, QVector<FrameView> &out)
+    {
+        static_assert(hasSeperator, "field decoding needs a seperator");
+        out.clear();
+        const FrameView body = payload(data, size);
+        if (!body.isValid())
+            return 0;
+        FrameView field;
+        field.offset = body.offset;
+        const int end = body.offset + body.length;
+        for (int i = body.offset; i < end; ++i) {
+            if (data[i] == Seperator) {
+                field.length = i - field.offset;
+                out.append(field);
+                field.offset = i + 1;
+            }
+        }
+        field.length = end - field.offset;
+        out.append(field);
+        return out.size();
+    }
+
+    static int fields(const QByteArray &frame, QVector<FrameView> &out)
+    {
+        return fields(frame.constData(), frame.size(), out);
+    }
+
+    //crc ---------------------------
+    static quint16 crc(const char *data, int size, quint16 crc = 0xFFFF)
+    {
+        const auto &t = Crc16::lookup.table; // the shared slice-by-8 CRC-16/IBM tables, same steps as Crc16::update
+        const uchar *p = reinterpret_cast<const uchar *>(data);
+        while (size >= 8) {
+            crc ^= static_cast<quint16>(p[0] | (p[1] << 8));
+            crc = t[7][crc & 0xFF] ^ t[6][crc >> 8] ^ t[5][p[2]] ^ t[4][p[3]]
+                ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+            crc = static_cast<quint16>((crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF]);
+        return crc;
+    }
+
+    static void appendCrc(QByteArray &frame)
+    {
+        const quint16 value = crc(frame.constData(), frame.size());
+        frame.append(static_cast<char>(value & 0xFF));
+        frame.append(static_cast<char>((value >> 8) & 0xFF));
+    }
+
+    static bool validateCrc(const char *frame, int size)
+    {
+        if (size < 3)
+            return false;
+        const quint16 inFrame = static_cast<quint8>(frame[size - 2]) | (static_cast<quint8>(frame[size - 1]) << 8);
+        return crc(frame, size - 2) == inFrame;
+    }
+
+private:
+    //first start or end byte, the constants are folded into the compare vectors
+    static int findDelimiter(const char *data, int size)
+    {
+        int i = 0;
+#if defined(__SSE2__)
+        const __m128i vs = _mm_set1_epi8(Start);
+        const __m128i ve = _mm_set1_epi8(End);
+        for (; i + 16 <= size; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            const int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(x, vs), _mm_cmpeq_epi8(x, ve)));
+            if (mask)
+                return i + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+#endif
+        for (; i < size; ++i) {
+            if (data[i] == Start || data[i] == End)
+                return i;
+        }
+        return -1;
+    }
+
+    FrameCodec() {}
+};
+
+template<char Start, char End, char Seperator>
+constexpr FrameFormat FrameCodec<Start, End, Seperator>::format;
+
+#endif // FRAMECODEC_H
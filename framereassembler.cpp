@@ -0,0 +1,74 @@
+#include "framereassembler.h"
+#include <QDebug>
+
+FrameReassembler::FrameReassembler(char startLimiter, char endLimiter, int maxFrameSize, QObject *parent)
+    : QObject(parent),
+      startByte(startLimiter),
+      endByte(endLimiter),
+      maxSize(maxFrameSize > 1 ? maxFrameSize : 2)
+{
+
+}
+FrameReassembler::~FrameReassembler(){
+
+}
+
+//scan only the new bytes, each byte of the stream is looked at once
+QList<QByteArray> FrameReassembler::feed(const QByteArray &chunk){
+    QList<QByteArray> frames;
+    const char *p = chunk.constData();
+    const int n = chunk.size();
+    int segStart = inFrame ? 0 : -1; //start of the current frame inside this chunk
+
+    for (int i = 0; i < n; ++i) {
+        const char c = p[i];
+        if (c == startByte) {
+            //a new start byte restarts the frame, same as splitFrames
+            pending.clear();
+            inFrame = true;
+            segStart = i;
+        } else if (inFrame && c == endByte && pending.size() + (i - segStart + 1) <= maxSize) {
+            QByteArray frame;
+            if (pending.isEmpty()) {
+                frame = QByteArray(p + segStart, i - segStart + 1);
+            } else {
+                frame = pending;
+                frame.append(p + segStart, i - segStart + 1);
+                pending.clear();
+            }
+            inFrame = false;
+            segStart = -1;
+            frames.append(frame);
+            emit frameReady(frame);
+        } else if (inFrame && pending.size() + (i - segStart + 1) > maxSize) { //the end byte counts as well
+            int dropped = pending.size() + (i - segStart + 1);
+            qWarning() << "Frame exceeded" << maxSize << "bytes without end delimiter, dropped";
+            pending.clear();
+            inFrame = false;
+            segStart = -1;
+            emit frameDropped(dropped);
+        }
+    }
+
+    if (inFrame)
+        pending.append(p + segStart, n - segStart);
+
+    return frames;
+}
+
+void FrameReassembler::reset(){
+    pending.clear();
+    inFrame = false;
+}
+
+void FrameReassembler::setDelimiters(char startLimiter, char endLimiter){
+    startByte = startLimiter;
+    endByte = endLimiter;
+    reset();
+}
+
+void FrameReassembler::setMaxFrameSize(int maxFrameSize){
+    maxSize = maxFrameSize > 1 ? maxFrameSize : 2;
+    if (pending.size() > maxSize)
+        reset();
+}
@@ -0,0 +1,39 @@
+#ifndef FRAMEREASSEMBLER_H
+#define FRAMEREASSEMBLER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+
+//per connection frame reassembler, accepts chunks as they are read and keeps the partial tail
+//between calls, frames use the same start/end delimiter scheme as CommManager::splitFrames
+class FrameReassembler : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FrameReassembler(char startLimiter, char endLimiter, int maxFrameSize = 4096, QObject *parent = nullptr);
+    ~FrameReassembler();
+
+    QList<QByteArray> feed(const QByteArray &chunk); //returns the complete frames and emits frameReady for each
+    void reset(); //drop any partial frame
+
+    void setDelimiters(char startLimiter, char endLimiter);
+    void setMaxFrameSize(int maxFrameSize);
+    int maxFrameSize() const { return maxSize; }
+    char startLimiter() const { return startByte; }
+    char endLimiter() const { return endByte; }
+    int pendingBytes() const { return pending.size(); }
+
+signals:
+    void frameReady(const QByteArray &frame);
+    void frameDropped(int size); //partial frame grew past maxFrameSize without an end byte
+
+private:
+    QByteArray pending; //partial frame carried over from previous chunks, starts with startLimiter
+    bool inFrame = false;
+    char startByte;
+    char endByte;
+    int maxSize;
+};
+
+#endif // FRAMEREASSEMBLER_H
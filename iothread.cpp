@@ -0,0 +1,62 @@
+#include "iothread.h"
+#include <QDebug>
+
+IoThread::IoThread(const QString &name, QObject *parent) : QObject(parent)
+{
+    worker = new QThread(this);
+    worker->setObjectName(name);
+    context = new QObject();
+    context->moveToThread(worker);
+}
+
+IoThread::~IoThread()
+{
+    stop();
+    delete context;
+}
+
+void IoThread::start()
+{
+    if (!worker->isRunning())
+        worker->start();
+}
+
+void IoThread::stop()
+{
+    if (!worker->isRunning())
+        return;
+    if (QThread::currentThread() == worker) {
+        qCritical() << "IoThread::stop() called from the I/O thread itself";
+        return;
+    }
+
+    //objects are pushed back from the thread they live on, their sockets and notifiers move with them
+    QThread *target = QThread::currentThread();
+    QMetaObject::invokeMethod(context, [this, target]() {
+        for (const QPointer<QObject> &obj : attached) {
+            if (obj && obj->thread() == worker)
+                obj->moveToThread(target);
+        }
+        context->moveToThread(target);
+    }, Qt::BlockingQueuedConnection);
+    attached.clear();
+
+    worker->quit();
+    worker->wait();
+    context->moveToThread(worker); //ready for the next start()
+}
+
+bool IoThread::attach(QObject *transport)
+{
+    if (!transport || transport->parent()) {
+        qWarning() << "IoThread::attach needs an object without parent";
+        return false;
+    }
+    if (transport->thread() != QThread::currentThread()) {
+        qWarning() << "IoThread::attach must be called from the object's thread";
+        return false;
+    }
+    transport->moveToThread(worker);
+    attached.append(transport);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef IOTHREAD_H
+#define IOTHREAD_H
+
+#include <QObject>
+#include <QThread>
+#include <QPointer>
+#include <QList>
+#include <QString>
+#include <utility>
+
+//dedicated I/O thread for transports (Tcp, Serial, Modbus), keeps socket and serial reads
+//independent of the GUI event loop. Attached objects live on this thread, so their methods
+//must be called through post()/postBlocking() and their signals reach other threads queued.
+class IoThread : public QObject
+{
+    Q_OBJECT
+public:
+    explicit IoThread(const QString &name = QString("CommIo"), QObject *parent = nullptr);
+    ~IoThread();
+
+    void start();
+    void stop(); //hands attached objects back to the calling thread, then ends the thread
+    bool isRunning() const { return worker->isRunning(); }
+
+    bool attach(QObject *transport); //object must have no parent and live on the calling thread
+    QThread *ioThread() const { return worker; }
+
+    //run f on the I/O thread
+    template<typename F>
+    void post(F &&f) { QMetaObject::invokeMethod(context, std::forward<F>(f), Qt::QueuedConnection); }
+    template<typename F>
+    void postBlocking(F &&f)
+    {
+        if (QThread::currentThread() == worker)
+            f();
+        else
+            QMetaObject::invokeMethod(context, std::forward<F>(f), Qt::BlockingQueuedConnection);
+    }
+
+private:
+    QThread *worker = nullptr;
+    QObject *context = nullptr; //lives on worker, target for posted calls
+    QList<QPointer<QObject>> attached;
+};
+
+#endif // IOTHREAD_H
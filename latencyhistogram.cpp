@@ -0,0 +1,44 @@
+#include "latencyhistogram.h"
+
+void LatencyHistogram::record(qint64 us) {
+    if (us < 0)
+        us = 0; // clock steps cannot happen on a monotonic clock, rounding can
+    int index = 0;
+    for (quint64 v = static_cast<quint64>(us); v && index < BucketCount - 1; v >>= 1)
+        ++index;
+    ++buckets[index];
+    if (!samples || us < minimum)
+        minimum = us;
+    if (us > maximum)
+        maximum = us;
+    sum += us;
+    ++samples;
+}
+
+void LatencyHistogram::reset() {
+    for (quint64 &b : buckets)
+        b = 0;
+    samples = 0;
+    sum = 0;
+    minimum = 0;
+    maximum = 0;
+}
+
+qint64 LatencyHistogram::percentileUs(double percentile) const {
+    if (!samples)
+        return 0;
+    const quint64 rank = static_cast<quint64>(qBound(0.0, percentile, 100.0) / 100.0 * (samples - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank)
+            return qMin(bucketUpperUs(i), maximum);
+    }
+    return maximum;
+}
+
+QString LatencyHistogram::toString() const {
+    return QString("n=%1 min=%2 mean=%3 p50=%4 p99=%5 max=%6")
+            .arg(samples).arg(minUs()).arg(meanUs())
+            .arg(percentileUs(50.0)).arg(percentileUs(99.0)).arg(maxUs());
+}
@@ -0,0 +1,36 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <QString>
+
+//fixed power-of-two histogram of microsecond samples, recording is a few integer ops and never
+//allocates. bucket 0 holds samples below 1 us, bucket i holds [2^(i-1), 2^i) us and the last
+//bucket everything from about 18 minutes up. percentiles are upper bucket bounds, so within 2x.
+class LatencyHistogram
+{
+public:
+    enum { BucketCount = 32 };
+
+    void record(qint64 us);
+    void reset();
+
+    quint64 count() const { return samples; }
+    qint64 minUs() const { return samples ? minimum : 0; }
+    qint64 maxUs() const { return maximum; }
+    qint64 meanUs() const { return samples ? sum / static_cast<qint64>(samples) : 0; }
+    qint64 percentileUs(double percentile) const; // e.g. 99.0
+    quint64 bucket(int index) const { return index >= 0 && index < BucketCount ? buckets[index] : 0; }
+    static qint64 bucketUpperUs(int index) { return index <= 0 ? 1 : qint64(1) << index; }
+
+    QString toString() const; // one line, "n=.. min=.. mean=.. p50=.. p99=.. max=.." in us
+
+private:
+    quint64 buckets[BucketCount] = {};
+    quint64 samples = 0;
+    qint64 sum = 0;
+    qint64 minimum = 0;
+    qint64 maximum = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -11,32 +11,48 @@ MainWindow::MainWindow(QWidget *parent) :
 //    connect(plc,&PlcComm::dataReady,this,&MainWindow::on_dataRecived);
 
     serial=new Serial();
-    connect(serial,&Serial::dataReady,this,&MainWindow::on_dataRecived);
     tcp=new Tcp();
-    connect(tcp,&Tcp::dataReady,this,&MainWindow::on_dataRecived);
     modbus=new Modbus();
-    connect(modbus,&Modbus::dataReady,this,&MainWindow::on_dataRecived);
+
+    // I/O runs off the GUI thread, received data goes through one lock-free channel and a burst
+    // costs one queued event; all three transports share the I/O thread, the channel's single producer
+    rxChannel=new RxChannel(RxChannel::DeliveryMode::QueuedSignal,1024,this);
+    rxChannel->attach(serial);
+    rxChannel->attach(tcp);
+    rxChannel->attach(modbus);
+    connect(rxChannel,&RxChannel::dataReady,this,&MainWindow::on_dataRecived);
+
+    ioThread=new IoThread("CommIo",this);
+    ioThread->attach(serial);
+    ioThread->attach(tcp);
+    ioThread->attach(modbus);
+    ioThread->start();
 }
 
 MainWindow::~MainWindow()
 {
+    ioThread->stop(); // transports come back to this thread and can be deleted here
+    delete serial;
+    delete tcp;
+    delete modbus;
     delete ui;
 }
 
 void MainWindow::on_btnSendData_clicked(){
 
-    QString data=ui->inputText->text();
+    QByteArray data=ui->inputText->text().toUtf8();
     QString regType=ui->regType->currentText();
+    int startAddr=ui->strtAddr->text().toInt();
 
     if(ui->comboBox->currentText()==QString("Serial"))
-        serial->sendData(data.toUtf8());
+        ioThread->post([=]{ serial->sendData(data); });
     if(ui->comboBox->currentText()==QString("TCP"))
-        tcp->sendData(data.toUtf8());
+        ioThread->post([=]{ tcp->sendData(data); });
     else if(ui->comboBox->currentText()==QString("Modbus RTU") ||ui->comboBox->currentText()==QString("Modbus TCP")){
         if(regType==QString("Coil (r/w)"))
-            modbus->sendData(data.toUtf8(),Modbus::RegisterType::Coils,ui->strtAddr->text().toInt());
+            ioThread->post([=]{ modbus->sendData(data,Modbus::RegisterType::Coils,startAddr); });
         if(regType==QString("Holding Register (r/w)"))
-            modbus->sendData(data.toUtf8(),Modbus::RegisterType::HoldingRegisters,ui->strtAddr->text().toInt());}
+            ioThread->post([=]{ modbus->sendData(data,Modbus::RegisterType::HoldingRegisters,startAddr); });}
 
 
 }
@@ -49,19 +65,19 @@ void MainWindow::on_dataRecived(QByteArray data){
 
 
 void MainWindow::on_btnOpenPort_clicked(){
-    QString port= ui->portname->text();
+    std::string port= ui->portname->text().toStdString();
     int ipport=ui->portNo->text().toInt();
     if(ui->comboBox->currentText()==QString("Serial"))
-    serial->connectDevice(port.toStdString());
+    ioThread->post([=]{ serial->connectDevice(port); });
 
     if(ui->comboBox->currentText()==QString("TCP"))
-    tcp->connectDevice(port.toStdString(),ipport);
+    ioThread->post([=]{ tcp->connectDevice(port,ipport); });
 
     if(ui->comboBox->currentText()==QString("Modbus RTU"))
-    modbus->connectDevice(Modbus::ModbusRtu::RTU,port.toStdString(),ipport);
+    ioThread->post([=]{ modbus->connectDevice(Modbus::ModbusRtu::RTU,port,ipport); });
 
     if(ui->comboBox->currentText()==QString("Modbus TCP"))
-    modbus->connectDevice(Modbus::ModbusTcp::TCP,port.toStdString(),ipport);
+    ioThread->post([=]{ modbus->connectDevice(Modbus::ModbusTcp::TCP,port,ipport); });
 
 
 
@@ -73,11 +89,11 @@ void MainWindow::on_btnClose_clicked()
     QString port= ui->portname->text();
 
     if(ui->comboBox->currentText()==QString("Serial"))
-    serial->disconnectDevice();
+    ioThread->post([=]{ serial->disconnectDevice(); });
     if(ui->comboBox->currentText()==QString("TCP"))
-    tcp->disconnectDevice();
+    ioThread->post([=]{ tcp->disconnectDevice(); });
     if(ui->comboBox->currentText()==QString("Modbus RTU") ||ui->comboBox->currentText()==QString("Modbus TCP"))
-    modbus->disconnectDevice();
+    ioThread->post([=]{ modbus->disconnectDevice(); });
 
 
 }
@@ -85,14 +101,15 @@ void MainWindow::on_btnClose_clicked()
 void MainWindow::on_btnReq_clicked()
 {
     QString regType=ui->regType->currentText();
+    int startAddr=ui->strtAddr->text().toInt();
     if(regType==QString("Coil (r/w)"))
-        modbus->readModbusData(Modbus::RegisterType::Coils,ui->strtAddr->text().toInt(),5,1);
+        ioThread->post([=]{ modbus->readModbusData(Modbus::RegisterType::Coils,startAddr,5,1); });
     if(regType==QString("Holding Register (r/w)"))
-        modbus->readModbusData(Modbus::RegisterType::HoldingRegisters,ui->strtAddr->text().toInt(),1,1);
+        ioThread->post([=]{ modbus->readModbusData(Modbus::RegisterType::HoldingRegisters,startAddr,1,1); });
     if(regType==QString("Discreet Inputs (read only)"))
-        modbus->readModbusData(Modbus::RegisterType::DiscreteInputs,ui->strtAddr->text().toInt(),1,1);
+        ioThread->post([=]{ modbus->readModbusData(Modbus::RegisterType::DiscreteInputs,startAddr,1,1); });
     if(regType==QString("Input Register (read only)"))
-        modbus->readModbusData(Modbus::RegisterType::InputRegisters,ui->strtAddr->text().toInt(),1,1);
+        ioThread->post([=]{ modbus->readModbusData(Modbus::RegisterType::InputRegisters,startAddr,1,1); });
 }
 
 
@@ -10,6 +10,8 @@
 #include "modbus.h"
 #include "tcp.h"
 #include "serial.h"
+#include "iothread.h"
+#include "rxchannel.h"
 using namespace std;
 
 
@@ -30,6 +32,8 @@ public:
     Serial *serial=nullptr;
     Tcp *tcp=nullptr;
     Modbus *modbus=nullptr;
+    IoThread *ioThread=nullptr; // serial/tcp/modbus live here, call them through ioThread->post()
+    RxChannel *rxChannel=nullptr; // their received data, delivered on the GUI thread
 
 private slots:
     void on_btnSendData_clicked();
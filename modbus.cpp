@@ -1,13 +1,17 @@
 
 #include "modbus.h"
+#include <QMetaMethod>
 
 Modbus::Modbus(QObject *parent) : QObject(parent)
 {
+    qRegisterMetaType<Modbus::RegisterType>("Modbus::RegisterType"); // also for SIGNAL()/SLOT() string connections
+    traceLink = PacketTrace::registerLink("modbus");
 }
 
 Modbus::~Modbus()
 {
     disconnectDevice();
+    PacketTrace::unregisterLink(traceLink);
 }
 
 // Note: Default parameters are only in the header file
@@ -33,6 +37,12 @@ bool Modbus::connectDevice(
                 qCritical() << "Modbus RTU requires a port name!";
                 return false;
             }
+            if (rs485.enabled) {
+                QString error;
+                if (!rs485.applyToPort(QString::fromStdString(port), &error))
+                    qWarning() << "Kernel RS-485 mode not available on" << QString::fromStdString(port) << ":" << error
+                               << ", the transceiver must switch direction by itself";
+            }
             auto modbusMaster = new QModbusRtuSerialMaster(this);
             modbusMaster->setConnectionParameter(QModbusDevice::SerialPortNameParameter, QString::fromStdString(port));
             modbusMaster->setConnectionParameter(QModbusDevice::SerialParityParameter, static_cast<int>(parity));
@@ -40,6 +50,7 @@ bool Modbus::connectDevice(
             modbusMaster->setConnectionParameter(QModbusDevice::SerialDataBitsParameter, static_cast<int>(dataBits));
             modbusMaster->setConnectionParameter(QModbusDevice::SerialStopBitsParameter, static_cast<int>(stopBits));
             modbusClient = modbusMaster;
+            PacketTrace::setLinkName(traceLink, "modbus-rtu " + QString::fromStdString(port));
 
             modbusClient->setTimeout(timeoutMs);
             modbusClient->setNumberOfRetries(retries);
@@ -93,6 +104,7 @@ bool Modbus::connectDevice(
             modbusMaster->setConnectionParameter(QModbusDevice::NetworkAddressParameter, QString::fromStdString(ip));
             modbusMaster->setConnectionParameter(QModbusDevice::NetworkPortParameter, tcpPort);
             modbusClient = modbusMaster;
+            PacketTrace::setLinkName(traceLink, QString("modbus-tcp %1:%2").arg(QString::fromStdString(ip)).arg(tcpPort));
         }
 
         modbusClient->setTimeout(timeoutMs);
@@ -127,6 +139,7 @@ void Modbus::disconnectDevice() {
                 delete modbusClient;
                 modbusClient = nullptr;
             }
+            bitSnapshots.clear(); // edges are relative to reads on this connection
 
     } catch (...) {
         qCritical() << "Exception in disconnectDevice()";
@@ -154,14 +167,15 @@ void Modbus::sendData(const QByteArray &data,RegisterType registerType,int start
 //                        writeUnit.setValue(i, static_cast<quint8>(data.at(i)) != 0);
                       writeUnit.setValue(i, (static_cast<quint8>(data.at(i)) & 0x01) != 0);
             } else { // Holding registers
-                for (int i = 0, j = 0; i < data.size(); i += 2, ++j) {
-                    quint16 value = static_cast<quint8>(data.at(i));
-                    if (i + 1 < data.size())
-                        value = (value << 8) | static_cast<quint8>(data.at(i + 1));
-                    writeUnit.setValue(j, value);
-                }
+                QVector<quint16> values(count);
+                RegisterConvert::bytesToRegisters(data.constData(), data.size() / 2, values.data());
+                if (data.size() % 2)
+                    values[count - 1] = static_cast<quint8>(data.at(data.size() - 1)); // odd trailing byte
+                writeUnit.setValues(values);
             }
 
+            PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+
             // Send request
             if (auto *reply = modbusClient->sendWriteRequest(writeUnit, modbusSlaveId)) {
                 if (!reply->isFinished()) {
@@ -206,15 +220,22 @@ bool Modbus::readModbusData(Modbus::RegisterType registerType, int startAddress,
         if (!reply->isFinished()) {
             connect(reply, &QModbusReply::finished, this, [this, reply]() {
                 if (reply->error() == QModbusDevice::NoError) {
+                    static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&Modbus::dataReady);
                     const QModbusDataUnit unit = reply->result();
-                    QByteArray data;
-                    for (const quint16 val : unit.values()) {
-                        // Big-endian conversion
-                        data.append(static_cast<char>((val >> 8) & 0xFF));
-                        data.append(static_cast<char>(val & 0xFF));
+                    const bool bitBlock = unit.registerType() == QModbusDataUnit::Coils || unit.registerType() == QModbusDataUnit::DiscreteInputs;
+                    if (bitBlock)
+                        deliverBits(unit, reply->serverAddress()); // traces the packed bits
+                    // coils as 2 bytes each only for consumers still listening to dataReady
+                    if (!bitBlock || isSignalConnected(dataReadySignal)) {
+                        const QVector<quint16> values = unit.values();
+                        QByteArray data;
+                        data.resize(values.size() * 2);
+                        // Big-endian conversion of the whole block
+                        RegisterConvert::registersToBytes(values.constData(), values.size(), data.data());
+                        if (!bitBlock)
+                            PacketTrace::record(traceLink, PacketTrace::Direction::Rx, data);
+                        emit dataReady(data);// <-- EMIT THE SIGNAL
                     }
-                    qInfo() << "Modbus read successful. Data:" << data.toHex(':');
-                    emit dataReady(data);// <-- EMIT THE SIGNAL
                     emit readReady();
                 } else {
                     qWarning() << "Modbus read error:" << reply->errorString();
@@ -236,6 +257,40 @@ bool Modbus::readModbusData(Modbus::RegisterType registerType, int startAddress,
 }
 
 
+//pack coil/discrete values into bits and report edges against the previous read of the same block
+//on the same slave, several slaves polled over one master each keep their own snapshot
+void Modbus::deliverBits(const QModbusDataUnit &unit, int serverAddress) {
+    const QVector<quint16> values = unit.values();
+    const int count = values.size();
+    if (count == 0)
+        return;
+
+    QByteArray bits;
+    bits.resize(BitPack::byteCount(count));
+    BitPack::pack(values.constData(), count, reinterpret_cast<uchar *>(bits.data()));
+
+    PacketTrace::record(traceLink, PacketTrace::Direction::Rx, bits);
+    const RegisterType type = static_cast<RegisterType>(unit.registerType());
+    emit bitsReady(type, unit.startAddress(), count, bits);
+
+    // type | slave | start address | count, Modbus addresses fit in 8 bits and counts in 16
+    const quint64 key = (quint64(quint8(unit.registerType())) << 56) | (quint64(quint8(serverAddress)) << 48)
+                      | (quint64(quint16(unit.startAddress())) << 32) | quint16(count);
+    auto previous = bitSnapshots.find(key);
+    if (previous != bitSnapshots.end()) {
+        QByteArray changedMask;
+        changedMask.resize(bits.size());
+        const int changedCount = BitPack::changed(reinterpret_cast<const uchar *>(previous->constData()),
+                                                  reinterpret_cast<const uchar *>(bits.constData()),
+                                                  count, reinterpret_cast<uchar *>(changedMask.data()));
+        *previous = bits;
+        if (changedCount > 0)
+            emit bitsChanged(type, unit.startAddress(), count, bits, changedMask);
+    } else {
+        bitSnapshots.insert(key, bits);
+    }
+}
+
 void Modbus::reciveData() {
 //
 
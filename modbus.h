@@ -15,6 +15,12 @@
 #include <QModbusReply>
 #include <QModbusDataUnit>
 
+#include "registerconvert.h"
+#include "bitpack.h"
+#include "packettrace.h"
+#include "serialportoptions.h"
+#include <QHash>
+
 // Standard Library
 #include <string>
 #include <iostream>
@@ -79,6 +85,7 @@ public:
         InputRegisters  = QModbusDataUnit::InputRegisters,
         HoldingRegisters= QModbusDataUnit::HoldingRegisters
     };
+    Q_ENUM(RegisterType) // carried by bitsReady/bitsChanged, which are queued once Modbus runs on an IoThread
 
     bool connectDevice(
                        ModbusRtu mode,
@@ -105,6 +112,9 @@ public:
 
     // Public methods
     void disconnectDevice();
+    // RTU: kernel RS-485 direction control, pushed to the port on the next connectDevice. there is no
+    // software RTS fallback here, QModbusRtuSerialMaster owns the port and its writes
+    void setRs485(const SerialRs485Options &options) { rs485 = options; }
     void sendData(const QByteArray &data,RegisterType registerType=RegisterType::HoldingRegisters,int startAddress=0);
 
     bool readModbusData(RegisterType registerType, int startAddress, int numberOfEntries, int slaveId = -1);
@@ -116,13 +126,24 @@ signals:
     void dataReady(const QByteArray &data);
     void readReady();
     void errorOccurredSignal(const QString &msg);
+    // Coil/discrete input reads as packed bits (BitPack layout)
+    void bitsReady(Modbus::RegisterType registerType, int startAddress, int count, const QByteArray &bits);
+    // Emitted when bits differ from the previous read of the same block, changedMask has a bit set per edge
+    void bitsChanged(Modbus::RegisterType registerType, int startAddress, int count, const QByteArray &bits, const QByteArray &changedMask);
 private slots:
     void reciveData();
 
 private:
+    void deliverBits(const QModbusDataUnit &unit, int serverAddress);
+
     // Pointers to communication objects
     QModbusClient *modbusClient = nullptr;
 
+    // Last packed snapshot per (register type, slave, start address, count)
+    QHash<quint64, QByteArray> bitSnapshots;
+
     int modbusSlaveId = 1;
+    quint16 traceLink; // PacketTrace link id
+    SerialRs485Options rs485;
 };
 #endif // MODBUS_H
@@ -0,0 +1,171 @@
+#include "packettrace.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QVector>
+#include <QDebug>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+//one record, seq is odd while a writer fills it and 2*ticket+2 once it is complete
+struct TraceSlot {
+    std::atomic<quint64> seq{0};
+    quint64 timestampNs = 0;
+    quint32 size = 0;
+    quint16 link = 0;
+    quint8 direction = 0;
+    quint8 captured = 0;
+    char bytes[PacketTrace::CaptureBytes];
+};
+
+TraceSlot traceSlots[PacketTrace::Capacity];
+std::atomic<quint64> traceHead{0}; //next ticket
+std::atomic<quint64> traceBase{0}; //first ticket after the last clear()
+
+QMutex linkMutex;
+QStringList linkNames;
+QVector<bool> linkInUse;
+QList<quint16> freeLinks; //unregistered ids, oldest first so a name stays for dump() as long as possible
+
+quint64 monotonicNs()
+{
+    return static_cast<quint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+}
+
+std::atomic<int> PacketTrace::currentLevel{static_cast<int>(PacketTrace::Level::Off)};
+
+void PacketTrace::setLevel(Level level)
+{
+    currentLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+//ids of unregistered links are handed out again, so reconnecting or re-adding ports never runs out
+quint16 PacketTrace::registerLink(const QString &name)
+{
+    QMutexLocker lock(&linkMutex);
+    if (!freeLinks.isEmpty()) {
+        const quint16 link = freeLinks.takeFirst();
+        linkNames[link] = name;
+        linkInUse[link] = true;
+        return link;
+    }
+    if (linkNames.size() > MaxLink) {
+        qWarning() << "PacketTrace: more than" << MaxLink + 1 << "links registered, sharing the last id";
+        return MaxLink;
+    }
+    linkNames.append(name);
+    linkInUse.append(true);
+    return static_cast<quint16>(linkNames.size() - 1);
+}
+
+//the name stays until the id is reused, records already in the ring still dump with it
+void PacketTrace::unregisterLink(quint16 link)
+{
+    QMutexLocker lock(&linkMutex);
+    if (link >= linkInUse.size() || !linkInUse.at(link) || link == MaxLink)
+        return;
+    linkInUse[link] = false;
+    freeLinks.append(link);
+}
+
+int PacketTrace::linkCount()
+{
+    QMutexLocker lock(&linkMutex);
+    return linkNames.size() - freeLinks.size();
+}
+
+void PacketTrace::setLinkName(quint16 link, const QString &name)
+{
+    QMutexLocker lock(&linkMutex);
+    if (link < linkNames.size() && linkInUse.at(link))
+        linkNames[link] = name;
+}
+
+QString PacketTrace::linkName(quint16 link)
+{
+    QMutexLocker lock(&linkMutex);
+    return link < linkNames.size() ? linkNames.at(link) : QString("link%1").arg(link);
+}
+
+//claim a ticket, fill the slot between two seq stores, readers drop slots whose seq moved
+void PacketTrace::write(quint16 link, Direction direction, const char *data, int size)
+{
+    const quint64 ticket = traceHead.fetch_add(1, std::memory_order_relaxed);
+    TraceSlot &slot = traceSlots[ticket % Capacity];
+
+    slot.seq.store(2 * ticket + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.timestampNs = monotonicNs();
+    slot.size = size > 0 ? static_cast<quint32>(size) : 0;
+    slot.link = link;
+    slot.direction = static_cast<quint8>(direction);
+    int captured = 0;
+    if (size > 0 && data && isEnabled(Level::Bytes)) {
+        captured = size < CaptureBytes ? size : CaptureBytes;
+        std::memcpy(slot.bytes, data, static_cast<size_t>(captured));
+    }
+    slot.captured = static_cast<quint8>(captured);
+
+    slot.seq.store(2 * ticket + 2, std::memory_order_release);
+}
+
+//formatting happens here only, records that are being overwritten while we read are skipped
+QString PacketTrace::dump(int maxRecords)
+{
+    const quint64 head = traceHead.load(std::memory_order_acquire);
+    quint64 first = traceBase.load(std::memory_order_relaxed);
+    if (head - first > static_cast<quint64>(Capacity))
+        first = head - Capacity;
+    if (maxRecords >= 0 && head - first > static_cast<quint64>(maxRecords))
+        first = head - static_cast<quint64>(maxRecords);
+
+    QString out;
+    for (quint64 ticket = first; ticket < head; ++ticket) {
+        const TraceSlot &slot = traceSlots[ticket % Capacity];
+        const quint64 seq = slot.seq.load(std::memory_order_acquire);
+        if (seq != 2 * ticket + 2)
+            continue;
+
+        const quint64 timestampNs = slot.timestampNs;
+        const quint32 size = slot.size;
+        const quint16 link = slot.link;
+        const quint8 direction = slot.direction;
+        const int captured = slot.captured;
+        char bytes[CaptureBytes];
+        std::memcpy(bytes, slot.bytes, static_cast<size_t>(captured));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != seq)
+            continue;
+
+        out += QString("%1.%2 %3 %4 %5 bytes")
+                   .arg(timestampNs / 1000000000ull)
+                   .arg(timestampNs / 1000ull % 1000000ull, 6, 10, QChar('0'))
+                   .arg(linkName(link))
+                   .arg(direction == static_cast<quint8>(Direction::Tx) ? "TX" : "RX")
+                   .arg(size);
+        if (captured > 0) {
+            out += ": ";
+            out += QString::fromLatin1(QByteArray(bytes, captured).toHex(':'));
+            if (static_cast<quint32>(captured) < size)
+                out += "...";
+        }
+        out += '\n';
+    }
+    return out;
+}
+
+void PacketTrace::clear()
+{
+    traceBase.store(traceHead.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+quint64 PacketTrace::recordCount()
+{
+    return traceHead.load(std::memory_order_relaxed) - traceBase.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,59 @@
+#ifndef PACKETTRACE_H
+#define PACKETTRACE_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+
+//process wide packet trace, a fixed lock-free ring of binary records (timestamp, link, direction,
+//first bytes of the packet) written from any I/O thread. nothing is formatted until dump() is called,
+//with the level at Off a record() call is one relaxed atomic load.
+class PacketTrace
+{
+public:
+    enum class Level {
+        Off,     // nothing recorded
+        Summary, // timestamp, link, direction and size
+        Bytes    // as Summary plus the first CaptureBytes bytes of the packet
+    };
+    enum class Direction : quint8 {
+        Rx,
+        Tx
+    };
+
+    enum {
+        Capacity = 4096,   // records kept, older ones are overwritten
+        CaptureBytes = 48, // bytes kept per record at Level::Bytes
+        MaxLink = 0xFFFF   // last link id, shared by everything registered beyond it
+    };
+
+    static void setLevel(Level level);
+    static Level level() { return static_cast<Level>(currentLevel.load(std::memory_order_relaxed)); }
+    static bool isEnabled(Level at = Level::Summary) { return currentLevel.load(std::memory_order_relaxed) >= static_cast<int>(at); }
+
+    static quint16 registerLink(const QString &name); //id used in records, the name is only looked up by dump()
+    static void unregisterLink(quint16 link); //owner is gone, the id is reused by a later registerLink()
+    static int linkCount(); //links currently registered
+    static void setLinkName(quint16 link, const QString &name); //e.g. once the port or peer is known
+    static QString linkName(quint16 link);
+
+    static void record(quint16 link, Direction direction, const char *data, int size)
+    {
+        if (isEnabled())
+            write(link, direction, data, size);
+    }
+    static void record(quint16 link, Direction direction, const QByteArray &data) { record(link, direction, data.constData(), data.size()); }
+
+    static QString dump(int maxRecords = Capacity); //oldest first, one line per record
+    static void clear();
+    static quint64 recordCount(); //records written since start or clear(), including overwritten ones
+
+private:
+    PacketTrace() {}
+    static void write(quint16 link, Direction direction, const char *data, int size);
+
+    static std::atomic<int> currentLevel;
+};
+
+#endif // PACKETTRACE_H
@@ -0,0 +1,42 @@
+#include "reconnectpolicy.h"
+#include <QRandomGenerator>
+
+ReconnectPolicy::ReconnectPolicy(int initialDelayMs, int maxDelayMs, double multiplier, double jitter)
+{
+    setInitialDelayMs(initialDelayMs);
+    setMaxDelayMs(maxDelayMs);
+    setMultiplier(multiplier);
+    setJitter(jitter);
+}
+
+int ReconnectPolicy::delayMs(int attempt) const {
+    double delay = initialMs;
+    for (int i = 0; i < attempt && i < 64 && delay < maxMs; ++i)
+        delay *= factor;
+    if (delay > maxMs)
+        delay = maxMs;
+
+    if (jitterFraction > 0.0) {
+        const double spread = delay * jitterFraction;
+        delay += (QRandomGenerator::global()->generateDouble() * 2.0 - 1.0) * spread;
+        if (delay > maxMs)
+            delay = maxMs; //the cap holds with jitter too, at the cap the spread is one sided
+    }
+    return delay > 0.0 ? static_cast<int>(delay) : 0;
+}
+
+void ReconnectPolicy::setInitialDelayMs(int ms){
+    initialMs = ms > 0 ? ms : 0;
+}
+
+void ReconnectPolicy::setMaxDelayMs(int ms){
+    maxMs = ms > 0 ? ms : 0;
+}
+
+void ReconnectPolicy::setMultiplier(double multiplier){
+    factor = multiplier >= 1.0 ? multiplier : 1.0;
+}
+
+void ReconnectPolicy::setJitter(double jitter){
+    jitterFraction = qBound(0.0, jitter, 1.0);
+}
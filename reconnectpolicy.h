@@ -0,0 +1,35 @@
+#ifndef RECONNECTPOLICY_H
+#define RECONNECTPOLICY_H
+
+#include <QtGlobal>
+
+//exponential backoff with jitter for reconnect attempts
+//  delay(n) = min(initialDelay * multiplier^n, maxDelay), spread by +-jitter*delay, never above maxDelay
+//the first retry comes quickly so a short flap recovers fast, a long outage settles at maxDelay
+//and the jitter keeps many links from retrying in lockstep
+class ReconnectPolicy
+{
+public:
+    explicit ReconnectPolicy(int initialDelayMs = 100, int maxDelayMs = 30000, double multiplier = 2.0, double jitter = 0.2);
+
+    static ReconnectPolicy fixed(int delayMs) { return ReconnectPolicy(delayMs, delayMs, 1.0, 0.0); }
+
+    int delayMs(int attempt) const; //attempt 0 is the first retry after the link went down
+
+    int initialDelayMs() const { return initialMs; }
+    int maxDelayMs() const { return maxMs; }
+    double multiplier() const { return factor; }
+    double jitter() const { return jitterFraction; }
+    void setInitialDelayMs(int ms);
+    void setMaxDelayMs(int ms);
+    void setMultiplier(double multiplier);
+    void setJitter(double jitter); //0..1
+
+private:
+    int initialMs;
+    int maxMs;
+    double factor;
+    double jitterFraction;
+};
+
+#endif // RECONNECTPOLICY_H
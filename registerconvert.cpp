@@ -0,0 +1,337 @@
+#include "registerconvert.h"
+#include <QtEndian>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define REGCONVERT_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//the vector kernels reinterpret register memory, so they are only used on little endian x86
+typedef void (*Swap16Fn)(const quint16 *, quint16 *, int);
+//32 bit values go through void pointers, the caller's array may be float or qint32
+typedef void (*Combine32Fn)(const quint16 *, void *, int, bool, bool);
+typedef void (*Split32Fn)(const void *, quint16 *, int, bool, bool);
+
+void swap16Scalar(const quint16 *in, quint16 *out, int count)
+{
+    for (int i = 0; i < count; ++i)
+        out[i] = qbswap(in[i]);
+}
+
+void combine32Scalar(const quint16 *regs, void *out, int count, bool swapBytes, bool lowWordFirst)
+{
+    char *dst = static_cast<char *>(out);
+    for (int i = 0; i < count; ++i) {
+        quint16 hi = regs[2 * i];
+        quint16 lo = regs[2 * i + 1];
+        if (lowWordFirst)
+            qSwap(hi, lo);
+        if (swapBytes) {
+            hi = qbswap(hi);
+            lo = qbswap(lo);
+        }
+        const quint32 v = (quint32(hi) << 16) | lo;
+        std::memcpy(dst + i * sizeof(v), &v, sizeof(v)); //out may be a float array
+    }
+}
+
+void split32Scalar(const void *values, quint16 *regs, int count, bool swapBytes, bool lowWordFirst)
+{
+    const char *src = static_cast<const char *>(values);
+    for (int i = 0; i < count; ++i) {
+        quint32 v;
+        std::memcpy(&v, src + i * sizeof(v), sizeof(v)); //values may be a float array
+        quint16 hi = quint16(v >> 16);
+        quint16 lo = quint16(v & 0xFFFF);
+        if (swapBytes) {
+            hi = qbswap(hi);
+            lo = qbswap(lo);
+        }
+        if (lowWordFirst)
+            qSwap(hi, lo);
+        regs[2 * i] = hi;
+        regs[2 * i + 1] = lo;
+    }
+}
+
+#ifdef REGCONVERT_X86
+//in memory a register pair loads as lane = regs[0] | regs[1] << 16, so the conversion both ways
+//is a byte swap inside 16 bit halves and/or a 16 bit rotate of each 32 bit lane
+__attribute__((target("sse2")))
+inline __m128i transform128(__m128i x, bool swapBytes, bool rotateWords)
+{
+    if (swapBytes)
+        x = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+    if (rotateWords)
+        x = _mm_or_si128(_mm_slli_epi32(x, 16), _mm_srli_epi32(x, 16));
+    return x;
+}
+
+__attribute__((target("sse2")))
+void swap16Sse2(const quint16 *in, quint16 *out, int count)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), transform128(x, true, false));
+    }
+    swap16Scalar(in + i, out + i, count - i);
+}
+
+__attribute__((target("sse2")))
+void transform32Sse2(const void *src, void *dst, int count, bool swapBytes, bool rotateWords)
+{
+    const quint32 *in = static_cast<const quint32 *>(src);
+    quint32 *out = static_cast<quint32 *>(dst);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), transform128(x, swapBytes, rotateWords));
+    }
+    for (; i < count; ++i) {
+        quint32 v;
+        std::memcpy(&v, in + i, sizeof(v)); //register memory is only 2 byte aligned
+        if (swapBytes)
+            v = ((v & 0x00FF00FFu) << 8) | ((v >> 8) & 0x00FF00FFu);
+        if (rotateWords)
+            v = (v << 16) | (v >> 16);
+        std::memcpy(out + i, &v, sizeof(v));
+    }
+}
+
+__attribute__((target("sse2")))
+void combine32Sse2(const quint16 *regs, void *out, int count, bool swapBytes, bool lowWordFirst)
+{
+    transform32Sse2(regs, out, count, swapBytes, !lowWordFirst);
+}
+
+__attribute__((target("sse2")))
+void split32Sse2(const void *values, quint16 *regs, int count, bool swapBytes, bool lowWordFirst)
+{
+    transform32Sse2(values, regs, count, swapBytes, !lowWordFirst);
+}
+
+//byte swap inside 16 bit lanes, rotate of 32 bit lanes
+__attribute__((target("avx2")))
+inline __m256i transform256(__m256i x, bool swapBytes, bool rotateWords)
+{
+    if (swapBytes)
+        x = _mm256_or_si256(_mm256_slli_epi16(x, 8), _mm256_srli_epi16(x, 8));
+    if (rotateWords)
+        x = _mm256_or_si256(_mm256_slli_epi32(x, 16), _mm256_srli_epi32(x, 16));
+    return x;
+}
+
+__attribute__((target("avx2")))
+void swap16Avx2(const quint16 *in, quint16 *out, int count)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), transform256(x, true, false));
+    }
+    swap16Sse2(in + i, out + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void transform32Avx2(const void *src, void *dst, int count, bool swapBytes, bool rotateWords)
+{
+    const quint32 *in = static_cast<const quint32 *>(src);
+    quint32 *out = static_cast<quint32 *>(dst);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), transform256(x, swapBytes, rotateWords));
+    }
+    transform32Sse2(in + i, out + i, count - i, swapBytes, rotateWords);
+}
+
+__attribute__((target("avx2")))
+void combine32Avx2(const quint16 *regs, void *out, int count, bool swapBytes, bool lowWordFirst)
+{
+    transform32Avx2(regs, out, count, swapBytes, !lowWordFirst);
+}
+
+__attribute__((target("avx2")))
+void split32Avx2(const void *values, quint16 *regs, int count, bool swapBytes, bool lowWordFirst)
+{
+    transform32Avx2(values, regs, count, swapBytes, !lowWordFirst);
+}
+#endif
+
+struct Kernel
+{
+    Swap16Fn swap16;
+    Combine32Fn combine32;
+    Split32Fn split32;
+    const char *name;
+};
+
+Kernel resolveKernel()
+{
+#ifdef REGCONVERT_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Kernel{swap16Avx2, combine32Avx2, split32Avx2, "avx2"};
+    if (__builtin_cpu_supports("sse2"))
+        return Kernel{swap16Sse2, combine32Sse2, split32Sse2, "sse2"};
+#endif
+    return Kernel{swap16Scalar, combine32Scalar, split32Scalar, "scalar"};
+}
+
+Kernel &kernel()
+{
+    static Kernel k = resolveKernel();
+    return k;
+}
+
+void convert16(const quint16 *in, int count, quint16 *out, RegisterConvert::ByteOrder byteOrder)
+{
+    if (!in || !out || count <= 0)
+        return;
+    if (byteOrder == RegisterConvert::ByteOrder::LittleEndian)
+        kernel().swap16(in, out, count);
+    else if (in != out)
+        std::memmove(out, in, size_t(count) * sizeof(quint16));
+}
+
+void combine32(const quint16 *regs, int count, void *out, RegisterConvert::ByteOrder byteOrder, RegisterConvert::WordOrder wordOrder)
+{
+    if (!regs || !out || count <= 0)
+        return;
+    kernel().combine32(regs, out, count,
+                       byteOrder == RegisterConvert::ByteOrder::LittleEndian,
+                       wordOrder == RegisterConvert::WordOrder::LowWordFirst);
+}
+
+void split32(const void *values, int count, quint16 *regs, RegisterConvert::ByteOrder byteOrder, RegisterConvert::WordOrder wordOrder)
+{
+    if (!values || !regs || count <= 0)
+        return;
+    kernel().split32(values, regs, count,
+                     byteOrder == RegisterConvert::ByteOrder::LittleEndian,
+                     wordOrder == RegisterConvert::WordOrder::LowWordFirst);
+}
+
+}
+
+void RegisterConvert::toUInt16(const quint16 *regs, int count, quint16 *out, ByteOrder byteOrder)
+{
+    convert16(regs, count, out, byteOrder);
+}
+
+void RegisterConvert::toInt16(const quint16 *regs, int count, qint16 *out, ByteOrder byteOrder)
+{
+    convert16(regs, count, reinterpret_cast<quint16 *>(out), byteOrder);
+}
+
+void RegisterConvert::toUInt32(const quint16 *regs, int count, quint32 *out, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    combine32(regs, count, out, byteOrder, wordOrder);
+}
+
+void RegisterConvert::toInt32(const quint16 *regs, int count, qint32 *out, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    combine32(regs, count, out, byteOrder, wordOrder);
+}
+
+void RegisterConvert::toFloat32(const quint16 *regs, int count, float *out, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    Q_STATIC_ASSERT(sizeof(float) == sizeof(quint32));
+    combine32(regs, count, out, byteOrder, wordOrder);
+}
+
+void RegisterConvert::fromUInt16(const quint16 *values, int count, quint16 *regs, ByteOrder byteOrder)
+{
+    convert16(values, count, regs, byteOrder);
+}
+
+void RegisterConvert::fromInt16(const qint16 *values, int count, quint16 *regs, ByteOrder byteOrder)
+{
+    convert16(reinterpret_cast<const quint16 *>(values), count, regs, byteOrder);
+}
+
+void RegisterConvert::fromUInt32(const quint32 *values, int count, quint16 *regs, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    split32(values, count, regs, byteOrder, wordOrder);
+}
+
+void RegisterConvert::fromInt32(const qint32 *values, int count, quint16 *regs, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    split32(values, count, regs, byteOrder, wordOrder);
+}
+
+void RegisterConvert::fromFloat32(const float *values, int count, quint16 *regs, ByteOrder byteOrder, WordOrder wordOrder)
+{
+    split32(values, count, regs, byteOrder, wordOrder);
+}
+
+void RegisterConvert::registersToBytes(const quint16 *regs, int count, char *out)
+{
+    //big endian bytes in memory are host registers with swapped bytes on little endian hosts
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (regs && out && count > 0) {
+        if (reinterpret_cast<quintptr>(out) % alignof(quint16) == 0) {
+            kernel().swap16(regs, reinterpret_cast<quint16 *>(out), count);
+        } else {
+            for (int i = 0; i < count; ++i)
+                qToBigEndian(regs[i], out + 2 * i);
+        }
+    }
+#else
+    if (regs && out && count > 0)
+        std::memcpy(out, regs, size_t(count) * sizeof(quint16));
+#endif
+}
+
+void RegisterConvert::bytesToRegisters(const char *in, int count, quint16 *regs)
+{
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    if (in && regs && count > 0) {
+        if (reinterpret_cast<quintptr>(in) % alignof(quint16) == 0) {
+            kernel().swap16(reinterpret_cast<const quint16 *>(in), regs, count);
+        } else {
+            for (int i = 0; i < count; ++i)
+                regs[i] = qFromBigEndian<quint16>(in + 2 * i);
+        }
+    }
+#else
+    if (in && regs && count > 0)
+        std::memcpy(regs, in, size_t(count) * sizeof(quint16));
+#endif
+}
+
+const char *RegisterConvert::kernelName()
+{
+    return kernel().name;
+}
+
+bool RegisterConvert::setKernel(Kernel k)
+{
+    switch (k) {
+    case Kernel::Scalar:
+        kernel() = {swap16Scalar, combine32Scalar, split32Scalar, "scalar"};
+        return true;
+#ifdef REGCONVERT_X86
+    case Kernel::Sse2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("sse2"))
+            return false;
+        kernel() = {swap16Sse2, combine32Sse2, split32Sse2, "sse2"};
+        return true;
+    case Kernel::Avx2:
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("avx2"))
+            return false;
+        kernel() = {swap16Avx2, combine32Avx2, split32Avx2, "avx2"};
+        return true;
+#else
+    default:
+        break;
+#endif
+    }
+    return false;
+}
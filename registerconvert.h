@@ -0,0 +1,49 @@
+#ifndef REGISTERCONVERT_H
+#define REGISTERCONVERT_H
+
+#include <QtGlobal>
+
+//block conversion between Modbus registers (host order quint16) and typed arrays
+//x86 builds use AVX2/SSE2 shuffles picked at runtime, other targets the byte swap loop
+class RegisterConvert
+{
+public:
+    //byte order inside one register, BigEndian is the Modbus default (no swap)
+    enum class ByteOrder {
+        BigEndian,
+        LittleEndian
+    };
+    //register order of 32 bit values, HighWordFirst is ABCD, LowWordFirst is CDAB
+    enum class WordOrder {
+        HighWordFirst,
+        LowWordFirst
+    };
+    enum class Kernel { Scalar, Sse2, Avx2 };
+
+    //registers to values, 32 bit variants read 2*count registers
+    static void toUInt16(const quint16 *regs, int count, quint16 *out, ByteOrder byteOrder = ByteOrder::BigEndian);
+    static void toInt16(const quint16 *regs, int count, qint16 *out, ByteOrder byteOrder = ByteOrder::BigEndian);
+    static void toUInt32(const quint16 *regs, int count, quint32 *out, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+    static void toInt32(const quint16 *regs, int count, qint32 *out, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+    static void toFloat32(const quint16 *regs, int count, float *out, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+
+    //values to registers, 32 bit variants write 2*count registers
+    static void fromUInt16(const quint16 *values, int count, quint16 *regs, ByteOrder byteOrder = ByteOrder::BigEndian);
+    static void fromInt16(const qint16 *values, int count, quint16 *regs, ByteOrder byteOrder = ByteOrder::BigEndian);
+    static void fromUInt32(const quint32 *values, int count, quint16 *regs, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+    static void fromInt32(const qint32 *values, int count, quint16 *regs, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+    static void fromFloat32(const float *values, int count, quint16 *regs, ByteOrder byteOrder = ByteOrder::BigEndian, WordOrder wordOrder = WordOrder::HighWordFirst);
+
+    //wire format, each register as two big endian bytes
+    static void registersToBytes(const quint16 *regs, int count, char *out); //writes 2*count bytes
+    static void bytesToRegisters(const char *in, int count, quint16 *regs); //reads 2*count bytes
+
+    static const char *kernelName(); //"avx2", "sse2" or "scalar"
+    //switch every conversion to one path, for tests and benchmarks; not thread safe, false if the CPU lacks it
+    static bool setKernel(Kernel kernel);
+
+private:
+    RegisterConvert() {}
+};
+
+#endif // REGISTERCONVERT_H
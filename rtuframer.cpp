@@ -0,0 +1,184 @@
+#include "rtuframer.h"
+#include "crc16.h"
+#include <chrono>
+
+#define RTU_MAX_ADU 256
+
+static qint64 steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+RtuFramer::RtuFramer(int characterTime, Mode mode, QObject *parent)
+    : QObject(parent),
+      mode(mode)
+{
+    silenceTimer.setSingleShot(true);
+    silenceTimer.setTimerType(Qt::PreciseTimer);
+    connect(&silenceTimer, &QTimer::timeout, this, &RtuFramer::silenceTimeout);
+    setCharacterTime(characterTime);
+}
+RtuFramer::~RtuFramer(){
+
+}
+
+int RtuFramer::characterTimeUs(qint32 baudRate, int bitsPerCharacter) {
+    if (baudRate <= 0)
+        return 0;
+    return static_cast<int>((bitsPerCharacter * 1000000LL + baudRate - 1) / baudRate);
+}
+
+//the spec fixes the timers above 19200 baud (character time below 11 bits at 19200)
+void RtuFramer::setCharacterTime(int microseconds) {
+    charUs = microseconds > 0 ? microseconds : characterTimeUs(9600);
+    const bool fixedTimers = charUs < characterTimeUs(19200);
+    t15 = fixedTimers ? 750 : (charUs * 3 + 1) / 2;
+    t35 = fixedTimers ? 1750 : (charUs * 7 + 1) / 2;
+}
+
+void RtuFramer::reset() {
+    silenceTimer.stop();
+    pending.clear();
+    lastChunkNs = -1;
+}
+
+void RtuFramer::resetStatistics() {
+    byLength = 0;
+    bySilence = 0;
+    badCrc = 0;
+    gapViolations = 0;
+    detection.reset();
+}
+
+QList<QByteArray> RtuFramer::feed(const QByteArray &chunk, qint64 timestampNs) {
+    QList<QByteArray> frames;
+    if (chunk.isEmpty())
+        return frames;
+
+    //silence before this chunk: time since the previous read minus the time its own bytes took on the wire
+    if (lastChunkNs >= 0 && !pending.isEmpty()) {
+        const qint64 silenceUs = (timestampNs - lastChunkNs) / 1000 - static_cast<qint64>(chunk.size()) * charUs;
+        if (silenceUs >= t35)
+            endOnSilence(frames, lastChunkNs);
+        else if (silenceUs > t15)
+            ++gapViolations;
+    }
+    lastChunkNs = timestampNs;
+
+    pending.append(chunk);
+    extract(frames, timestampNs);
+    if (pending.size() > RTU_MAX_ADU) {
+        emit frameDropped(pending.size());
+        pending.clear();
+    }
+
+    if (pending.isEmpty())
+        silenceTimer.stop();
+    else
+        silenceTimer.start(qMax(1, (t35 + 999) / 1000));
+    return frames;
+}
+
+//take every frame whose predicted length is complete and carries a valid CRC
+void RtuFramer::extract(QList<QByteArray> &frames, qint64 timestampNs) {
+    while (pending.size() >= 4) {
+        int lengths[2];
+        int count = 0;
+        if (mode != Mode::Responses)
+            lengths[count++] = predictLength(false);
+        if (mode != Mode::Requests)
+            lengths[count++] = predictLength(true);
+        if (count == 2 && lengths[1] > 0 && (lengths[0] <= 0 || lengths[1] < lengths[0]))
+            qSwap(lengths[0], lengths[1]); // shortest complete candidate first
+
+        int matched = 0;
+        for (int i = 0; i < count && !matched; ++i) {
+            if (lengths[i] >= 4 && lengths[i] <= pending.size() && crcMatches(lengths[i]))
+                matched = lengths[i];
+        }
+        if (!matched)
+            return; // more bytes, or t3.5 decides
+        ++byLength;
+        emitFrame(frames, matched, timestampNs);
+    }
+}
+
+//t3.5 ended the frame, anything the predictor did not claim must still pass the CRC as a whole
+void RtuFramer::endOnSilence(QList<QByteArray> &frames, qint64 timestampNs) {
+    if (pending.size() >= 4 && crcMatches(pending.size())) {
+        ++bySilence;
+        emitFrame(frames, pending.size(), timestampNs);
+        return;
+    }
+    if (pending.size() >= 4)
+        ++badCrc;
+    emit frameDropped(pending.size());
+    pending.clear();
+}
+
+void RtuFramer::emitFrame(QList<QByteArray> &frames, int length, qint64 timestampNs) {
+    const QByteArray frame = pending.left(length - 2);
+    pending.remove(0, length);
+    detection.record((steadyNs() - timestampNs) / 1000);
+    frames.append(frame);
+    emit frameReady(frame);
+}
+
+void RtuFramer::silenceTimeout() {
+    if (pending.isEmpty())
+        return;
+    QList<QByteArray> frames;
+    endOnSilence(frames, lastChunkNs);
+}
+
+bool RtuFramer::crcMatches(int length) const {
+    const quint16 crc = Crc16::compute(pending.constData(), length - 2);
+    const quint8 lo = static_cast<quint8>(pending.at(length - 2));
+    const quint8 hi = static_cast<quint8>(pending.at(length - 1));
+    return crc == static_cast<quint16>(lo | (hi << 8)); // RTU sends the CRC low byte first
+}
+
+//ADU length (address .. CRC) from the function code and, where the PDU has one, its byte count
+int RtuFramer::predictLength(bool response) const {
+    const int size = pending.size();
+    const quint8 function = static_cast<quint8>(pending.at(1));
+    auto byteAt = [this](int i) { return static_cast<int>(static_cast<quint8>(pending.at(i))); };
+
+    if (response) {
+        if (function & 0x80)
+            return 5; // exception: address, function, code, CRC
+        switch (function) {
+        case 0x01: case 0x02: case 0x03: case 0x04:
+        case 0x0C: case 0x11: case 0x14: case 0x15: case 0x17:
+            return size < 3 ? 0 : 5 + byteAt(2);
+        case 0x05: case 0x06: case 0x08: case 0x0B: case 0x0F: case 0x10:
+            return 8;
+        case 0x07:
+            return 5;
+        case 0x16:
+            return 10;
+        case 0x18:
+            return size < 4 ? 0 : 6 + ((byteAt(2) << 8) | byteAt(3));
+        default:
+            return -1;
+        }
+    }
+
+    switch (function) {
+    case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x08:
+        return 8;
+    case 0x07: case 0x0B: case 0x0C: case 0x11:
+        return 4;
+    case 0x0F: case 0x10:
+        return size < 7 ? 0 : 9 + byteAt(6);
+    case 0x14: case 0x15:
+        return size < 3 ? 0 : 5 + byteAt(2);
+    case 0x16:
+        return 10;
+    case 0x17:
+        return size < 11 ? 0 : 13 + byteAt(10);
+    case 0x18:
+        return 6;
+    default:
+        return -1;
+    }
+}
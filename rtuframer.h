@@ -0,0 +1,78 @@
+#ifndef RTUFRAMER_H
+#define RTUFRAMER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QTimer>
+#include "latencyhistogram.h"
+
+//Modbus RTU framing on a raw serial byte stream. a frame ends when its length, predicted from
+//the function code (and byte count), is complete and its CRC checks out, so most frames are
+//emitted on the read that completes them instead of t3.5 later. frames the predictor does not
+//know (custom function codes) end on t3.5 of silence, measured from the chunk timestamps and
+//backed by a precise timer when no further chunk arrives. a silence between t1.5 and t3.5
+//inside a frame breaks the RTU timing rules and is only counted.
+class RtuFramer : public QObject
+{
+    Q_OBJECT
+public:
+    // Which side of the bus the bytes come from, decides how lengths are predicted
+    enum class Mode {
+        Requests,   // we are the slave, frames come from the master
+        Responses,  // we are the master, frames come from slaves
+        Sniff       // both directions on one line, the CRC picks the matching length
+    };
+
+    explicit RtuFramer(int characterTime, Mode mode = Mode::Sniff, QObject *parent = nullptr);
+    ~RtuFramer();
+
+    //character time on the wire, RTU uses 11 bits (start, 8 data, parity or 2nd stop, stop)
+    static int characterTimeUs(qint32 baudRate, int bitsPerCharacter = 11);
+
+    //timestampNs on the steady clock as delivered by Serial::chunkReceived or SerialChunk
+    QList<QByteArray> feed(const QByteArray &chunk, qint64 timestampNs); //returns the frames and emits frameReady for each
+    void reset(); //drop any partial frame
+
+    void setCharacterTime(int microseconds); //above 19200 baud t1.5/t3.5 are fixed at 750/1750 us
+    void setMode(Mode framingMode) { mode = framingMode; }
+    Mode framingMode() const { return mode; }
+    int t15Us() const { return t15; }
+    int t35Us() const { return t35; }
+    int pendingBytes() const { return pending.size(); }
+
+    quint64 framesByLength() const { return byLength; } // ended by the length predictor
+    quint64 framesBySilence() const { return bySilence; } // ended by t3.5
+    quint64 crcErrors() const { return badCrc; }
+    quint64 interCharacterViolations() const { return gapViolations; }
+    //last chunk timestamp to frameReady, the end-of-frame detection delay
+    const LatencyHistogram &detectionHistogram() const { return detection; }
+    void resetStatistics();
+
+signals:
+    void frameReady(const QByteArray &frame); //address + PDU, the CRC is checked and removed
+    void frameDropped(int size); //CRC error, or more than 256 bytes without a frame end
+
+private:
+    void extract(QList<QByteArray> &frames, qint64 timestampNs);
+    void endOnSilence(QList<QByteArray> &frames, qint64 timestampNs);
+    void emitFrame(QList<QByteArray> &frames, int length, qint64 timestampNs);
+    int predictLength(bool response) const; // > 0 length, 0 needs more bytes, -1 unknown
+    bool crcMatches(int length) const;
+    void silenceTimeout();
+
+    QByteArray pending;
+    qint64 lastChunkNs = -1;
+    Mode mode;
+    int charUs = 0;
+    int t15 = 0;
+    int t35 = 0;
+    QTimer silenceTimer;
+    quint64 byLength = 0;
+    quint64 bySilence = 0;
+    quint64 badCrc = 0;
+    quint64 gapViolations = 0;
+    LatencyHistogram detection;
+};
+
+#endif // RTUFRAMER_H
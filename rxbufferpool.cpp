@@ -0,0 +1,55 @@
+#include "rxbufferpool.h"
+
+RxBufferPool::RxBufferPool(int chunkSize, int maxChunks)
+    : size(chunkSize > 0 ? chunkSize : 4096),
+      maxCount(maxChunks > 0 ? maxChunks : 1)
+{
+    chunks.reserve(maxCount);
+}
+
+//round robin from the last chunk handed out, the previous chunk is usually still queued to a consumer
+QByteArray &RxBufferPool::acquire(){
+    const int count = chunks.size();
+    for (int i = 0; i < count; ++i) {
+        const int slot = (next + i) % count;
+        QByteArray &chunk = chunks[slot];
+        if (chunk.isDetached()) {
+            next = (slot + 1) % count;
+            chunk.resize(0); //capacity is reserved, no reallocation
+            return chunk;
+        }
+    }
+
+    if (count < maxCount) {
+        chunks.append(QByteArray());
+        next = 0;
+        return allocate(count);
+    }
+
+    //every chunk is pinned, replace one, the consumer keeps its data through its own reference
+    const int slot = next;
+    next = (next + 1) % count;
+    return allocate(slot);
+}
+
+void RxBufferPool::release(){
+    chunks.clear();
+    next = 0;
+}
+
+int RxBufferPool::pinnedCount() const {
+    int pinned = 0;
+    for (const QByteArray &chunk : chunks) {
+        if (!chunk.isDetached())
+            ++pinned;
+    }
+    return pinned;
+}
+
+QByteArray &RxBufferPool::allocate(int slot){
+    QByteArray &chunk = chunks[slot];
+    chunk = QByteArray();
+    chunk.reserve(size);
+    ++allocations;
+    return chunk;
+}
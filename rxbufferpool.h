@@ -0,0 +1,34 @@
+#ifndef RXBUFFERPOOL_H
+#define RXBUFFERPOOL_H
+
+#include <QByteArray>
+#include <QVector>
+
+//fixed set of preallocated receive chunks, reads go straight into a chunk and the chunk is emitted
+//as is. consumers see it as a read-only QByteArray, a consumer that keeps a copy pins the chunk
+//(implicit sharing) and the pool skips it until that copy is released, so in steady state no
+//read allocates. allocationCount() only grows when every chunk is still held by a consumer.
+class RxBufferPool
+{
+public:
+    explicit RxBufferPool(int chunkSize = 64 * 1024, int maxChunks = 8);
+
+    QByteArray &acquire(); //a chunk nobody else references, size 0, capacity chunkSize()
+    void release(); //drop all chunks, they are allocated again on demand
+
+    int chunkSize() const { return size; }
+    int chunkCount() const { return chunks.size(); }
+    int pinnedCount() const; //chunks a consumer still holds
+    quint64 allocationCount() const { return allocations; }
+
+private:
+    QByteArray &allocate(int slot);
+
+    QVector<QByteArray> chunks;
+    int size;
+    int maxCount;
+    int next = 0;
+    quint64 allocations = 0;
+};
+
+#endif // RXBUFFERPOOL_H
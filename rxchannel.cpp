@@ -0,0 +1,67 @@
+#include "rxchannel.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QThread>
+
+RxChannel::RxChannel(DeliveryMode mode, int capacity, QObject *parent)
+    : QObject(parent),
+      mode(mode),
+      queue(capacity)
+{
+
+}
+RxChannel::~RxChannel(){
+
+}
+
+void RxChannel::setCallback(std::function<void(const QByteArray &)> cb){
+    callback = std::move(cb);
+}
+
+void RxChannel::push(const QByteArray &data){
+    if (mode == DeliveryMode::DirectCallback) {
+        if (callback)
+            callback(data);
+        return;
+    }
+
+    //single producer, the check is one relaxed load once the owner is known
+    const Qt::HANDLE self = QThread::currentThreadId();
+    Qt::HANDLE owner = producer.load(std::memory_order_relaxed);
+    if (owner != self && !(owner == nullptr && producer.compare_exchange_strong(owner, self, std::memory_order_acq_rel))) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        if (!foreignWarned.exchange(true, std::memory_order_relaxed))
+            qWarning() << "RxChannel pushed from a second thread, data dropped";
+        return;
+    }
+
+    if (!queue.push(data)) {
+        droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    //one queued wakeup per burst, drain() clears the flag before it empties the queue
+    if (mode == DeliveryMode::QueuedSignal && !drainScheduled.exchange(true, std::memory_order_acq_rel))
+        QMetaObject::invokeMethod(this, "drain", Qt::QueuedConnection);
+}
+
+void RxChannel::drain(){
+    drainScheduled.store(false, std::memory_order_release);
+    QByteArray data;
+    while (queue.pop(data))
+        emit dataReady(data);
+}
+
+bool RxChannel::poll(QByteArray &data){
+    return queue.pop(data);
+}
+
+int RxChannel::pollAll(QList<QByteArray> &out){
+    int count = 0;
+    QByteArray data;
+    while (queue.pop(data)) {
+        out.append(data);
+        ++count;
+    }
+    return count;
+}
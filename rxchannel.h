@@ -0,0 +1,65 @@
+#ifndef RXCHANNEL_H
+#define RXCHANNEL_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <atomic>
+#include <functional>
+#include "spscqueue.h"
+
+//hands data received on an I/O thread to a consumer, create it on the consumer's thread
+//  QueuedSignal    data is queued lock-free and dataReady is emitted on the consumer thread,
+//                  wakeups are coalesced so a burst costs one queued event
+//  DirectCallback  the callback runs on the I/O thread as soon as data arrives, nothing is queued
+//  Polling         data is queued lock-free until the consumer calls poll()
+//the queue has a single producer: the first thread that pushes owns it, pushes from any other thread
+//are dropped, so attach only transports that share one I/O thread (DirectCallback has no such limit)
+class RxChannel : public QObject
+{
+    Q_OBJECT
+public:
+    enum class DeliveryMode {
+        QueuedSignal,
+        DirectCallback,
+        Polling
+    };
+
+    explicit RxChannel(DeliveryMode mode = DeliveryMode::QueuedSignal, int capacity = 1024, QObject *parent = nullptr);
+    ~RxChannel();
+
+    //connect to any transport with a dataReady(const QByteArray &) signal (Tcp, Serial, Modbus)
+    template<typename Transport>
+    bool attach(Transport *transport)
+    {
+        return connect(transport, &Transport::dataReady, this, &RxChannel::push, Qt::DirectConnection);
+    }
+
+    void setCallback(std::function<void(const QByteArray &)> callback); //DirectCallback mode
+    DeliveryMode deliveryMode() const { return mode; }
+
+    bool poll(QByteArray &data); //Polling mode, false when nothing is queued
+    int pollAll(QList<QByteArray> &out); //returns number of chunks appended
+    int pending() const { return queue.size(); }
+    quint64 dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+signals:
+    void dataReady(const QByteArray &data); //QueuedSignal mode, on the consumer thread
+
+public slots:
+    void push(const QByteArray &data); //producer side, called on the I/O thread
+
+private slots:
+    void drain();
+
+private:
+    DeliveryMode mode;
+    SpscQueue<QByteArray> queue;
+    std::function<void(const QByteArray &)> callback;
+    std::atomic<bool> drainScheduled{false};
+    std::atomic<quint64> droppedCount{0};
+    std::atomic<Qt::HANDLE> producer{nullptr};
+    std::atomic<bool> foreignWarned{false};
+};
+
+#endif // RXCHANNEL_H
@@ -0,0 +1,157 @@
+#include "sendqueue.h"
+#include <QDebug>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#define SENDQUEUE_MAX_IOV 64
+#endif
+
+SendQueue::SendQueue(QTcpSocket *socket, QObject *parent)
+    : QObject(parent),
+      socket(socket)
+{
+    timer = new QTimer(this);
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer); //windows are a few ms, coarse timers would round them up
+    connect(timer, &QTimer::timeout, this, &SendQueue::flush);
+    connect(socket, &QIODevice::bytesWritten, this, &SendQueue::socketBytesWritten);
+}
+SendQueue::~SendQueue(){
+
+}
+
+void SendQueue::setCoalescing(int windowMs, int byteThreshold){
+    window = windowMs > 0 ? windowMs : 0;
+    threshold = byteThreshold > 0 ? byteThreshold : 1;
+    if (window == 0 || pendingBytes >= threshold)
+        flush();
+}
+
+void SendQueue::setWatermarks(qint64 highWatermark, qint64 lowWatermark, qint64 limit){
+    highMark = highWatermark > 0 ? highWatermark : 0;
+    lowMark = qBound<qint64>(0, lowWatermark, highMark);
+    maxBytes = limit > 0 ? limit : 0;
+    updateBackpressure();
+}
+
+//queue without copying, write once the window runs out or enough bytes are waiting
+bool SendQueue::enqueue(const QByteArray &data){
+    if (data.isEmpty())
+        return true;
+    if (maxBytes > 0 && bytesInFlight() + data.size() > maxBytes)
+        return false;
+
+    pending.append(data);
+    pendingBytes += data.size();
+    if (window == 0 || pendingBytes >= threshold) {
+        flush();
+    } else {
+        if (!timer->isActive())
+            timer->start(window);
+        updateBackpressure();
+    }
+    return true;
+}
+
+//one gather write for the whole queue, whatever the kernel does not take goes to the socket's buffer
+void SendQueue::flush(){
+    timer->stop();
+    if (pending.isEmpty())
+        return;
+    if (socket->state() != QAbstractSocket::ConnectedState) {
+        qWarning() << "TCP socket not connected, dropping" << pendingBytes << "queued bytes";
+        clear();
+        return;
+    }
+
+    ++writes;
+    qint64 sent = 0;
+    const bool gathered = writeGather(sent);
+    for (const QByteArray &chunk : pending) {
+        if (sent >= chunk.size()) {
+            sent -= chunk.size();
+        } else if (sent > 0) {
+            socket->write(chunk.constData() + sent, chunk.size() - sent);
+            sent = 0;
+        } else {
+            socket->write(chunk);
+        }
+    }
+    pending.clear();
+    pendingBytes = 0;
+    if (!gathered)
+        socket->flush();
+    updateBackpressure();
+}
+
+void SendQueue::clear(){
+    timer->stop();
+    pending.clear();
+    pendingBytes = 0;
+    updateBackpressure();
+}
+
+qint64 SendQueue::bytesInFlight() const {
+    return pendingBytes + socket->bytesToWrite();
+}
+
+void SendQueue::socketBytesWritten(qint64){
+    updateBackpressure();
+}
+
+//sendmsg with an iovec per queued message, only while the socket's own buffer is empty so the
+//byte order on the wire is kept. false when the platform path is not available
+bool SendQueue::writeGather(qint64 &sent){
+    sent = 0;
+#ifdef Q_OS_UNIX
+    const qintptr fd = socket->socketDescriptor();
+    if (fd < 0 || socket->bytesToWrite() > 0)
+        return false;
+
+    iovec iov[SENDQUEUE_MAX_IOV];
+    int count = 0;
+    for (const QByteArray &chunk : pending) {
+        if (count == SENDQUEUE_MAX_IOV)
+            break;
+        iov[count].iov_base = const_cast<char *>(chunk.constData());
+        iov[count].iov_len = static_cast<size_t>(chunk.size());
+        ++count;
+    }
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(static_cast<int>(fd), &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        //kernel buffer full or a real error, the socket's own write path queues it or reports it
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            qWarning() << "TCP gather write failed:" << std::strerror(errno);
+        return false;
+    }
+    sent = n;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void SendQueue::updateBackpressure(){
+    const qint64 inFlight = bytesInFlight();
+    if (!backpressured && highMark > 0 && inFlight >= highMark) {
+        backpressured = true;
+        emit backpressureChanged(true);
+    } else if (backpressured && inFlight <= lowMark) {
+        backpressured = false;
+        emit backpressureChanged(false);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QList>
+#include <QTimer>
+#include <QTcpSocket>
+
+//per socket send queue, small writes are held for a short window (or until a byte threshold)
+//and handed to the kernel in one gather write instead of one write()+flush() per message.
+//queued bytes are tracked against high/low watermarks so producers can back off.
+class SendQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SendQueue(QTcpSocket *socket, QObject *parent = nullptr);
+    ~SendQueue();
+
+    void setCoalescing(int windowMs, int byteThreshold = 16384); //windowMs 0: write on every enqueue
+    void setWatermarks(qint64 highWatermark, qint64 lowWatermark, qint64 limit = 0); //limit 0 = unbounded
+
+    bool enqueue(const QByteArray &data); //false when the data would exceed the limit, nothing is queued then
+    void flush(); //write everything queued now
+    void clear();
+
+    int queueDepth() const { return pending.size(); } //messages not yet handed to the socket
+    qint64 queuedBytes() const { return pendingBytes; }
+    qint64 bytesInFlight() const; //queued + buffered in the socket, not yet accepted by the kernel
+    bool isBackpressured() const { return backpressured; }
+    quint64 writeCount() const { return writes; } //gather writes issued
+
+signals:
+    void backpressureChanged(bool active); //true above the high watermark, false again below the low one
+
+private slots:
+    void socketBytesWritten(qint64 bytes);
+
+private:
+    bool writeGather(qint64 &sent); //sent = bytes the kernel took from the front of pending
+    void updateBackpressure();
+
+    QTcpSocket *socket;
+    QTimer *timer;
+    QList<QByteArray> pending; //implicitly shared, enqueue does not copy
+    qint64 pendingBytes = 0;
+    int window = 0;
+    int threshold = 16384;
+    qint64 highMark = 1024 * 1024;
+    qint64 lowMark = 256 * 1024;
+    qint64 maxBytes = 0;
+    bool backpressured = false;
+    quint64 writes = 0;
+};
+
+#endif // SENDQUEUE_H
@@ -1,14 +1,26 @@
 #include "serial.h"
+#include <QMetaMethod>
+#include <QDebug>
+#include <QThread>
+#include <chrono>
+#ifdef Q_OS_UNIX
+#include <termios.h>
+#endif
+
+static qint64 steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
 Serial::Serial(QObject *parent) : QObject(parent)
 {
-
+    traceLink = PacketTrace::registerLink("serial");
 }
 
 
 Serial::~Serial()
 {
     disconnectDevice();
+    PacketTrace::unregisterLink(traceLink);
 }
 
 // Note: Default parameters are only in the header file
@@ -21,13 +33,24 @@ bool Serial::connectDevice(
                             Parity parity,
                             StopBits stopBits,
                             FlowControl flow) {
+    return connectDevice(port, static_cast<qint32>(baud), bits, parity, stopBits, flow);
+}
+
+bool Serial::connectDevice(
+                            const std::string &port,
+                            qint32 baudRate,
+                            DataBits bits,
+                            Parity parity,
+                            StopBits stopBits,
+                            FlowControl flow) {
     try{
         disconnectDevice(); // Disconnect any existing connection first
 
         serial = new QSerialPort(this);
 
         serial->setPortName(QString::fromStdString(port));
-        serial->setBaudRate(baud); // No cast needed for unscoped enum
+        PacketTrace::setLinkName(traceLink, "serial " + QString::fromStdString(port));
+        serial->setBaudRate(baudRate);
         serial->setDataBits(static_cast<QSerialPort::DataBits>(bits));
         serial->setParity(static_cast<QSerialPort::Parity>(parity));
         serial->setStopBits(static_cast<QSerialPort::StopBits>(stopBits));
@@ -35,6 +58,24 @@ bool Serial::connectDevice(
 
         if (serial->open(QIODevice::ReadWrite)) {
             cout << "Port opened " << port << endl;
+            QString error;
+            if (!SerialPortOptions::checkBaudRate(serial->handle(), baudRate, &error)) {
+                cerr << "error in setting baud rate " << baudRate << " : " << error.toStdString() << endl;
+                disconnectDevice();
+                return false;
+            }
+            //bits on the wire per character, for the latency estimate and frame timing
+            const int frameBits = 1 + static_cast<int>(bits) + (parity == Parity::None ? 0 : 1)
+                    + (stopBits == StopBits::OneStop ? 1 : 2);
+            charTimeUs = static_cast<int>((frameBits * 1000000LL + baudRate - 1) / baudRate);
+            resetReadLatency();
+            resetTiming();
+            if (rtuFramer)
+                rtuFramer->setCharacterTime(charTimeUs);
+            applyPortOptions();
+            softwareRts = false;
+            if (rs485.enabled) // a disabled config is not pushed, the port keeps what the system set up
+                applyRs485();
             connect(serial, &QSerialPort::readyRead, this, &Serial::reciveData);
             connect(serial, &QSerialPort::readyRead, this, [this]() {
                 emit readReady();
@@ -66,12 +107,20 @@ void Serial::disconnectDevice() {
 
             if (serial) {
                 if (serial->isOpen()) {
+                    restorePortOptions();
                     serial->close();
                     cout << "Serial port disconnected."<<endl;
                 }
                 delete serial;
                 serial = nullptr;
             }
+            portOriginal = SerialPortOptions::Original(); // nothing left to restore once the port is gone
+            if (reassembler)
+                reassembler->reset(); // partial frame belongs to the old connection
+            if (stuffingDecoder)
+                stuffingDecoder->reset();
+            if (rtuFramer)
+                rtuFramer->reset();
 
     } catch (...) {
         cerr << "Exception in disconnectDevice()"<<endl;
@@ -83,9 +132,17 @@ void Serial::sendData(const QByteArray &data) {
     try {
         if (serial && serial->isOpen()) {
             //crc
-            serial->write(data);
-            serial->flush();
-            cout << "Sent via Serial:" << data.toHex(':').toStdString() <<endl;
+            if (softwareRts) {
+                sendHalfDuplex(data);
+            } else {
+                serial->write(data);
+                serial->flush();
+                //the kernel drops RTS once the bytes are out, estimate when that is. with the echo on
+                //the first chunk is our own frame, as in sendHalfDuplex
+                if (rs485.enabled)
+                    txEndNs = rs485.receiveDuringSend ? -1 : steadyNs() + static_cast<qint64>(data.size()) * charTimeUs * 1000;
+            }
+            PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
         } else { cout<<"Serial port not open!"; }
 
     } catch (...) {
@@ -98,12 +155,44 @@ void Serial::sendData(const QByteArray &data) {
 void Serial::reciveData() {
     try {
 
-        if (serial && serial->bytesAvailable() > 0) {
-            QByteArray data = serial->readAll();
-            cout<< "Received via Serial:" << data.toHex(':').toStdString();
-            buffer.append(data);
-            emit dataReady(buffer);
-            buffer.clear();
+        //read straight into a pooled chunk, consumers get the chunk itself (read only, implicitly shared)
+        static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&Serial::dataReady);
+        static const QMetaMethod chunkSignal = QMetaMethod::fromSignal(&Serial::chunkReceived);
+        const qint64 wakeNs = steadyNs();
+        while (serial && serial->bytesAvailable() > 0) {
+            QByteArray &chunk = rxPool.acquire();
+            chunk.resize(static_cast<int>(qMin<qint64>(serial->bytesAvailable(), rxPool.chunkSize())));
+            const qint64 got = serial->read(chunk.data(), chunk.size());
+            if (got <= 0) {
+                chunk.resize(0);
+                break;
+            }
+            chunk.resize(static_cast<int>(got));
+            const qint64 readNs = steadyNs();
+            if (lastChunkNs >= 0)
+                gapHist.record((readNs - lastChunkNs) / 1000);
+            lastChunkNs = readNs;
+            if (txEndNs >= 0) {
+                //first reply byte arrived about got character times before the read
+                turnaroundHist.record((readNs - txEndNs) / 1000 - static_cast<qint64>(got) * charTimeUs);
+                txEndNs = -1;
+            }
+            ++latencyReads;
+            latencyBytes += static_cast<quint64>(got);
+            latencyMaxChunk = qMax(latencyMaxChunk, static_cast<int>(got));
+            queuedUsSum += (got - 1) * charTimeUs;
+            PacketTrace::record(traceLink, PacketTrace::Direction::Rx, chunk);
+            if (isSignalConnected(dataReadySignal)) // no copy is pinned when nobody listens
+                emit dataReady(chunk);
+            if (isSignalConnected(chunkSignal))
+                emit chunkReceived(chunk, readNs);
+            if (reassembler)
+                reassembler->feed(chunk);
+            else if (stuffingDecoder)
+                stuffingDecoder->feed(chunk);
+            else if (rtuFramer)
+                rtuFramer->feed(chunk, readNs);
+            readToEmitHist.record((steadyNs() - wakeNs) / 1000);
         }
 
     } catch (...) {
@@ -112,4 +201,156 @@ void Serial::reciveData() {
 }
 
 
+void Serial::setPortOptions(const SerialPortOptions &options) {
+    portOpts = options;
+    if (serial && serial->isOpen())
+        applyPortOptions();
+}
+
+void Serial::setLowLatencyMode(bool enabled) {
+    SerialPortOptions options = portOpts;
+    options.lowLatency = enabled;
+    options.minChars = enabled ? 1 : -1;
+    options.readTimeoutDs = enabled ? 0 : -1;
+    options.usbLatencyTimerMs = enabled ? 1 : 0;
+    setPortOptions(options);
+}
+
+//failures are only reported, a pty or a plain UART without the flag still works at its default latency.
+//the driver values of the previous options go back first, so an option switched off really is off
+void Serial::applyPortOptions() {
+    restorePortOptions();
+    if (portOpts.isDefault())
+        return;
+    QString error;
+    if (!portOpts.apply(serial->handle(), serial->portName(), &error, &portOriginal))
+        qWarning() << "Serial port options partly applied on" << serial->portName() << ":" << error;
+}
+
+//the low latency flag and the USB latency timer stay with the device after close
+void Serial::restorePortOptions() {
+    if (portOriginal.isEmpty())
+        return;
+    QString error;
+    if (!portOriginal.restore(serial->handle(), serial->portName(), &error))
+        qWarning() << "Serial port options not restored on" << serial->portName() << ":" << error;
+    portOriginal = SerialPortOptions::Original();
+}
+
+void Serial::setRs485(const SerialRs485Options &options) {
+    const bool wasEnabled = rs485.enabled;
+    rs485 = options;
+    if (serial && serial->isOpen() && (rs485.enabled || wasEnabled))
+        applyRs485();
+}
 
+//kernel direction control when the driver has it, RTS toggled around each write otherwise
+void Serial::applyRs485() {
+    softwareRts = false;
+    QString error;
+    if (rs485.apply(serial->handle(), &error) || !rs485.enabled)
+        return; // switching it off again only matters where the kernel had it
+    qWarning() << "Kernel RS-485 mode not available on" << serial->portName() << ":" << error
+               << ", toggling RTS in software";
+    softwareRts = true;
+    serial->setRequestToSend(!rs485.rtsOnSend);
+}
+
+//software RTS: blocks until the last byte has left the UART, the turnaround then starts
+//at the RTS drop and is only as short as the scheduler allows
+void Serial::sendHalfDuplex(const QByteArray &data) {
+    serial->setRequestToSend(rs485.rtsOnSend);
+    if (rs485.delayBeforeSendMs > 0)
+        QThread::msleep(static_cast<unsigned long>(rs485.delayBeforeSendMs));
+    serial->write(data);
+    serial->waitForBytesWritten(qMax(100, data.size() * charTimeUs / 1000 * 2 + 100));
+#ifdef Q_OS_UNIX
+    ::tcdrain(serial->handle()); // waitForBytesWritten only hands the bytes to the driver
+#endif
+    if (rs485.delayAfterSendMs > 0)
+        QThread::msleep(static_cast<unsigned long>(rs485.delayAfterSendMs));
+    serial->setRequestToSend(!rs485.rtsOnSend);
+    txEndNs = rs485.receiveDuringSend ? -1 : steadyNs(); // with the echo on the first chunk is our own frame
+}
+
+Serial::ReadLatencyStats Serial::readLatency() const {
+    ReadLatencyStats stats;
+    stats.reads = latencyReads;
+    stats.bytes = latencyBytes;
+    stats.maxChunk = latencyMaxChunk;
+    stats.averageQueuedUs = latencyReads ? queuedUsSum / static_cast<qint64>(latencyReads) : 0;
+    stats.maxQueuedUs = latencyMaxChunk > 0 ? static_cast<qint64>(latencyMaxChunk - 1) * charTimeUs : 0;
+    return stats;
+}
+
+void Serial::resetTiming() {
+    lastChunkNs = -1;
+    txEndNs = -1;
+    turnaroundHist.reset();
+    gapHist.reset();
+    readToEmitHist.reset();
+}
+
+void Serial::resetReadLatency() {
+    latencyReads = 0;
+    latencyBytes = 0;
+    latencyMaxChunk = 0;
+    queuedUsSum = 0;
+}
+
+
+//a frameReady slot may change the framing while the framer is still inside feed(), so the old
+//framer is cut off from us and deleted once control is back in the event loop
+template <class Framer>
+static void releaseFramer(Framer *&framer) {
+    if (!framer)
+        return;
+    framer->disconnect();
+    framer->deleteLater();
+    framer = nullptr;
+}
+
+//enable stream framing, partial frames are kept across reads until the end byte arrives
+void Serial::setFraming(char startLimiter, char endLimiter, int maxFrameSize) {
+    releaseFramer(stuffingDecoder);
+    releaseFramer(rtuFramer);
+    if (!reassembler) {
+        reassembler = new FrameReassembler(startLimiter, endLimiter, maxFrameSize, this);
+        connect(reassembler, &FrameReassembler::frameReady, this, &Serial::frameReady);
+    } else {
+        reassembler->setDelimiters(startLimiter, endLimiter);
+        reassembler->setMaxFrameSize(maxFrameSize);
+    }
+}
+
+//enable COBS/SLIP stream framing instead of delimiters
+void Serial::setFraming(ByteStuffing::Mode mode, int maxFrameSize) {
+    releaseFramer(reassembler);
+    releaseFramer(rtuFramer);
+    if (!stuffingDecoder || stuffingDecoder->mode() != mode) {
+        releaseFramer(stuffingDecoder);
+        stuffingDecoder = new ByteStuffingDecoder(mode, maxFrameSize, this);
+        connect(stuffingDecoder, &ByteStuffingDecoder::frameReady, this, &Serial::frameReady);
+    } else {
+        stuffingDecoder->setMaxFrameSize(maxFrameSize);
+    }
+}
+
+//enable Modbus RTU framing on silence timing and predicted frame lengths, frameReady carries
+//address + PDU with the CRC checked and removed
+void Serial::setRtuFraming(RtuFramer::Mode mode) {
+    releaseFramer(reassembler);
+    releaseFramer(stuffingDecoder);
+    if (!rtuFramer) {
+        rtuFramer = new RtuFramer(charTimeUs, mode, this);
+        connect(rtuFramer, &RtuFramer::frameReady, this, &Serial::frameReady);
+    } else {
+        rtuFramer->setMode(mode);
+    }
+}
+
+void Serial::clearFraming() {
+    releaseFramer(reassembler);
+    releaseFramer(stuffingDecoder);
+    releaseFramer(rtuFramer);
+}
@@ -4,6 +4,13 @@
 #include <QObject>
 #include <QSerialPort>
 #include <iostream>
+#include "framereassembler.h"
+#include "bytestuffing.h"
+#include "rxbufferpool.h"
+#include "packettrace.h"
+#include "serialportoptions.h"
+#include "latencyhistogram.h"
+#include "rtuframer.h"
 // Use std namespace for cout/cerr as in the original file
 using std::cout;
 using std::cerr;
@@ -61,14 +68,72 @@ public:
                        StopBits stopBits = StopBits::OneStop,
                        FlowControl flow = FlowControl::None);
 
+    // Any rate QSerialPort and the driver accept (e.g. 230400 up to 4000000), the rate the port
+    // really runs at is read back and more than 3% off fails the connect
+    bool connectDevice(
+                       const std::string &port,
+                       qint32 baudRate,
+                       DataBits bits = DataBits::Data8,
+                       Parity parity = Parity::None,
+                       StopBits stopBits = StopBits::OneStop,
+                       FlowControl flow = FlowControl::None);
+
     void disconnectDevice();
     void sendData(const QByteArray &data);
 
+    //optional stream framing, complete frames are emitted through frameReady
+    void setFraming(char startLimiter, char endLimiter, int maxFrameSize = 4096);
+    void setFraming(ByteStuffing::Mode mode, int maxFrameSize = 4096); //COBS/SLIP, frameReady carries the decoded payload
+    void setRtuFraming(RtuFramer::Mode mode = RtuFramer::Mode::Responses); //Modbus RTU, t3.5 silence and length prediction
+    RtuFramer *rtuFraming() const { return rtuFramer; } // statistics, nullptr unless RTU framing is on
+    void clearFraming();
+
+    // Native tty tuning (Linux), applied on connect and right away if the port is open
+    void setPortOptions(const SerialPortOptions &options);
+    SerialPortOptions portOptions() const { return portOpts; }
+    void setLowLatencyMode(bool enabled); // ASYNC_LOW_LATENCY, VMIN 1 / VTIME 0 and a 1 ms USB latency timer, off restores the driver's values
+
+    // How long received bytes waited before we read them, estimated from the chunk size: the first
+    // byte of an n byte chunk arrived at least (n - 1) character times before the read
+    struct ReadLatencyStats {
+        quint64 reads = 0;
+        quint64 bytes = 0;
+        int maxChunk = 0;
+        qint64 averageQueuedUs = 0;
+        qint64 maxQueuedUs = 0;
+    };
+    ReadLatencyStats readLatency() const;
+    void resetReadLatency();
+    int characterTimeUs() const { return charTimeUs; } // start + data + parity + stop bits at the current rate
+
+    // Per chunk timing on the steady (CLOCK_MONOTONIC) clock, same time base as SerialChunk::timestampNs.
+    // gap: between consecutive chunks, readToEmit: readyRead dispatched until the chunk's dataReady
+    // and framing consumers returned, so it grows with earlier chunks of the same wakeup and slow slots
+    qint64 lastChunkTimestampNs() const { return lastChunkNs; } // -1 before the first chunk
+    const LatencyHistogram &gapHistogram() const { return gapHist; }
+    const LatencyHistogram &readToEmitHistogram() const { return readToEmitHist; }
+    void resetTiming();
+
+    // RS-485 half duplex, kernel direction control (TIOCSRS485) with a software RTS fallback,
+    // applied on connect and right away if the port is open. with the fallback every sendData()
+    // blocks the calling thread (the IoThread when Serial lives on one) for the delays before and
+    // after send plus the whole transmission: msleep, waitForBytesWritten and tcdrain. no other
+    // port or timer on that thread is served meanwhile, give such ports a thread of their own
+    void setRs485(const SerialRs485Options &options);
+    SerialRs485Options rs485Options() const { return rs485; }
+    bool isRs485SoftwareRts() const { return softwareRts; } // the driver refused TIOCSRS485
+    //end of our transmission to the first byte of the reply, estimated from the read timestamps
+    const LatencyHistogram &turnaroundHistogram() const { return turnaroundHist; }
+
     // Public members
-    QByteArray buffer;
+    QByteArray buffer; // no longer filled, received data is only delivered through dataReady
+
+    quint64 rxAllocationCount() const { return rxPool.allocationCount(); } // grows only while consumers hold every chunk
 
 signals:
     void dataReady(const QByteArray &data);
+    void chunkReceived(const QByteArray &data, qint64 timestampNs); // dataReady with the read time
+    void frameReady(const QByteArray &frame);
     void readReady();
     void errorOccurredSignal(const QString &msg);
 
@@ -78,6 +143,35 @@ private slots:
 public:
     // Pointers to communication objects
     QSerialPort *serial = nullptr;
+
+private:
+    void applyPortOptions();
+    void restorePortOptions();
+    void applyRs485();
+    void sendHalfDuplex(const QByteArray &data);
+
+    FrameReassembler *reassembler = nullptr;
+    ByteStuffingDecoder *stuffingDecoder = nullptr;
+    RtuFramer *rtuFramer = nullptr;
+    RxBufferPool rxPool{16 * 1024, 8}; // serial reads are small, chunks are reused across reads
+    quint16 traceLink; // PacketTrace link id
+
+    SerialPortOptions portOpts;
+    SerialPortOptions::Original portOriginal; // driver values replaced by portOpts on the open port
+    int charTimeUs = 1042; // 10 bits at 9600
+    quint64 latencyReads = 0;
+    quint64 latencyBytes = 0;
+    int latencyMaxChunk = 0;
+    qint64 queuedUsSum = 0;
+
+    qint64 lastChunkNs = -1;
+    LatencyHistogram gapHist;
+    LatencyHistogram readToEmitHist;
+
+    SerialRs485Options rs485;
+    bool softwareRts = false;
+    qint64 txEndNs = -1; // last byte of the last request on the wire, -1 once the reply started
+    LatencyHistogram turnaroundHist;
 };
 
 #endif // SERIAL_H
@@ -0,0 +1,208 @@
+#include "serialmanager.h"
+#include "packettrace.h"
+#include <QMetaMethod>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+SerialManager::SerialManager(int loopCount, QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<SerialChunk>("SerialChunk");
+
+    const int count = loopCount > 0 ? loopCount : 1;
+    for (int i = 0; i < count; ++i) {
+        SerialPollLoop *loop = new SerialPollLoop(
+                    [this](const SerialChunk &chunk) { deliver(chunk); },
+                    [this](int portId, const QString &msg) { emit portError(portId, msg); },
+                    this);
+        loop->setObjectName(QString("SerialPoll%1").arg(i));
+        if (!loop->isValid())
+            qCritical() << "SerialManager: cannot create epoll loop" << i;
+        loops.append(loop);
+    }
+}
+
+SerialManager::~SerialManager()
+{
+    stop();
+    qDeleteAll(loops); //closes every port still registered
+    loops.clear();
+    for (const QSharedPointer<SerialPortHandle> &port : ports)
+        PacketTrace::unregisterLink(port->traceLink);
+}
+
+void SerialManager::start()
+{
+    if (running)
+        return;
+    running = true;
+    for (SerialPollLoop *loop : loops)
+        loop->start();
+}
+
+void SerialManager::stop()
+{
+    if (!running)
+        return;
+    running = false;
+    for (SerialPollLoop *loop : loops)
+        loop->stop();
+}
+
+void SerialManager::setChunkCallback(std::function<void(const SerialChunk &)> callback)
+{
+    if (running)
+        qWarning() << "SerialManager: chunk callback changed while running";
+    chunkCallback = std::move(callback);
+}
+
+//loop thread
+void SerialManager::deliver(const SerialChunk &chunk)
+{
+    static const QMetaMethod chunkSignal = QMetaMethod::fromSignal(&SerialManager::chunkReceived);
+    if (chunkCallback)
+        chunkCallback(chunk);
+    if (isSignalConnected(chunkSignal)) // no copy is pinned when nobody listens
+        emit chunkReceived(chunk);
+}
+
+#ifdef Q_OS_LINUX
+static speed_t standardSpeed(qint32 baudRate) {
+    switch (baudRate) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return B0;
+    }
+}
+#endif
+
+//raw 8N1 style setup like QSerialPort does, rates without a Bxxx constant go through BOTHER
+int SerialManager::addPort(
+                           const std::string &port,
+                           qint32 baudRate,
+                           Serial::DataBits bits,
+                           Serial::Parity parity,
+                           Serial::StopBits stopBits,
+                           Serial::FlowControl flow,
+                           const SerialPortOptions &options)
+{
+#ifdef Q_OS_LINUX
+    try {
+        const int fd = ::open(port.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            cerr << "error in opening serial " << port << " : " << std::strerror(errno) << endl;
+            return -1;
+        }
+
+        termios tio;
+        if (::tcgetattr(fd, &tio) != 0) {
+            cerr << "error in configuring serial " << port << " : " << std::strerror(errno) << endl;
+            ::close(fd);
+            return -1;
+        }
+        ::cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+        switch (bits) {
+        case Serial::DataBits::Data5: tio.c_cflag |= CS5; break;
+        case Serial::DataBits::Data6: tio.c_cflag |= CS6; break;
+        case Serial::DataBits::Data7: tio.c_cflag |= CS7; break;
+        default: tio.c_cflag |= CS8; break;
+        }
+        if (parity == Serial::Parity::Even)
+            tio.c_cflag |= PARENB;
+        else if (parity == Serial::Parity::Odd)
+            tio.c_cflag |= PARENB | PARODD;
+        else if (parity != Serial::Parity::None)
+            qWarning() << "SerialManager: mark/space parity not supported, using none on" << QString::fromStdString(port);
+        if (stopBits != Serial::StopBits::OneStop)
+            tio.c_cflag |= CSTOPB;
+        if (flow == Serial::FlowControl::Hardware)
+            tio.c_cflag |= CRTSCTS;
+        else if (flow == Serial::FlowControl::Software)
+            tio.c_iflag |= IXON | IXOFF;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+
+        const speed_t speed = standardSpeed(baudRate);
+        if (speed != B0)
+            ::cfsetspeed(&tio, speed);
+        QString error;
+        if (::tcsetattr(fd, TCSANOW, &tio) != 0
+                || (speed == B0 && !SerialPortOptions::setCustomBaudRate(fd, baudRate, &error))) {
+            cerr << "error in configuring serial " << port << " : "
+                 << (error.isEmpty() ? std::string(std::strerror(errno)) : error.toStdString()) << endl;
+            ::close(fd);
+            return -1;
+        }
+        if (!options.isDefault() && !options.apply(fd, QString::fromStdString(port), &error))
+            qWarning() << "Serial port options partly applied on" << QString::fromStdString(port) << ":" << error;
+
+        QSharedPointer<SerialPortHandle> handle(new SerialPortHandle);
+        handle->id = nextPortId++;
+        handle->fd = fd;
+        handle->name = QString::fromStdString(port);
+        handle->traceLink = PacketTrace::registerLink("serial " + handle->name);
+        ports.insert(handle->id, handle);
+        loops.at(slotFor(handle->id))->addPort(handle);
+        cout << "Port opened " << port << endl;
+        return handle->id;
+    } catch (...) {
+        cerr << "Exception in addPort(SerialManager)" << endl;
+    }
+#else
+    Q_UNUSED(port); Q_UNUSED(baudRate); Q_UNUSED(bits); Q_UNUSED(parity);
+    Q_UNUSED(stopBits); Q_UNUSED(flow); Q_UNUSED(options);
+    cerr << "SerialManager is only implemented on Linux" << endl;
+#endif
+    return -1;
+}
+
+void SerialManager::removePort(int portId)
+{
+    QSharedPointer<SerialPortHandle> port = ports.take(portId);
+    if (!port)
+        return;
+    loops.at(slotFor(portId))->removePort(portId);
+    PacketTrace::unregisterLink(port->traceLink); //a chunk read before the loop drops the port keeps the old name
+}
+
+bool SerialManager::sendData(int portId, const QByteArray &data)
+{
+    QSharedPointer<SerialPortHandle> port = ports.value(portId);
+    if (!port) {
+        qWarning() << "Serial port" << portId << "not available!";
+        return false;
+    }
+    return loops.at(slotFor(portId))->sendData(*port, data);
+}
+
+SerialManager::PortStats SerialManager::stats(int portId) const
+{
+    PortStats s;
+    QSharedPointer<SerialPortHandle> port = ports.value(portId);
+    if (!port)
+        return s;
+    s.bytesReceived = port->bytesReceived.load(std::memory_order_relaxed);
+    s.chunksReceived = port->chunksReceived.load(std::memory_order_relaxed);
+    s.bytesSent = port->bytesSent.load(std::memory_order_relaxed);
+    s.errors = port->errors.load(std::memory_order_relaxed);
+    s.lastReceiveNs = port->lastReceiveNs.load(std::memory_order_relaxed);
+    s.maxDeliveryUs = port->maxDeliveryUs.load(std::memory_order_relaxed);
+    return s;
+}
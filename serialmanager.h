@@ -0,0 +1,73 @@
+#ifndef SERIALMANAGER_H
+#define SERIALMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QSharedPointer>
+#include <functional>
+#include "serial.h"
+#include "serialpollloop.h"
+#include "serialportoptions.h"
+
+//many serial ports (data concentrators with 16-32 RS-232/485 lines) read by one or two epoll
+//loops on raw descriptors, ports are assigned round robin to the loops. create and use it from
+//one thread, received chunks arrive there through chunkReceived tagged with the port id and the
+//monotonic time of the wakeup, or on the loop thread itself through setChunkCallback.
+class SerialManager : public QObject
+{
+    Q_OBJECT
+public:
+    // Counters of one port, a consistent-enough snapshot taken without locking
+    struct PortStats {
+        quint64 bytesReceived = 0;
+        quint64 chunksReceived = 0;
+        quint64 bytesSent = 0;
+        quint64 errors = 0;
+        qint64 lastReceiveNs = -1; // CLOCK_MONOTONIC
+        qint64 maxDeliveryUs = 0;  // wakeup to chunkReceived emitted / callback returned
+    };
+
+    explicit SerialManager(int loopCount = 1, QObject *parent = nullptr);
+    ~SerialManager();
+
+    void start();
+    void stop(); //ports stay open and are read again on the next start()
+
+    //returns the port id, -1 if the port cannot be opened or configured
+    int addPort(
+                const std::string &port,
+                qint32 baudRate = 9600,
+                Serial::DataBits bits = Serial::DataBits::Data8,
+                Serial::Parity parity = Serial::Parity::None,
+                Serial::StopBits stopBits = Serial::StopBits::OneStop,
+                Serial::FlowControl flow = Serial::FlowControl::None,
+                const SerialPortOptions &options = SerialPortOptions());
+    void removePort(int portId);
+    bool sendData(int portId, const QByteArray &data);
+
+    //runs on the loop thread for every chunk, set before start(). chunkReceived is still emitted
+    //when connected, a slow callback delays every port on the same loop
+    void setChunkCallback(std::function<void(const SerialChunk &)> callback);
+
+    QList<int> portIds() const { return ports.keys(); }
+    int portCount() const { return ports.size(); }
+    PortStats stats(int portId) const;
+    int loopCount() const { return loops.size(); }
+
+signals:
+    void chunkReceived(const SerialChunk &chunk);
+    void portError(int portId, const QString &msg);
+
+private:
+    int slotFor(int portId) const { return (portId - 1) % loops.size(); } //index into loops
+    void deliver(const SerialChunk &chunk);
+
+    QVector<SerialPollLoop *> loops;
+    QHash<int, QSharedPointer<SerialPortHandle>> ports;
+    std::function<void(const SerialChunk &)> chunkCallback;
+    int nextPortId = 1;
+    bool running = false;
+};
+
+#endif // SERIALMANAGER_H
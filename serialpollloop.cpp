@@ -0,0 +1,286 @@
+#include "serialpollloop.h"
+#include "packettrace.h"
+#include <QMutexLocker>
+#include <QDebug>
+
+#ifdef Q_OS_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#endif
+
+#define SERIAL_POLL_EVENTS 64
+
+#ifdef Q_OS_LINUX
+static qint64 monotonicNs() {
+    timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+}
+#endif
+
+SerialPollLoop::SerialPollLoop(std::function<void(const SerialChunk &)> deliver,
+                               std::function<void(int, const QString &)> error,
+                               QObject *parent)
+    : QThread(parent),
+      deliverChunk(std::move(deliver)),
+      reportError(std::move(error))
+{
+#ifdef Q_OS_LINUX
+    epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epollFd >= 0 && wakeFd >= 0) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr; // the wakeup, ports carry their handle
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    }
+#endif
+}
+
+SerialPollLoop::~SerialPollLoop()
+{
+    stop();
+    runCommands(); // removals queued while stopped
+#ifdef Q_OS_LINUX
+    for (const QSharedPointer<SerialPortHandle> &port : ports) {
+        QMutexLocker lock(&port->txLock);
+        if (port->fd >= 0)
+            ::close(port->fd);
+        port->fd = -1;
+    }
+    if (wakeFd >= 0)
+        ::close(wakeFd);
+    if (epollFd >= 0)
+        ::close(epollFd);
+#endif
+}
+
+void SerialPollLoop::stop()
+{
+    if (!isRunning())
+        return;
+    stopping.store(true, std::memory_order_release);
+    post(nullptr); // just the wakeup
+    wait();
+    stopping.store(false, std::memory_order_release);
+}
+
+//ports are only touched by the loop thread, registration goes through the command queue
+void SerialPollLoop::addPort(const QSharedPointer<SerialPortHandle> &port)
+{
+    post([this, port]() {
+#ifdef Q_OS_LINUX
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = port.data();
+        if (::epoll_ctl(epollFd, EPOLL_CTL_ADD, port->fd, &event) != 0) {
+            ++port->errors;
+            reportError(port->id, QString("epoll add failed: %1").arg(QString(std::strerror(errno))));
+            return;
+        }
+#endif
+        ports.insert(port->id, port);
+    });
+}
+
+void SerialPollLoop::removePort(int portId)
+{
+    post([this, portId]() {
+        QSharedPointer<SerialPortHandle> port = ports.take(portId);
+        if (!port)
+            return;
+#ifdef Q_OS_LINUX
+        QMutexLocker lock(&port->txLock);
+        if (port->fd >= 0) {
+            ::epoll_ctl(epollFd, EPOLL_CTL_DEL, port->fd, nullptr);
+            ::close(port->fd);
+        }
+        port->fd = -1;
+        port->txPending.clear();
+#endif
+    });
+}
+
+void SerialPollLoop::post(std::function<void()> command)
+{
+    {
+        QMutexLocker lock(&commandLock);
+        if (command)
+            commands.append(std::move(command));
+    }
+#ifdef Q_OS_LINUX
+    const quint64 one = 1;
+    if (::write(wakeFd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        qWarning() << "SerialPollLoop wakeup failed:" << std::strerror(errno);
+#endif
+}
+
+void SerialPollLoop::runCommands()
+{
+    QList<std::function<void()>> pending;
+    {
+        QMutexLocker lock(&commandLock);
+        pending.swap(commands);
+    }
+    for (const std::function<void()> &command : pending)
+        command();
+}
+
+void SerialPollLoop::run()
+{
+#ifdef Q_OS_LINUX
+    runCommands();
+    epoll_event events[SERIAL_POLL_EVENTS];
+    while (!stopping.load(std::memory_order_acquire)) {
+        const int count = ::epoll_wait(epollFd, events, SERIAL_POLL_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            qWarning() << "SerialPollLoop epoll_wait failed:" << std::strerror(errno);
+            break;
+        }
+        const qint64 wakeNs = monotonicNs();
+        bool wakeup = false;
+        for (int i = 0; i < count; ++i) {
+            SerialPortHandle *port = static_cast<SerialPortHandle *>(events[i].data.ptr);
+            if (!port) {
+                quint64 value;
+                while (::read(wakeFd, &value, sizeof(value)) > 0) {}
+                wakeup = true; // after the ports, a removal must not free a handle still in events[]
+                continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                readPort(*port, wakeNs);
+            if (events[i].events & EPOLLOUT)
+                flushPort(*port);
+        }
+        if (wakeup)
+            runCommands();
+    }
+#endif
+}
+
+//read until the tty is drained, every read is one chunk for the consumer
+void SerialPollLoop::readPort(SerialPortHandle &port, qint64 wakeNs)
+{
+#ifdef Q_OS_LINUX
+    for (;;) {
+        QByteArray &chunk = rxPool.acquire();
+        chunk.resize(rxPool.chunkSize());
+        const ssize_t got = ::read(port.fd, chunk.data(), static_cast<size_t>(chunk.size()));
+        if (got <= 0) {
+            chunk.resize(0);
+            if (got < 0 && errno == EINTR)
+                continue;
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            dropPort(port, got == 0 ? QString("port closed") : QString(std::strerror(errno)));
+            return;
+        }
+        chunk.resize(static_cast<int>(got));
+        port.bytesReceived.fetch_add(static_cast<quint64>(got), std::memory_order_relaxed);
+        port.chunksReceived.fetch_add(1, std::memory_order_relaxed);
+        port.lastReceiveNs.store(wakeNs, std::memory_order_relaxed);
+        PacketTrace::record(port.traceLink, PacketTrace::Direction::Rx, chunk);
+
+        SerialChunk out;
+        out.portId = port.id;
+        out.timestampNs = wakeNs;
+        out.data = chunk;
+        deliverChunk(out);
+
+        const qint64 deliveryUs = (monotonicNs() - wakeNs) / 1000;
+        if (deliveryUs > port.maxDeliveryUs.load(std::memory_order_relaxed))
+            port.maxDeliveryUs.store(deliveryUs, std::memory_order_relaxed);
+        if (got < rxPool.chunkSize())
+            return; // level triggered, anything newer wakes epoll again
+    }
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(wakeNs);
+#endif
+}
+
+//write now if nothing is queued, the rest goes out from the loop on EPOLLOUT
+bool SerialPollLoop::sendData(SerialPortHandle &port, const QByteArray &data)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker lock(&port.txLock);
+    if (port.fd < 0)
+        return false;
+    int offset = 0;
+    if (port.txPending.isEmpty()) {
+        while (offset < data.size()) {
+            const ssize_t n = ::write(port.fd, data.constData() + offset, static_cast<size_t>(data.size() - offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+                ++port.errors;
+                return false;
+            }
+            if (n <= 0)
+                break;
+            offset += static_cast<int>(n);
+        }
+    }
+    port.bytesSent.fetch_add(static_cast<quint64>(data.size()), std::memory_order_relaxed);
+    PacketTrace::record(port.traceLink, PacketTrace::Direction::Tx, data);
+    if (offset == data.size())
+        return true;
+
+    port.txPending.append(data.constData() + offset, data.size() - offset);
+    if (!port.txArmed) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.ptr = &port;
+        port.txArmed = ::epoll_ctl(epollFd, EPOLL_CTL_MOD, port.fd, &event) == 0;
+    }
+    return true;
+#else
+    Q_UNUSED(port);
+    Q_UNUSED(data);
+    return false;
+#endif
+}
+
+void SerialPollLoop::flushPort(SerialPortHandle &port)
+{
+#ifdef Q_OS_LINUX
+    QMutexLocker lock(&port.txLock);
+    while (port.fd >= 0 && !port.txPending.isEmpty()) {
+        const ssize_t n = ::write(port.fd, port.txPending.constData(), static_cast<size_t>(port.txPending.size()));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return; // still full, or an error the next read reports
+        port.txPending.remove(0, static_cast<int>(n));
+    }
+    if (port.fd >= 0 && port.txArmed) {
+        epoll_event event;
+        std::memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.ptr = &port;
+        ::epoll_ctl(epollFd, EPOLL_CTL_MOD, port.fd, &event);
+        port.txArmed = false;
+    }
+#else
+    Q_UNUSED(port);
+#endif
+}
+
+//the descriptor stays open until removePort, polling it would only spin on the error
+void SerialPollLoop::dropPort(SerialPortHandle &port, const QString &reason)
+{
+#ifdef Q_OS_LINUX
+    ::epoll_ctl(epollFd, EPOLL_CTL_DEL, port.fd, nullptr);
+#endif
+    ++port.errors;
+    reportError(port.id, reason);
+}
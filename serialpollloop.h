@@ -0,0 +1,82 @@
+#ifndef SERIALPOLLLOOP_H
+#define SERIALPOLLLOOP_H
+
+#include <QThread>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <atomic>
+#include <functional>
+#include "rxbufferpool.h"
+
+//one read from one port, timestampNs is CLOCK_MONOTONIC taken when epoll woke up for it
+struct SerialChunk {
+    int portId = 0;
+    qint64 timestampNs = 0;
+    QByteArray data;
+};
+Q_DECLARE_METATYPE(SerialChunk)
+
+//one open tty, the descriptor is owned by the loop it is registered with.
+//the counters can be read from any thread
+struct SerialPortHandle {
+    int id = 0;
+    int fd = -1;
+    QString name;
+    quint16 traceLink = 0;
+
+    QMutex txLock; // fd, txPending and txArmed, shared by sendData and the loop's EPOLLOUT flush
+    QByteArray txPending;
+    bool txArmed = false;
+
+    std::atomic<quint64> bytesReceived{0};
+    std::atomic<quint64> chunksReceived{0};
+    std::atomic<quint64> bytesSent{0};
+    std::atomic<quint64> errors{0};
+    std::atomic<qint64> lastReceiveNs{-1};
+    std::atomic<qint64> maxDeliveryUs{0}; // epoll wakeup to the consumer having taken the chunk
+};
+
+//epoll loop on raw tty descriptors, no Qt event loop or notifier per port. ports are handed over
+//with addPort()/removePort() from any thread, the loop picks them up through an eventfd wakeup.
+//deliver runs on the loop thread for every chunk.
+class SerialPollLoop : public QThread
+{
+public:
+    explicit SerialPollLoop(std::function<void(const SerialChunk &)> deliver,
+                            std::function<void(int, const QString &)> error,
+                            QObject *parent = nullptr);
+    ~SerialPollLoop();
+
+    bool isValid() const { return epollFd >= 0 && wakeFd >= 0; }
+    void stop(); // returns once the thread has ended, registered ports stay open
+
+    void addPort(const QSharedPointer<SerialPortHandle> &port);
+    void removePort(int portId); // closes the descriptor
+    bool sendData(SerialPortHandle &port, const QByteArray &data); // any thread, queues what the tty does not take
+
+protected:
+    void run() override;
+
+private:
+    void post(std::function<void()> command);
+    void runCommands();
+    void readPort(SerialPortHandle &port, qint64 wakeNs);
+    void flushPort(SerialPortHandle &port);
+    void dropPort(SerialPortHandle &port, const QString &reason); // stops polling a failed port
+
+    int epollFd = -1;
+    int wakeFd = -1;
+    std::atomic<bool> stopping{false};
+    QMutex commandLock;
+    QList<std::function<void()>> commands;
+    QHash<int, QSharedPointer<SerialPortHandle>> ports; // loop thread only once running
+    RxBufferPool rxPool{4096, 64}; // chunks stay pinned while queued to consumers on other threads
+    std::function<void(const SerialChunk &)> deliverChunk;
+    std::function<void(int, const QString &)> reportError;
+};
+
+#endif // SERIALPOLLLOOP_H
@@ -0,0 +1,255 @@
+#include "serialportoptions.h"
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+// asm/termbits.h has termios2 but clashes with <termios.h>, so only the kernel headers are used here
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#ifdef Q_OS_LINUX
+static QString latencyTimerPath(const QString &portName) {
+    return "/sys/class/tty/" + QFileInfo(portName).fileName() + "/device/latency_timer";
+}
+
+//0 when the port has no USB latency timer or it cannot be read
+static int readLatencyTimer(const QString &portName) {
+    QFile timer(latencyTimerPath(portName));
+    if (!timer.open(QIODevice::ReadOnly))
+        return 0;
+    return timer.readAll().trimmed().toInt();
+}
+
+static bool writeLatencyTimer(const QString &portName, int ms, QString *errorString) {
+    QFile timer(latencyTimerPath(portName));
+    if (timer.open(QIODevice::WriteOnly) && timer.write(QByteArray::number(ms)) > 0)
+        return true;
+    if (errorString)
+        *errorString += QString("latency_timer: %1; ").arg(timer.errorString());
+    return false;
+}
+
+static bool setLowLatencyFlag(int fd, bool enabled, int *previous) {
+    struct serial_struct info;
+    if (::ioctl(fd, TIOCGSERIAL, &info) != 0)
+        return false;
+    const bool wasEnabled = (info.flags & ASYNC_LOW_LATENCY) != 0;
+    if (wasEnabled == enabled)
+        return true;
+    if (enabled)
+        info.flags |= ASYNC_LOW_LATENCY;
+    else
+        info.flags &= ~ASYNC_LOW_LATENCY;
+    if (::ioctl(fd, TIOCSSERIAL, &info) != 0)
+        return false;
+    if (previous)
+        *previous = wasEnabled ? 1 : 0;
+    return true;
+}
+
+//VMIN/VTIME, -1 leaves a value alone, the values replaced are stored in previousMin/previousTime
+static bool setReadTiming(int fd, int minChars, int readTimeoutDs, int *previousMin, int *previousTime) {
+    struct termios2 tio;
+    if (::ioctl(fd, TCGETS2, &tio) != 0)
+        return false;
+    const int oldMin = tio.c_cc[VMIN];
+    const int oldTime = tio.c_cc[VTIME];
+    if (minChars >= 0)
+        tio.c_cc[VMIN] = static_cast<cc_t>(qMin(minChars, 255));
+    if (readTimeoutDs >= 0)
+        tio.c_cc[VTIME] = static_cast<cc_t>(qMin(readTimeoutDs, 255));
+    if (::ioctl(fd, TCSETS2, &tio) != 0)
+        return false;
+    if (previousMin && minChars >= 0)
+        *previousMin = oldMin;
+    if (previousTime && readTimeoutDs >= 0)
+        *previousTime = oldTime;
+    return true;
+}
+#endif
+
+bool SerialPortOptions::apply(qintptr descriptor, const QString &portName, QString *errorString, Original *original) const {
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(descriptor);
+    if (fd < 0) {
+        if (errorString)
+            *errorString = "no port descriptor";
+        return false;
+    }
+
+    bool ok = true;
+    auto fail = [&](const char *label) {
+        ok = false;
+        if (errorString)
+            *errorString += QString("%1: %2; ").arg(label).arg(QString(std::strerror(errno)));
+    };
+
+    if (lowLatency && !setLowLatencyFlag(fd, true, original ? &original->lowLatency : nullptr))
+        fail("ASYNC_LOW_LATENCY");
+
+    if ((minChars >= 0 || readTimeoutDs >= 0)
+            && !setReadTiming(fd, minChars, readTimeoutDs,
+                              original ? &original->minChars : nullptr, original ? &original->readTimeoutDs : nullptr))
+        fail("VMIN/VTIME");
+
+    if (usbLatencyTimerMs > 0) {
+        const int previous = readLatencyTimer(portName);
+        if (previous != usbLatencyTimerMs) {
+            if (!writeLatencyTimer(portName, usbLatencyTimerMs, errorString))
+                ok = false;
+            else if (original && previous > 0)
+                original->usbLatencyTimerMs = previous;
+        }
+    }
+    return ok;
+#else
+    Q_UNUSED(descriptor);
+    Q_UNUSED(portName);
+    Q_UNUSED(original);
+    if (isDefault())
+        return true;
+    if (errorString)
+        *errorString = "serial port tuning is only implemented on Linux";
+    return false;
+#endif
+}
+
+bool SerialPortOptions::Original::restore(qintptr descriptor, const QString &portName, QString *errorString) const {
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(descriptor);
+    bool ok = true;
+    auto fail = [&](const char *label) {
+        ok = false;
+        if (errorString)
+            *errorString += QString("%1: %2; ").arg(label).arg(QString(std::strerror(errno)));
+    };
+
+    if (lowLatency >= 0 && (fd < 0 || !setLowLatencyFlag(fd, lowLatency > 0, nullptr)))
+        fail("ASYNC_LOW_LATENCY");
+    if ((minChars >= 0 || readTimeoutDs >= 0) && (fd < 0 || !setReadTiming(fd, minChars, readTimeoutDs, nullptr, nullptr)))
+        fail("VMIN/VTIME");
+    if (usbLatencyTimerMs > 0 && !writeLatencyTimer(portName, usbLatencyTimerMs, errorString))
+        ok = false;
+    return ok;
+#else
+    Q_UNUSED(descriptor);
+    Q_UNUSED(portName);
+    Q_UNUSED(errorString);
+    return isEmpty();
+#endif
+}
+
+bool SerialPortOptions::setCustomBaudRate(qintptr descriptor, qint32 baudRate, QString *errorString) {
+#ifdef Q_OS_LINUX
+    struct termios2 tio;
+    const int fd = static_cast<int>(descriptor);
+    if (fd < 0 || baudRate <= 0 || ::ioctl(fd, TCGETS2, &tio) != 0) {
+        if (errorString)
+            *errorString = QString("TCGETS2: %1").arg(QString(fd < 0 ? "no port descriptor" : std::strerror(errno)));
+        return false;
+    }
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_cflag &= ~(CBAUD << IBSHIFT); // input speed follows the output speed
+    tio.c_cflag |= BOTHER << IBSHIFT;
+    tio.c_ispeed = static_cast<speed_t>(baudRate);
+    tio.c_ospeed = static_cast<speed_t>(baudRate);
+    if (::ioctl(fd, TCSETS2, &tio) != 0) {
+        if (errorString)
+            *errorString = QString("TCSETS2: %1").arg(QString(std::strerror(errno)));
+        return false;
+    }
+    return checkBaudRate(descriptor, baudRate, errorString);
+#else
+    Q_UNUSED(descriptor);
+    Q_UNUSED(baudRate);
+    if (errorString)
+        *errorString = "custom baud rates are only implemented on Linux";
+    return false;
+#endif
+}
+
+bool SerialPortOptions::checkBaudRate(qintptr descriptor, qint32 baudRate, QString *errorString) {
+#ifdef Q_OS_LINUX
+    struct termios2 tio;
+    const int fd = static_cast<int>(descriptor);
+    if (fd < 0 || ::ioctl(fd, TCGETS2, &tio) != 0) {
+        if (errorString)
+            *errorString = QString("TCGETS2: %1").arg(QString(fd < 0 ? "no port descriptor" : std::strerror(errno)));
+        return false;
+    }
+    if (qAbs(static_cast<qint64>(tio.c_ospeed) - baudRate) * 100 > static_cast<qint64>(baudRate) * 3) {
+        if (errorString)
+            *errorString = QString("baud rate %1 not supported, port runs at %2").arg(baudRate).arg(tio.c_ospeed);
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(descriptor);
+    Q_UNUSED(baudRate);
+    Q_UNUSED(errorString);
+    return true; // QSerialPort::setBaudRate already refused what the platform cannot do
+#endif
+}
+
+
+//read, modify, write: flags this struct does not know about (RX/TX inversion, termination,
+//addressing on newer kernels) and the padding fields keep what the driver or the board setup had
+bool SerialRs485Options::apply(qintptr descriptor, QString *errorString) const {
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(descriptor);
+    struct serial_rs485 config;
+    std::memset(&config, 0, sizeof(config));
+    if (fd < 0 || ::ioctl(fd, TIOCGRS485, &config) != 0) {
+        if (errorString)
+            *errorString = QString("TIOCGRS485: %1").arg(QString(fd < 0 ? "no port descriptor" : std::strerror(errno)));
+        return false;
+    }
+    const __u32 ownFlags = SER_RS485_ENABLED | SER_RS485_RTS_ON_SEND | SER_RS485_RTS_AFTER_SEND | SER_RS485_RX_DURING_TX;
+    config.flags &= ~ownFlags;
+    if (enabled) {
+        config.flags |= SER_RS485_ENABLED;
+        config.flags |= rtsOnSend ? SER_RS485_RTS_ON_SEND : SER_RS485_RTS_AFTER_SEND;
+        if (receiveDuringSend)
+            config.flags |= SER_RS485_RX_DURING_TX;
+        config.delay_rts_before_send = static_cast<__u32>(qMax(0, delayBeforeSendMs));
+        config.delay_rts_after_send = static_cast<__u32>(qMax(0, delayAfterSendMs));
+    }
+    if (::ioctl(fd, TIOCSRS485, &config) != 0) {
+        if (errorString)
+            *errorString = QString("TIOCSRS485: %1").arg(QString(std::strerror(errno)));
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(descriptor);
+    if (!enabled)
+        return true;
+    if (errorString)
+        *errorString = "kernel RS-485 mode is only implemented on Linux";
+    return false;
+#endif
+}
+
+bool SerialRs485Options::applyToPort(const QString &portName, QString *errorString) const {
+#ifdef Q_OS_LINUX
+    const int fd = ::open(portName.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        if (errorString)
+            *errorString = QString("open %1: %2").arg(portName).arg(QString(std::strerror(errno)));
+        return false;
+    }
+    const bool ok = apply(fd, errorString);
+    ::close(fd);
+    return ok;
+#else
+    Q_UNUSED(portName);
+    return apply(-1, errorString);
+#endif
+}
@@ -0,0 +1,56 @@
+#ifndef SERIALPORTOPTIONS_H
+#define SERIALPORTOPTIONS_H
+
+#include <QtGlobal>
+#include <QString>
+
+//Linux tty tuning applied on the native descriptor after the port is opened, -1 / 0 / false
+//leaves the driver default. lowLatency asks the UART driver to push received bytes to the tty
+//layer right away instead of on the next flip-buffer tick, usbLatencyTimerMs does the same for
+//FTDI style USB adapters whose default of 16 ms dominates everything else on the path.
+struct SerialPortOptions {
+    bool lowLatency = false;   // ASYNC_LOW_LATENCY (TIOCSSERIAL), ignored by drivers without it, e.g. ptys
+    int minChars = -1;         // VMIN, bytes a blocking read waits for
+    int readTimeoutDs = -1;    // VTIME, tenths of a second between bytes for a blocking read
+    int usbLatencyTimerMs = 0; // /sys/class/tty/<port>/device/latency_timer, needs write access
+
+    bool isDefault() const { return !lowLatency && minChars < 0 && readTimeoutDs < 0 && usbLatencyTimerMs <= 0; }
+
+    //what apply() found on the port for each setting it changed, restore() writes it back.
+    //the low latency flag and the USB timer outlive the open descriptor, so this is needed on close too
+    struct Original {
+        int lowLatency = -1;        // ASYNC_LOW_LATENCY was clear (0) or set (1), -1 = not changed
+        int minChars = -1;
+        int readTimeoutDs = -1;
+        int usbLatencyTimerMs = 0;
+
+        bool isEmpty() const { return lowLatency < 0 && minChars < 0 && readTimeoutDs < 0 && usbLatencyTimerMs <= 0; }
+        bool restore(qintptr descriptor, const QString &portName, QString *errorString = nullptr) const;
+    };
+
+    //set everything configured, failures are collected in errorString and the rest is still applied
+    bool apply(qintptr descriptor, const QString &portName, QString *errorString = nullptr, Original *original = nullptr) const;
+
+    //any rate the UART can divide to (termios2/BOTHER), e.g. 230400 up to 4000000, for raw descriptors,
+    //a QSerialPort takes such rates through setBaudRate(qint32) itself
+    static bool setCustomBaudRate(qintptr descriptor, qint32 baudRate, QString *errorString = nullptr);
+    //reads the rate back, the driver rounds to what its divisor can produce and more than 3% off breaks framing
+    static bool checkBaudRate(qintptr descriptor, qint32 baudRate, QString *errorString = nullptr);
+};
+
+//RS-485 half-duplex direction control by the kernel (TIOCSRS485): the driver raises RTS (driver
+//enable) around each transmission and drops it as soon as the last stop bit is out, which is
+//the shortest possible turnaround. delays are in ms as the kernel takes them, 0 = none
+struct SerialRs485Options {
+    bool enabled = false;
+    bool rtsOnSend = true;          // RTS level while sending, RTS idles at the opposite level
+    int delayBeforeSendMs = 0;      // driver enable to the first start bit
+    int delayAfterSendMs = 0;       // last stop bit to driver disable
+    bool receiveDuringSend = false; // keep the receiver on and see our own frame echoed
+
+    bool apply(qintptr descriptor, QString *errorString = nullptr) const;
+    //for ports opened by someone else (QModbusRtuSerialMaster), the driver keeps the setting across opens
+    bool applyToPort(const QString &portName, QString *errorString = nullptr) const;
+};
+
+#endif // SERIALPORTOPTIONS_H
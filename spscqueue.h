@@ -0,0 +1,62 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+#include <utility>
+
+//bounded lock-free single producer / single consumer ring
+//one thread calls push(), one other thread calls pop(), capacity is rounded up to a power of two
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(int capacity = 1024)
+    {
+        quint64 size = 2;
+        while (size < static_cast<quint64>(capacity > 0 ? capacity : 1))
+            size <<= 1;
+        ring.resize(static_cast<size_t>(size));
+        mask = size - 1;
+    }
+
+    //producer side, false when the queue is full
+    bool push(const T &value)
+    {
+        const quint64 t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) > mask)
+            return false;
+        ring[static_cast<size_t>(t & mask)] = value;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    //consumer side, false when the queue is empty
+    bool pop(T &value)
+    {
+        const quint64 h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        T &slot = ring[static_cast<size_t>(h & mask)];
+        value = std::move(slot);
+        slot = T(); //release what the slot held before handing it back
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    int size() const
+    {
+        return static_cast<int>(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+    }
+    int capacity() const { return static_cast<int>(mask + 1); }
+    bool isEmpty() const { return size() == 0; }
+
+private:
+    std::vector<T> ring;
+    quint64 mask = 0;
+    alignas(64) std::atomic<quint64> head{0}; //next slot to pop, written by the consumer
+    alignas(64) std::atomic<quint64> tail{0}; //next slot to push, written by the producer
+};
+
+#endif // SPSCQUEUE_H
@@ -1,12 +1,27 @@
 #include "tcp.h"
+#include <QMetaMethod>
 
 Tcp::Tcp(QObject *parent) : QObject(parent)
 {
+    qRegisterMetaType<Tcp::LinkState>("Tcp::LinkState"); // also for SIGNAL()/SLOT() string connections
+    traceLink = PacketTrace::registerLink("tcp");
 
+    reconnectTimer = new QTimer(this);
+    reconnectTimer->setSingleShot(true);
+    connect(reconnectTimer, &QTimer::timeout, this, &Tcp::startAttempt);
+
+    connectTimer = new QTimer(this);
+    connectTimer->setSingleShot(true);
+    connect(connectTimer, &QTimer::timeout, this, [this]() {
+        qWarning() << "TCP connect timeout after" << connectTimeoutMs << "ms";
+        emit errorOccurredSignal("TCP connect timeout");
+        linkDown();
+    });
 }
 Tcp::~Tcp()
 {
     disconnectDevice();
+    PacketTrace::unregisterLink(traceLink);
 }
 
 //overload for Tcp connection
@@ -20,13 +35,40 @@ bool Tcp::connectDevice(
     try {
         disconnectDevice(); // Disconnect any existing connection first
 
+        PacketTrace::setLinkName(traceLink, QString("tcp%1 %2:%3").arg(role == TcpRole::Server ? " server" : "")
+                                 .arg(QString::fromStdString(ip)).arg(port));
+
+        if (role == TcpRole::Server) {
+            server = new QTcpServer(this);
+            serverKeepAlive = keepAlive;
+            serverNoDelay = noDelay;
+            server->setMaxPendingConnections(maxConnectionCount > 0 ? maxConnectionCount : 1024);
+            connect(server, &QTcpServer::newConnection, this, &Tcp::acceptConnections);
+            connect(server, &QTcpServer::acceptError, this, [=](QAbstractSocket::SocketError){
+                if (server)
+                    emit errorOccurredSignal(server->errorString());
+            });
+
+            QHostAddress address = ip.empty() ? QHostAddress(QHostAddress::Any) : QHostAddress(QString::fromStdString(ip));
+            if (!server->listen(address, static_cast<quint16>(port))) {
+                cerr << "Cannot listen on " << ip << ":" << port << " : " << server->errorString().toStdString() << endl;
+                emit errorOccurredSignal(server->errorString());
+                delete server;
+                server = nullptr;
+                return false;
+            }
+            applyListenBufferSizes();
+            qInfo() << "TCP server listening on" << QString::fromStdString(ip) << ":" << port;
+            return true;
+        }
 
         socket = new QTcpSocket(this);
 
         socket->setSocketOption(QAbstractSocket::KeepAliveOption, keepAlive);
         socket->setSocketOption(QAbstractSocket::LowDelayOption, noDelay);
+        sendQueue = createSendQueue(socket);
+        connect(sendQueue, &SendQueue::backpressureChanged, this, &Tcp::backpressureChanged);
 
-        QString qip = QString::fromStdString(ip);
         if (role == TcpRole::Client) {
             connect(socket, &QTcpSocket::readyRead, this, &Tcp::reciveData);
 
@@ -34,43 +76,37 @@ bool Tcp::connectDevice(
                 emit readReady();
             });
 
-            connect(socket, &QTcpSocket::connected, this, [=]{ std::cout << "Connected to TCP host." << std::endl; });
-            connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, [=](QAbstractSocket::SocketError){ if(socket) std::cerr << "Cannot connect: " << socket->errorString().toStdString() << std::endl; });
+            connect(socket, &QTcpSocket::connected, this, &Tcp::linkUp);
+            connect(socket, &QTcpSocket::disconnected, this, &Tcp::linkDown);
 
-            //emit error signal
+            //emit error signal, a failed attempt emits no disconnected so it is handled here
             connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QTcpSocket::error),
                     this,
                     [=](QAbstractSocket::SocketError error){
+                        if (!socket)
+                            return;
+                        std::cerr << "Cannot connect: " << socket->errorString().toStdString() << std::endl;
                         if (error != QAbstractSocket::UnknownSocketError) {
                             emit errorOccurredSignal(socket->errorString());
                         }
+                        if (state == LinkState::Connecting)
+                            linkDown();
                     });
 
+            // Primary endpoint first, alternates in the order they were added
+            targets.clear();
+            targets.append(qMakePair(QString::fromStdString(ip), static_cast<quint16>(port)));
+            targets += failoverTargets;
+            targetIndex = 0;
+            attempt = 0;
+            downClock.invalidate();
+            reconnectEnabled = reconnectMs > 0;
+            if (reconnectEnabled)
+                policy.setInitialDelayMs(reconnectMs);
 
-            if (reconnectMs > 0) {
-                QTimer *timer = new QTimer(this);
-                timer->setObjectName("reconnectTimer"); // Name for later retrieval
-                timer->setSingleShot(true);
-                connect(socket, &QTcpSocket::disconnected, this, [=]() mutable {
-                    if (socket) {
-                         qWarning() << "Socket disconnected, retry in" << reconnectMs << "ms";
-                         timer->start(reconnectMs);
-                    } else {
-                         timer->deleteLater();
-                    }
-                });
-                connect(timer, &QTimer::timeout, this, [=]() {
-                    if (socket) {
-                        qInfo() << "Attempting to reconnect...";
-                        socket->connectToHost(qip, port);
-                    }
-                });
-            }
-            qInfo() << "Connecting to TCP host" << qip << ":" << port;
-            socket->connectToHost(qip, port);
+            startAttempt();
             return true;
         }
-        // Could add TcpRole::Server logic here in the future
     } catch (...) {
         cerr << "Exception in connectDevice(TCP)" << endl;
     }
@@ -82,14 +118,14 @@ bool Tcp::connectDevice(
 void Tcp::disconnectDevice() {
     try {
 
+            reconnectTimer->stop();
+            connectTimer->stop();
+            setLinkState(LinkState::Disconnected);
             if (socket) {
-                // Stop any pending reconnect timers
-                auto *timer = findChild<QTimer*>("reconnectTimer");
-                if (timer) {
-                    timer->stop();
-                    delete timer;
-                }
                 socket->disconnect(this); // Disconnect signals
+                if (sendQueue)
+                    sendQueue->flush(); // hand queued messages to the socket before it closes
+                sendQueue = nullptr; // parented to the socket
                 if (socket->state() != QAbstractSocket::UnconnectedState) {
                     socket->disconnectFromHost();
                     socket->waitForDisconnected(100);
@@ -98,6 +134,18 @@ void Tcp::disconnectDevice() {
                 socket = nullptr;
                 qInfo() << "TCP socket disconnected.";
                 }
+            if (server) {
+                server->close();
+                for (int id : connections.keys())
+                    removeConnection(id);
+                delete server;
+                server = nullptr;
+                qInfo() << "TCP server closed.";
+            }
+            if (reassembler)
+                reassembler->reset(); // partial frame belongs to the old connection
+            if (stuffingDecoder)
+                stuffingDecoder->reset();
 
     } catch (...) {
         qCritical() << "Exception in disconnectDevice()";
@@ -106,14 +154,147 @@ void Tcp::disconnectDevice() {
 
 
 
+//Client reconnect state machine ---------------------------
+
+void Tcp::setLinkState(LinkState newState) {
+    if (state == newState)
+        return;
+    state = newState;
+    emit linkStateChanged(state);
+}
+
+//connect to the current target, the connect timer turns a hanging attempt into a failure
+void Tcp::startAttempt() {
+    if (!socket || targets.isEmpty())
+        return;
+    const QPair<QString, quint16> &target = targets.at(targetIndex);
+    setLinkState(LinkState::Connecting);
+    if (connectTimeoutMs > 0)
+        connectTimer->start(connectTimeoutMs);
+    //buffer sizes only set the window scale before the SYN and QTcpSocket has no descriptor until
+    //it is bound, so bind first. a failed attempt drops the descriptor, hence on every attempt
+    if (socketOpts.hasBufferSizes() && socket->state() == QAbstractSocket::UnconnectedState) {
+        const QHostAddress address(target.first);
+        const QHostAddress any = address.protocol() == QAbstractSocket::IPv6Protocol ? QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4;
+        if (!address.isNull() && socket->bind(any))
+            socketOpts.applyBufferSizes(socket->socketDescriptor());
+    }
+    qInfo() << "Connecting to TCP host" << target.first << ":" << target.second;
+    socket->connectToHost(target.first, target.second);
+}
+
+void Tcp::linkUp() {
+    connectTimer->stop();
+    attempt = 0;
+    if (downClock.isValid()) {
+        lastRecovery = downClock.elapsed();
+        maxRecovery = qMax(maxRecovery, lastRecovery);
+        ++recoveries;
+        downClock.invalidate();
+        qInfo() << "TCP link recovered after" << lastRecovery << "ms";
+        emit recovered(lastRecovery);
+    }
+    applySocketOptions(socket);
+    std::cout << "Connected to TCP host." << std::endl;
+    setLinkState(LinkState::Connected);
+}
+
+//dropped link or failed attempt: a dropped link retries the same endpoint first, a failed attempt
+//moves on to the next one. backoff grows once per full round over all endpoints
+void Tcp::linkDown() {
+    if (!socket || state == LinkState::Backoff || state == LinkState::Disconnected)
+        return;
+    const bool wasConnected = state == LinkState::Connected;
+    connectTimer->stop();
+    setLinkState(reconnectEnabled ? LinkState::Backoff : LinkState::Disconnected);
+    if (socket->state() != QAbstractSocket::UnconnectedState)
+        socket->abort(); // timed out attempt
+    if (sendQueue)
+        sendQueue->clear();
+    if (reassembler)
+        reassembler->reset();
+    if (stuffingDecoder)
+        stuffingDecoder->reset();
+    if (!reconnectEnabled)
+        return;
+
+    if (wasConnected) {
+        downClock.start();
+    } else {
+        targetIndex = (targetIndex + 1) % targets.size();
+        ++attempt;
+    }
+    const int delay = policy.delayMs(attempt / targets.size());
+    qWarning() << "TCP link down, retry" << targets.at(targetIndex).first << ":" << targets.at(targetIndex).second << "in" << delay << "ms";
+    reconnectTimer->start(delay);
+}
+
+void Tcp::setReconnectPolicy(const ReconnectPolicy &reconnectPolicy) {
+    policy = reconnectPolicy;
+}
+
+//takes effect on connected sockets right away and on every later connect/accept
+void Tcp::setSocketOptions(const TcpSocketOptions &options) {
+    socketOpts = options;
+    if (socket && socket->state() == QAbstractSocket::ConnectedState)
+        applySocketOptions(socket);
+    for (auto it = connections.begin(); it != connections.end(); ++it)
+        applySocketOptions(it->socket);
+    applyListenBufferSizes();
+}
+
+void Tcp::applySocketOptions(QTcpSocket *target) {
+    if (!target || socketOpts.isDefault())
+        return;
+    QString error;
+    if (!socketOpts.apply(target->socketDescriptor(), &error))
+        qWarning() << "TCP socket options not fully applied:" << error;
+}
+
+//accepted sockets inherit the listening socket's buffer sizes, so they are in place for their handshake
+void Tcp::applyListenBufferSizes() {
+    if (!server || !server->isListening() || !socketOpts.hasBufferSizes())
+        return;
+    QString error;
+    if (!socketOpts.applyBufferSizes(server->socketDescriptor(), &error))
+        qWarning() << "TCP listen buffer sizes not applied:" << error;
+}
+
+void Tcp::setConnectTimeout(int ms) {
+    connectTimeoutMs = ms > 0 ? ms : 0;
+}
+
+void Tcp::addFailoverEndpoint(const std::string &ip, int port) {
+    failoverTargets.append(qMakePair(QString::fromStdString(ip), static_cast<quint16>(port)));
+}
+
+void Tcp::clearFailoverEndpoints() {
+    failoverTargets.clear();
+}
+
+QString Tcp::currentEndpoint() const {
+    if (targets.isEmpty())
+        return QString();
+    const QPair<QString, quint16> &target = targets.at(targetIndex);
+    return target.first + ":" + QString::number(target.second);
+}
+
+
 //SendData
 void Tcp::sendData(const QByteArray &data) {
     try {
+        if (server) {
+            if (broadcast(data) == 0)
+                qWarning() << "TCP server has no connections!";
+            return;
+        }
 
         if (socket && socket->state() == QAbstractSocket::ConnectedState) {
-                        socket->write(data);
-                        socket->flush();
-                        qInfo() << "Sent via TCP:" << data.toHex(':');
+                        PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+                        if (!sendQueue->enqueue(data)) {
+                            qWarning() << "TCP send queue full, dropped" << data.size() << "bytes";
+                            emit errorOccurredSignal("TCP send queue full");
+                        }
                     } else { qWarning() << "TCP socket not connected!"; }
     }
      catch (...) {
@@ -125,17 +306,308 @@ void Tcp::sendData(const QByteArray &data) {
 void Tcp::reciveData() {
     try {
 
-        if (socket && socket->bytesAvailable() > 0) {
-            QByteArray data = socket->readAll();
-            qInfo() << "Received via TCP:" << data.toHex(':');
-            buffer.append(data);
-            emit dataReady(buffer);
-            buffer.clear();
+        //read straight into a pooled chunk, consumers get the chunk itself (read only, implicitly shared)
+        static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&Tcp::dataReady);
+        while (socket && socket->bytesAvailable() > 0) {
+            QByteArray &chunk = rxPool.acquire();
+            chunk.resize(static_cast<int>(qMin<qint64>(socket->bytesAvailable(), rxPool.chunkSize())));
+            const qint64 got = socket->read(chunk.data(), chunk.size());
+            if (got <= 0) {
+                chunk.resize(0);
+                break;
+            }
+            chunk.resize(static_cast<int>(got));
+            PacketTrace::record(traceLink, PacketTrace::Direction::Rx, chunk);
+            if (isSignalConnected(dataReadySignal)) // no copy is pinned when nobody listens
+                emit dataReady(chunk);
+            if (reassembler)
+                reassembler->feed(chunk);
+            else if (stuffingDecoder)
+                stuffingDecoder->feed(chunk);
         }
+        if (socketOpts.quickAck && socket)
+            TcpSocketOptions::rearmQuickAck(socket->socketDescriptor());
     } catch (...) {
         qCritical() << "Exception in reciveData()";
     }
 }
 
 
+//Server role ---------------------------
+
+//accept everything that is pending in one go, each connection gets an id and its own buffer
+void Tcp::acceptConnections() {
+    try {
+        while (server && server->hasPendingConnections()) {
+            QTcpSocket *client = server->nextPendingConnection();
+            if (!client)
+                break;
+            if (maxConnectionCount > 0 && connections.size() >= maxConnectionCount) {
+                qWarning() << "TCP server connection limit reached, rejecting" << client->peerAddress().toString();
+                client->abort();
+                client->deleteLater();
+                continue;
+            }
+
+            client->setSocketOption(QAbstractSocket::KeepAliveOption, serverKeepAlive);
+            client->setSocketOption(QAbstractSocket::LowDelayOption, serverNoDelay);
+            applySocketOptions(client);
+
+            const int id = nextConnectionId++;
+            Connection conn;
+            conn.socket = client;
+            conn.sendQueue = createSendQueue(client);
+            connect(conn.sendQueue, &SendQueue::backpressureChanged, this, [this, id](bool active) {
+                emit connectionBackpressureChanged(id, active);
+            });
+            setupConnectionFraming(id, conn);
+            connections.insert(id, conn);
+
+            connect(client, &QTcpSocket::readyRead, this, [this, id]() {
+                reciveConnectionData(id);
+                emit readReady();
+            });
+            connect(client, &QTcpSocket::disconnected, this, [this, id]() {
+                removeConnection(id);
+            });
+
+            QString peer = client->peerAddress().toString() + ":" + QString::number(client->peerPort());
+            qInfo() << "TCP client" << id << "connected from" << peer;
+            emit clientConnected(id, peer);
+        }
+    } catch (...) {
+        qCritical() << "Exception in acceptConnections()";
+    }
+}
+
+//read into pooled chunks shared by all connections, per connection state is only the framing
+void Tcp::reciveConnectionData(int connectionId) {
+    try {
+        auto it = connections.find(connectionId);
+        if (it == connections.end() || !it->socket)
+            return;
+        QTcpSocket *client = it->socket;
+        FrameReassembler *connReassembler = it->reassembler;
+        ByteStuffingDecoder *connStuffing = it->stuffingDecoder;
 
+        static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&Tcp::dataReady);
+        static const QMetaMethod dataReceivedSignal = QMetaMethod::fromSignal(&Tcp::dataReceived);
+        while (client->bytesAvailable() > 0) {
+            QByteArray &chunk = rxPool.acquire();
+            chunk.resize(static_cast<int>(qMin<qint64>(client->bytesAvailable(), rxPool.chunkSize())));
+            const qint64 got = client->read(chunk.data(), chunk.size());
+            if (got <= 0) {
+                chunk.resize(0);
+                break;
+            }
+            chunk.resize(static_cast<int>(got));
+            PacketTrace::record(traceLink, PacketTrace::Direction::Rx, chunk);
+
+            //any slot may close the connection, the socket and framers are only deleteLater()'d
+            //but nothing more may be read from or delivered for it
+            if (isSignalConnected(dataReceivedSignal)) {
+                emit dataReceived(connectionId, chunk);
+                if (!connections.contains(connectionId))
+                    return;
+            }
+            if (isSignalConnected(dataReadySignal)) {
+                emit dataReady(chunk);
+                if (!connections.contains(connectionId))
+                    return;
+            }
+            if (connReassembler)
+                connReassembler->feed(chunk);
+            else if (connStuffing)
+                connStuffing->feed(chunk);
+            if (!connections.contains(connectionId))
+                return;
+        }
+        if (socketOpts.quickAck)
+            TcpSocketOptions::rearmQuickAck(client->socketDescriptor());
+    } catch (...) {
+        qCritical() << "Exception in reciveConnectionData()";
+    }
+}
+
+//per connection framing follows the link's setFraming() configuration
+void Tcp::setupConnectionFraming(int connectionId, Connection &conn) {
+    if (reassembler) {
+        conn.reassembler = new FrameReassembler(reassembler->startLimiter(), reassembler->endLimiter(), reassembler->maxFrameSize(), conn.socket);
+        connect(conn.reassembler, &FrameReassembler::frameReady, this, [this, connectionId](const QByteArray &frame) {
+            emit frameReceived(connectionId, frame);
+            emit frameReady(frame);
+        });
+    } else if (stuffingDecoder) {
+        conn.stuffingDecoder = new ByteStuffingDecoder(stuffingDecoder->mode(), stuffingDecoder->maxFrameSize(), conn.socket);
+        connect(conn.stuffingDecoder, &ByteStuffingDecoder::frameReady, this, [this, connectionId](const QByteArray &frame) {
+            emit frameReceived(connectionId, frame);
+            emit frameReady(frame);
+        });
+    }
+}
+
+void Tcp::removeConnection(int connectionId) {
+    auto it = connections.find(connectionId);
+    if (it == connections.end())
+        return;
+    QTcpSocket *client = it->socket;
+    SendQueue *queue = it->sendQueue;
+    //a frame slot may close the connection while its framer is inside feed(), the rest of that chunk is not delivered
+    if (it->reassembler)
+        it->reassembler->disconnect(this);
+    if (it->stuffingDecoder)
+        it->stuffingDecoder->disconnect(this);
+    connections.erase(it);
+    if (client) {
+        client->disconnect(this);
+        if (queue)
+            queue->clear(); // abort() discards the socket buffer as well
+        client->abort();
+        client->deleteLater(); // also deletes the framing objects parented to it
+    }
+    qInfo() << "TCP client" << connectionId << "disconnected";
+    emit clientDisconnected(connectionId);
+}
+
+void Tcp::sendData(int connectionId, const QByteArray &data) {
+    try {
+        auto it = connections.find(connectionId);
+        if (it != connections.end() && it->socket && it->socket->state() == QAbstractSocket::ConnectedState) {
+            PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+            if (!it->sendQueue->enqueue(data))
+                qWarning() << "TCP connection" << connectionId << "send queue full, dropped" << data.size() << "bytes";
+        } else { qWarning() << "TCP connection" << connectionId << "not connected!"; }
+    } catch (...) {
+        qCritical() << "Exception in sendData()";
+    }
+}
+
+int Tcp::broadcast(const QByteArray &data) {
+    int sent = 0;
+    try {
+        PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+        for (auto it = connections.begin(); it != connections.end(); ++it) {
+            if (it->socket && it->socket->state() == QAbstractSocket::ConnectedState
+                && it->sendQueue->enqueue(data)) // implicitly shared, no copy per connection
+                ++sent;
+        }
+    } catch (...) {
+        qCritical() << "Exception in broadcast()";
+    }
+    return sent;
+}
+
+void Tcp::closeConnection(int connectionId) {
+    removeConnection(connectionId);
+}
+
+QList<int> Tcp::connectionIds() const {
+    return connections.keys();
+}
+
+void Tcp::setMaxConnections(int maxConnections) {
+    maxConnectionCount = maxConnections > 0 ? maxConnections : 0;
+    if (server)
+        server->setMaxPendingConnections(maxConnectionCount > 0 ? maxConnectionCount : 1024);
+}
+
+//send queue for one socket, parented to it so it goes away with the connection
+SendQueue *Tcp::createSendQueue(QTcpSocket *target) {
+    SendQueue *queue = new SendQueue(target, target);
+    queue->setCoalescing(coalesceWindowMs, coalesceBytes);
+    queue->setWatermarks(sendHighWatermark, sendLowWatermark, sendLimit);
+    return queue;
+}
+
+//hold small writes for up to windowMs, or until byteThreshold bytes are queued
+void Tcp::setWriteCoalescing(int windowMs, int byteThreshold) {
+    coalesceWindowMs = windowMs > 0 ? windowMs : 0;
+    coalesceBytes = byteThreshold > 0 ? byteThreshold : 1;
+    if (sendQueue)
+        sendQueue->setCoalescing(coalesceWindowMs, coalesceBytes);
+    for (auto it = connections.begin(); it != connections.end(); ++it)
+        it->sendQueue->setCoalescing(coalesceWindowMs, coalesceBytes);
+}
+
+//backpressure turns on at highWatermark queued bytes and off again at lowWatermark,
+//sendData drops messages that would take the queue past limit
+void Tcp::setSendWatermarks(qint64 highWatermark, qint64 lowWatermark, qint64 limit) {
+    sendHighWatermark = highWatermark;
+    sendLowWatermark = lowWatermark;
+    sendLimit = limit;
+    if (sendQueue)
+        sendQueue->setWatermarks(sendHighWatermark, sendLowWatermark, sendLimit);
+    for (auto it = connections.begin(); it != connections.end(); ++it)
+        it->sendQueue->setWatermarks(sendHighWatermark, sendLowWatermark, sendLimit);
+}
+
+void Tcp::flushSendQueue() {
+    if (sendQueue)
+        sendQueue->flush();
+    for (auto it = connections.begin(); it != connections.end(); ++it)
+        it->sendQueue->flush();
+}
+
+int Tcp::sendQueueDepth() const {
+    int depth = sendQueue ? sendQueue->queueDepth() : 0;
+    for (auto it = connections.constBegin(); it != connections.constEnd(); ++it)
+        depth += it->sendQueue->queueDepth();
+    return depth;
+}
+
+qint64 Tcp::bytesInFlight() const {
+    qint64 bytes = sendQueue ? sendQueue->bytesInFlight() : 0;
+    for (auto it = connections.constBegin(); it != connections.constEnd(); ++it)
+        bytes += it->sendQueue->bytesInFlight();
+    return bytes;
+}
+
+bool Tcp::isBackpressured() const {
+    if (sendQueue && sendQueue->isBackpressured())
+        return true;
+    for (auto it = connections.constBegin(); it != connections.constEnd(); ++it) {
+        if (it->sendQueue->isBackpressured())
+            return true;
+    }
+    return false;
+}
+
+//a frameReady slot may change the framing while the framer is still inside feed(), so the old
+//framer is cut off from us and deleted once control is back in the event loop
+template <class Framer>
+static void releaseFramer(Framer *&framer) {
+    if (!framer)
+        return;
+    framer->disconnect();
+    framer->deleteLater();
+    framer = nullptr;
+}
+
+//enable stream framing, partial frames are kept across reads until the end byte arrives
+void Tcp::setFraming(char startLimiter, char endLimiter, int maxFrameSize) {
+    releaseFramer(stuffingDecoder);
+    if (!reassembler) {
+        reassembler = new FrameReassembler(startLimiter, endLimiter, maxFrameSize, this);
+        connect(reassembler, &FrameReassembler::frameReady, this, &Tcp::frameReady);
+    } else {
+        reassembler->setDelimiters(startLimiter, endLimiter);
+        reassembler->setMaxFrameSize(maxFrameSize);
+    }
+}
+
+//enable COBS/SLIP stream framing instead of delimiters
+void Tcp::setFraming(ByteStuffing::Mode mode, int maxFrameSize) {
+    releaseFramer(reassembler);
+    if (!stuffingDecoder || stuffingDecoder->mode() != mode) {
+        releaseFramer(stuffingDecoder);
+        stuffingDecoder = new ByteStuffingDecoder(mode, maxFrameSize, this);
+        connect(stuffingDecoder, &ByteStuffingDecoder::frameReady, this, &Tcp::frameReady);
+    } else {
+        stuffingDecoder->setMaxFrameSize(maxFrameSize);
+    }
+}
+
+void Tcp::clearFraming() {
+    releaseFramer(reassembler);
+    releaseFramer(stuffingDecoder);
+}
@@ -3,7 +3,18 @@
 
 #include <QObject>
 #include <QTcpSocket>
+#include <QTcpServer>
+#include <QHash>
 #include <iostream>
+#include "framereassembler.h"
+#include "bytestuffing.h"
+#include "sendqueue.h"
+#include "rxbufferpool.h"
+#include "packettrace.h"
+#include "reconnectpolicy.h"
+#include "tcpsocketoptions.h"
+#include <QElapsedTimer>
+#include <QPair>
 #include <QTimer>
 #include <QDebug>
 
@@ -25,6 +36,15 @@ public:
         Server
     };
 
+    // Client link state
+    enum class LinkState {
+        Disconnected,
+        Connecting,
+        Connected,
+        Backoff     // down, reconnect scheduled
+    };
+    Q_ENUM(LinkState)
+
     bool connectDevice(
                        const std::string &ip = "127.0.0.1",
                        int port = 8080,
@@ -37,24 +57,132 @@ public:
 
     // Public methods
     void disconnectDevice();
-    void sendData(const QByteArray &data);
+    void sendData(const QByteArray &data); // Server role: sent to every connection
+
+    // Server role, connections are identified by an id handed out on accept
+    void sendData(int connectionId, const QByteArray &data);
+    int broadcast(const QByteArray &data); // returns number of connections written to
+    void closeConnection(int connectionId);
+    QList<int> connectionIds() const;
+    int connectionCount() const { return connections.size(); }
+    void setMaxConnections(int maxConnections); // 0 = unlimited
+
+    // Client reconnect, reconnectMs > 0 in connectDevice enables it and is the first retry delay
+    void setReconnectPolicy(const ReconnectPolicy &reconnectPolicy);
+    ReconnectPolicy reconnectPolicy() const { return policy; }
+    void setConnectTimeout(int ms); // 0 = wait for the OS timeout
+    void addFailoverEndpoint(const std::string &ip, int port); // tried in order after the primary, applies on next connectDevice
+    void clearFailoverEndpoints();
+    LinkState linkState() const { return state; }
+    QString currentEndpoint() const; // "host:port" in use or being tried
+    qint64 lastRecoveryMs() const { return lastRecovery; } // link down to connected again, -1 if never recovered
+    qint64 maxRecoveryMs() const { return maxRecovery; }
+    int recoveryCount() const { return recoveries; }
+
+    // Native socket tuning (Linux), applied to the client socket and every accepted connection
+    void setSocketOptions(const TcpSocketOptions &options);
+    TcpSocketOptions socketOptions() const { return socketOpts; }
+
+    // Send queue, small writes are coalesced into one gather write per window
+    void setWriteCoalescing(int windowMs, int byteThreshold = 16384); // windowMs 0 = write on every sendData
+    void setSendWatermarks(qint64 highWatermark, qint64 lowWatermark, qint64 limit = 0); // limit 0 = unbounded
+    void flushSendQueue();
+    int sendQueueDepth() const; // messages queued, summed over connections in server role
+    qint64 bytesInFlight() const; // queued + socket buffered bytes not yet taken by the kernel
+    bool isBackpressured() const;
+
+    //optional stream framing, complete frames are emitted through frameReady
+    void setFraming(char startLimiter, char endLimiter, int maxFrameSize = 4096);
+    void setFraming(ByteStuffing::Mode mode, int maxFrameSize = 4096); //COBS/SLIP, frameReady carries the decoded payload
+    void clearFraming();
 
 
     // Public members
-    QByteArray buffer;
+    QByteArray buffer; // no longer filled, received data is only delivered through dataReady/dataReceived
+
+    quint64 rxAllocationCount() const { return rxPool.allocationCount(); } // grows only while consumers hold every chunk
 
 signals:
     void dataReady(const QByteArray &data);
+    void frameReady(const QByteArray &frame);
     void readReady();
     void errorOccurredSignal(const QString &msg);
+    void backpressureChanged(bool active); // client role, producers should pause while active
+    void linkStateChanged(Tcp::LinkState state);
+    void recovered(qint64 downtimeMs); // client link back after a drop
+
+    // Server role, per connection attribution (dataReady/frameReady are emitted as well)
+    void clientConnected(int connectionId, const QString &peer);
+    void clientDisconnected(int connectionId);
+    void dataReceived(int connectionId, const QByteArray &data);
+    void frameReceived(int connectionId, const QByteArray &frame);
+    void connectionBackpressureChanged(int connectionId, bool active);
 
 private slots:
     void reciveData();
+    void acceptConnections();
 
 private:
+    // One accepted socket with its own receive buffer and framing state
+    struct Connection {
+        QTcpSocket *socket = nullptr;
+        FrameReassembler *reassembler = nullptr;
+        ByteStuffingDecoder *stuffingDecoder = nullptr;
+        SendQueue *sendQueue = nullptr;
+    };
+
+    void setLinkState(LinkState newState);
+    void startAttempt();
+    void linkUp();
+    void linkDown();
+
+    void reciveConnectionData(int connectionId);
+    void removeConnection(int connectionId);
+    void setupConnectionFraming(int connectionId, Connection &conn);
+    SendQueue *createSendQueue(QTcpSocket *target);
+    void applySocketOptions(QTcpSocket *target);
+    void applyListenBufferSizes();
+
     // Pointers to communication objects
 
      QTcpSocket *socket = nullptr;
+     FrameReassembler *reassembler = nullptr;
+     ByteStuffingDecoder *stuffingDecoder = nullptr;
+     SendQueue *sendQueue = nullptr;
+     RxBufferPool rxPool; // shared by the client socket and all accepted connections
+     quint16 traceLink; // PacketTrace link id, server connections share it
+
+     // Client reconnect state
+     QTimer *reconnectTimer = nullptr;
+     QTimer *connectTimer = nullptr;
+     LinkState state = LinkState::Disconnected;
+     ReconnectPolicy policy;
+     QList<QPair<QString, quint16>> targets; // primary + failover, as used by the current connection
+     QList<QPair<QString, quint16>> failoverTargets;
+     int targetIndex = 0;
+     int attempt = 0; // failed attempts since the link was last up
+     bool reconnectEnabled = false;
+     int connectTimeoutMs = 5000;
+     QElapsedTimer downClock; // valid while a dropped link is being recovered
+     qint64 lastRecovery = -1;
+     qint64 maxRecovery = -1;
+     int recoveries = 0;
+
+     TcpSocketOptions socketOpts;
+
+     // Send queue settings, applied to the client socket and every accepted connection
+     int coalesceWindowMs = 0;
+     int coalesceBytes = 16384;
+     qint64 sendHighWatermark = 1024 * 1024;
+     qint64 sendLowWatermark = 256 * 1024;
+     qint64 sendLimit = 0;
+
+     QTcpServer *server = nullptr;
+     QHash<int, Connection> connections;
+     int nextConnectionId = 1;
+     int maxConnectionCount = 0;
+     bool serverKeepAlive = true;
+     bool serverNoDelay = true;
 
 };
 
@@ -0,0 +1,161 @@
+#include "tcpconnectionmanager.h"
+#include <QDebug>
+
+TcpConnectionManager::TcpConnectionManager(int ioThreadCount, QObject *parent) : QObject(parent)
+{
+    qRegisterMetaType<TcpEndpointState>("TcpEndpointState");
+
+    const int count = ioThreadCount > 0 ? ioThreadCount : 1;
+    for (int i = 0; i < count; ++i) {
+        IoThread *thread = new IoThread(QString("TcpIo%1").arg(i), this);
+        TcpEndpointGroup *group = new TcpEndpointGroup();
+        connect(group, &TcpEndpointGroup::stateChanged, this, &TcpConnectionManager::endpointStateChanged);
+        connect(group, &TcpEndpointGroup::dataReceived, this, &TcpConnectionManager::dataReceived);
+        connect(group, &TcpEndpointGroup::endpointError, this, &TcpConnectionManager::endpointError);
+        thread->attach(group);
+        threads.append(thread);
+        groups.append(group);
+    }
+}
+
+TcpConnectionManager::~TcpConnectionManager()
+{
+    stop();
+    qDeleteAll(groups); //back on this thread after stop()
+}
+
+void TcpConnectionManager::start()
+{
+    if (running)
+        return;
+    running = true;
+    for (int i = 0; i < threads.size(); ++i) {
+        IoThread *thread = threads.at(i);
+        TcpEndpointGroup *group = groups.at(i);
+        if (group->thread() != thread->ioThread())
+            thread->attach(group); //handed back by an earlier stop()
+        thread->start();
+        const int interval = tickMs;
+        thread->post([group, interval]() { group->start(interval); });
+    }
+    //endpoints added while stopped, or closed by stop(), are connected again from the groups' timers
+    for (auto it = endpoints.constBegin(); it != endpoints.constEnd(); ++it) {
+        QSharedPointer<TcpEndpoint> endpoint = it.value();
+        TcpEndpointGroup *group = groups.at(slotFor(endpoint->id));
+        threads.at(slotFor(endpoint->id))->post([group, endpoint]() { group->addEndpoint(endpoint); });
+    }
+}
+
+void TcpConnectionManager::stop()
+{
+    if (!running)
+        return;
+    running = false;
+    for (int i = 0; i < threads.size(); ++i) {
+        TcpEndpointGroup *group = groups.at(i);
+        threads.at(i)->postBlocking([group]() { group->shutdown(); });
+        threads.at(i)->stop();
+    }
+}
+
+//endpoint ids start at 1 and are never reused
+int TcpConnectionManager::addEndpoint(const QString &host, quint16 port)
+{
+    QSharedPointer<TcpEndpoint> endpoint(new TcpEndpoint);
+    endpoint->id = nextEndpointId++;
+    endpoint->host = host;
+    endpoint->port = port;
+    endpoints.insert(endpoint->id, endpoint);
+
+    if (running) {
+        TcpEndpointGroup *group = groups.at(slotFor(endpoint->id));
+        threads.at(slotFor(endpoint->id))->post([group, endpoint]() { group->addEndpoint(endpoint); });
+    }
+    return endpoint->id;
+}
+
+void TcpConnectionManager::removeEndpoint(int endpointId)
+{
+    if (!endpoints.remove(endpointId))
+        return;
+    if (running) {
+        TcpEndpointGroup *group = groups.at(slotFor(endpointId));
+        threads.at(slotFor(endpointId))->post([group, endpointId]() { group->removeEndpoint(endpointId); });
+    }
+}
+
+void TcpConnectionManager::sendData(int endpointId, const QByteArray &data)
+{
+    if (!running || !endpoints.contains(endpointId)) {
+        qWarning() << "TCP endpoint" << endpointId << "not available!";
+        return;
+    }
+    TcpEndpointGroup *group = groups.at(slotFor(endpointId));
+    threads.at(slotFor(endpointId))->post([group, endpointId, data]() { group->sendData(endpointId, data); });
+}
+
+TcpConnectionManager::EndpointStats TcpConnectionManager::stats(int endpointId) const
+{
+    EndpointStats s;
+    QSharedPointer<TcpEndpoint> endpoint = endpoints.value(endpointId);
+    if (!endpoint)
+        return s;
+    s.state = static_cast<TcpEndpointState>(endpoint->state.load(std::memory_order_relaxed));
+    s.bytesReceived = endpoint->bytesReceived.load(std::memory_order_relaxed);
+    s.bytesSent = endpoint->bytesSent.load(std::memory_order_relaxed);
+    s.connects = endpoint->connects.load(std::memory_order_relaxed);
+    s.disconnects = endpoint->disconnects.load(std::memory_order_relaxed);
+    s.failures = endpoint->failures.load(std::memory_order_relaxed);
+    s.lastReceiveMs = endpoint->lastReceiveMs.load(std::memory_order_relaxed);
+    return s;
+}
+
+void TcpConnectionManager::setReconnectPolicy(const ReconnectPolicy &policy)
+{
+    for (int i = 0; i < threads.size(); ++i) {
+        TcpEndpointGroup *group = groups.at(i);
+        threads.at(i)->post([group, policy]() { group->setReconnectPolicy(policy); });
+    }
+}
+
+void TcpConnectionManager::setReconnectInterval(int ms)
+{
+    setReconnectPolicy(ReconnectPolicy::fixed(ms));
+}
+
+void TcpConnectionManager::setStartupRate(int connectsPerTick)
+{
+    for (int i = 0; i < threads.size(); ++i) {
+        TcpEndpointGroup *group = groups.at(i);
+        threads.at(i)->post([group, connectsPerTick]() { group->setStartupRate(connectsPerTick); });
+    }
+}
+
+void TcpConnectionManager::setTickInterval(int ms)
+{
+    tickMs = ms > 0 ? ms : 1;
+}
+
+qint64 TcpConnectionManager::maxLoopLatencyUs() const
+{
+    qint64 worst = 0;
+    for (const TcpEndpointGroup *group : groups)
+        worst = qMax(worst, group->maxLatencyUs());
+    return worst;
+}
+
+qint64 TcpConnectionManager::averageLoopLatencyUs() const
+{
+    if (groups.isEmpty())
+        return 0;
+    qint64 sum = 0;
+    for (const TcpEndpointGroup *group : groups)
+        sum += group->averageLatencyUs();
+    return sum / groups.size();
+}
+
+void TcpConnectionManager::resetLoopLatency()
+{
+    for (TcpEndpointGroup *group : groups)
+        group->resetLatency();
+}
@@ -0,0 +1,71 @@
+#ifndef TCPCONNECTIONMANAGER_H
+#define TCPCONNECTIONMANAGER_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QSharedPointer>
+#include "iothread.h"
+#include "tcpendpointgroup.h"
+
+//many TCP client endpoints (gateways) spread over a few I/O threads, endpoints are assigned
+//round robin to a TcpEndpointGroup per thread. create and use it from one thread (usually the GUI),
+//received data and state changes arrive there tagged with the endpoint id.
+class TcpConnectionManager : public QObject
+{
+    Q_OBJECT
+public:
+    // Counters of one endpoint, a consistent-enough snapshot taken without locking
+    struct EndpointStats {
+        TcpEndpointState state = TcpEndpointState::Idle;
+        quint64 bytesReceived = 0;
+        quint64 bytesSent = 0;
+        quint64 connects = 0;
+        quint64 disconnects = 0;
+        quint64 failures = 0;
+        qint64 lastReceiveMs = -1;
+    };
+
+    explicit TcpConnectionManager(int ioThreadCount = 2, QObject *parent = nullptr);
+    ~TcpConnectionManager();
+
+    void start();
+    void stop(); //closes all endpoints, they reconnect on the next start()
+
+    int addEndpoint(const QString &host, quint16 port); //returns the endpoint id
+    void removeEndpoint(int endpointId);
+    void sendData(int endpointId, const QByteArray &data);
+
+    QList<int> endpointIds() const { return endpoints.keys(); }
+    int endpointCount() const { return endpoints.size(); }
+    EndpointStats stats(int endpointId) const;
+    int ioThreadCount() const { return groups.size(); }
+
+    // Reconnects and startup share one timer per I/O thread
+    void setReconnectPolicy(const ReconnectPolicy &policy);
+    void setReconnectInterval(int ms); //fixed delay, same as setReconnectPolicy(ReconnectPolicy::fixed(ms))
+    void setStartupRate(int connectsPerTick); //per I/O thread, staggers the initial connect storm
+    void setTickInterval(int ms); //takes effect on start()
+
+    // How late the shared timers ran, worst and average over all I/O threads
+    qint64 maxLoopLatencyUs() const;
+    qint64 averageLoopLatencyUs() const;
+    void resetLoopLatency();
+
+signals:
+    void endpointStateChanged(int endpointId, TcpEndpointState state);
+    void dataReceived(int endpointId, const QByteArray &data);
+    void endpointError(int endpointId, const QString &msg);
+
+private:
+    int slotFor(int endpointId) const { return (endpointId - 1) % groups.size(); } //index into threads/groups
+
+    QVector<IoThread *> threads;
+    QVector<TcpEndpointGroup *> groups;
+    QHash<int, QSharedPointer<TcpEndpoint>> endpoints;
+    int nextEndpointId = 1;
+    int tickMs = 50;
+    bool running = false;
+};
+
+#endif // TCPCONNECTIONMANAGER_H
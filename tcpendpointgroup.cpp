@@ -0,0 +1,180 @@
+#include "tcpendpointgroup.h"
+#include <QDebug>
+
+TcpEndpointGroup::TcpEndpointGroup(QObject *parent) : QObject(parent)
+{
+    timer = new QTimer(this);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &TcpEndpointGroup::tick);
+}
+TcpEndpointGroup::~TcpEndpointGroup(){
+
+}
+
+void TcpEndpointGroup::start(int tickMs){
+    tickInterval = tickMs > 0 ? tickMs : 1;
+    clock.start();
+    nextTickUs = 0;
+    timer->start(tickInterval);
+}
+
+void TcpEndpointGroup::shutdown(){
+    timer->stop();
+    due.clear();
+    for (auto it = endpoints.begin(); it != endpoints.end(); ++it) {
+        TcpEndpoint *endpoint = it->data();
+        if (endpoint->socket) {
+            endpoint->socket->disconnect(this);
+            endpoint->socket->abort();
+            delete endpoint->socket;
+            endpoint->socket = nullptr;
+        }
+        endpoint->state.store(static_cast<int>(TcpEndpointState::Idle), std::memory_order_relaxed);
+    }
+    endpoints.clear(); //the manager hands every endpoint over again on the next start()
+}
+
+//new endpoints are connected from tick(), at most startupRate per tick
+void TcpEndpointGroup::addEndpoint(const QSharedPointer<TcpEndpoint> &endpoint){
+    endpoints.insert(endpoint->id, endpoint);
+    due.insert(clock.isValid() ? clock.elapsed() : 0, endpoint->id);
+}
+
+void TcpEndpointGroup::removeEndpoint(int endpointId){
+    QSharedPointer<TcpEndpoint> endpoint = endpoints.take(endpointId);
+    if (!endpoint)
+        return;
+    if (endpoint->socket) {
+        endpoint->socket->disconnect(this);
+        endpoint->socket->abort();
+        endpoint->socket->deleteLater();
+        endpoint->socket = nullptr;
+    }
+    endpoint->state.store(static_cast<int>(TcpEndpointState::Idle), std::memory_order_relaxed);
+    //a stale entry in due is skipped by tick()
+}
+
+void TcpEndpointGroup::sendData(int endpointId, const QByteArray &data){
+    TcpEndpoint *endpoint = endpoints.value(endpointId).data();
+    if (!endpoint || !endpoint->socket || endpoint->socket->state() != QAbstractSocket::ConnectedState) {
+        qWarning() << "TCP endpoint" << endpointId << "not connected!";
+        return;
+    }
+    endpoint->socket->write(data); //flushed by the event loop, writes of one iteration go out together
+    endpoint->bytesSent.fetch_add(static_cast<quint64>(data.size()), std::memory_order_relaxed);
+}
+
+qint64 TcpEndpointGroup::averageLatencyUs() const {
+    const quint64 n = ticks.load(std::memory_order_relaxed);
+    return n ? lateSumUs.load(std::memory_order_relaxed) / static_cast<qint64>(n) : 0;
+}
+
+void TcpEndpointGroup::resetLatency(){
+    maxLateUs.store(0, std::memory_order_relaxed);
+    lateSumUs.store(0, std::memory_order_relaxed);
+    ticks.store(0, std::memory_order_relaxed);
+}
+
+//shared timer: record how late we run, then start the due connects within the startup budget
+void TcpEndpointGroup::tick(){
+    const qint64 nowUs = clock.nsecsElapsed() / 1000;
+    if (nextTickUs > 0) {
+        const qint64 late = nowUs > nextTickUs ? nowUs - nextTickUs : 0;
+        lateSumUs.fetch_add(late, std::memory_order_relaxed);
+        ticks.fetch_add(1, std::memory_order_relaxed);
+        if (late > maxLateUs.load(std::memory_order_relaxed))
+            maxLateUs.store(late, std::memory_order_relaxed);
+    }
+    nextTickUs = nowUs + static_cast<qint64>(tickInterval) * 1000;
+
+    const qint64 nowMs = nowUs / 1000;
+    int budget = startupRate;
+    while (budget > 0 && !due.isEmpty()) {
+        auto it = due.begin();
+        if (it.key() > nowMs)
+            break;
+        const int id = it.value();
+        due.erase(it);
+
+        TcpEndpoint *endpoint = endpoints.value(id).data();
+        if (!endpoint)
+            continue;
+        const TcpEndpointState state = static_cast<TcpEndpointState>(endpoint->state.load(std::memory_order_relaxed));
+        if (state != TcpEndpointState::Idle && state != TcpEndpointState::Waiting)
+            continue;
+        connectEndpoint(endpoint);
+        --budget;
+    }
+}
+
+void TcpEndpointGroup::connectEndpoint(TcpEndpoint *endpoint){
+    if (!endpoint->socket) {
+        const int id = endpoint->id;
+        QTcpSocket *socket = new QTcpSocket(this);
+        endpoint->socket = socket;
+        connect(socket, &QTcpSocket::readyRead, this, [this, id]() { readEndpoint(id); });
+        connect(socket, &QTcpSocket::connected, this, [this, id]() {
+            TcpEndpoint *ep = endpoints.value(id).data();
+            if (!ep)
+                return;
+            ep->socket->setSocketOption(QAbstractSocket::KeepAliveOption, 1);
+            ep->socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+            ep->connects.fetch_add(1, std::memory_order_relaxed);
+            ep->attempt = 0;
+            setState(ep, TcpEndpointState::Connected);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, id]() { endpointDown(id); });
+        connect(socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this,
+                [this, id, socket](QAbstractSocket::SocketError) {
+                    TcpEndpoint *ep = endpoints.value(id).data();
+                    if (!ep)
+                        return;
+                    ep->failures.fetch_add(1, std::memory_order_relaxed);
+                    emit endpointError(id, socket->errorString());
+                    //a failed connect does not emit disconnected
+                    if (socket->state() == QAbstractSocket::UnconnectedState)
+                        endpointDown(id);
+                });
+    }
+    setState(endpoint, TcpEndpointState::Connecting);
+    endpoint->socket->connectToHost(endpoint->host, endpoint->port);
+}
+
+//socket went down (or never came up), queue a reconnect on the shared timer with backoff
+void TcpEndpointGroup::endpointDown(int endpointId){
+    TcpEndpoint *endpoint = endpoints.value(endpointId).data();
+    if (!endpoint)
+        return;
+    const TcpEndpointState state = static_cast<TcpEndpointState>(endpoint->state.load(std::memory_order_relaxed));
+    if (state == TcpEndpointState::Waiting)
+        return; // error and disconnected both report the same drop
+    if (state == TcpEndpointState::Connected)
+        endpoint->disconnects.fetch_add(1, std::memory_order_relaxed);
+    setState(endpoint, TcpEndpointState::Waiting);
+    due.insert(clock.elapsed() + policy.delayMs(endpoint->attempt++), endpointId);
+}
+
+void TcpEndpointGroup::readEndpoint(int endpointId){
+    TcpEndpoint *endpoint = endpoints.value(endpointId).data();
+    if (!endpoint || !endpoint->socket)
+        return;
+    QTcpSocket *socket = endpoint->socket;
+    while (socket->bytesAvailable() > 0) {
+        QByteArray &chunk = rxPool.acquire();
+        chunk.resize(static_cast<int>(qMin<qint64>(socket->bytesAvailable(), rxPool.chunkSize())));
+        const qint64 got = socket->read(chunk.data(), chunk.size());
+        if (got <= 0) {
+            chunk.resize(0);
+            break;
+        }
+        chunk.resize(static_cast<int>(got));
+        endpoint->bytesReceived.fetch_add(static_cast<quint64>(got), std::memory_order_relaxed);
+        emit dataReceived(endpointId, chunk);
+    }
+    endpoint->lastReceiveMs.store(clock.msecsSinceReference(), std::memory_order_relaxed);
+}
+
+void TcpEndpointGroup::setState(TcpEndpoint *endpoint, TcpEndpointState state){
+    if (endpoint->state.exchange(static_cast<int>(state), std::memory_order_relaxed) != static_cast<int>(state))
+        emit stateChanged(endpoint->id, state);
+}
@@ -0,0 +1,95 @@
+#ifndef TCPENDPOINTGROUP_H
+#define TCPENDPOINTGROUP_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QHash>
+#include <QMultiMap>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <atomic>
+#include "rxbufferpool.h"
+#include "reconnectpolicy.h"
+
+enum class TcpEndpointState {
+    Idle,       // added, waiting for its startup slot
+    Connecting,
+    Connected,
+    Waiting     // down, reconnect scheduled
+};
+Q_DECLARE_METATYPE(TcpEndpointState)
+
+//one managed connection, the socket is only touched on the group's thread,
+//the counters can be read from any thread
+struct TcpEndpoint {
+    int id = 0;
+    QString host;
+    quint16 port = 0;
+    QTcpSocket *socket = nullptr;
+    int attempt = 0; // failed connects since the last success, group thread only
+
+    std::atomic<int> state{static_cast<int>(TcpEndpointState::Idle)};
+    std::atomic<quint64> bytesReceived{0};
+    std::atomic<quint64> bytesSent{0};
+    std::atomic<quint64> connects{0};
+    std::atomic<quint64> disconnects{0};
+    std::atomic<quint64> failures{0};
+    std::atomic<qint64> lastReceiveMs{-1}; // monotonic clock ms (QElapsedTimer reference), -1 before the first read
+};
+
+//all endpoints served by one I/O thread. a single timer per group handles staggered startup
+//and reconnects (no QTimer per socket) and measures how late the event loop runs it.
+//every method except the latency getters must run on the group's thread.
+class TcpEndpointGroup : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TcpEndpointGroup(QObject *parent = nullptr);
+    ~TcpEndpointGroup();
+
+    void start(int tickMs);
+    void shutdown(); //closes every socket and stops the timer
+
+    void addEndpoint(const QSharedPointer<TcpEndpoint> &endpoint);
+    void removeEndpoint(int endpointId);
+    void sendData(int endpointId, const QByteArray &data);
+
+    void setReconnectPolicy(const ReconnectPolicy &reconnectPolicy) { policy = reconnectPolicy; }
+    void setStartupRate(int connectsPerTick) { startupRate = connectsPerTick > 0 ? connectsPerTick : 1; }
+
+    // Event loop lateness of the group timer, readable from any thread
+    qint64 maxLatencyUs() const { return maxLateUs.load(std::memory_order_relaxed); }
+    qint64 averageLatencyUs() const;
+    void resetLatency();
+
+signals:
+    void stateChanged(int endpointId, TcpEndpointState state);
+    void dataReceived(int endpointId, const QByteArray &data);
+    void endpointError(int endpointId, const QString &msg);
+
+private slots:
+    void tick();
+
+private:
+    void connectEndpoint(TcpEndpoint *endpoint);
+    void endpointDown(int endpointId);
+    void readEndpoint(int endpointId);
+    void setState(TcpEndpoint *endpoint, TcpEndpointState state);
+
+    QHash<int, QSharedPointer<TcpEndpoint>> endpoints;
+    QMultiMap<qint64, int> due; // monotonic ms -> endpoint to (re)connect
+    QTimer *timer;
+    QElapsedTimer clock;
+    RxBufferPool rxPool{16 * 1024, 64}; // shared by all sockets of the group
+    int tickInterval = 50;
+    ReconnectPolicy policy{250, 30000, 2.0, 0.3}; // jitter spreads hundreds of gateways after a shared outage
+    int startupRate = 16;
+    qint64 nextTickUs = 0;
+
+    std::atomic<qint64> maxLateUs{0};
+    std::atomic<qint64> lateSumUs{0};
+    std::atomic<quint64> ticks{0};
+};
+
+#endif // TCPENDPOINTGROUP_H
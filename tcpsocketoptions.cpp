@@ -0,0 +1,99 @@
+#include "tcpsocketoptions.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+bool TcpSocketOptions::isDefault() const {
+    return !hasBufferSizes() && !hasKeepAliveTiming()
+            && userTimeoutMs <= 0 && !quickAck && busyPollUs <= 0;
+}
+
+#ifdef Q_OS_LINUX
+static bool setOption(int fd, int level, int name, int value, const char *label, QString *errorString) {
+    if (::setsockopt(fd, level, name, &value, sizeof(value)) == 0)
+        return true;
+    if (errorString)
+        *errorString += QString("%1: %2; ").arg(label).arg(QString(std::strerror(errno)));
+    return false;
+}
+#endif
+
+bool TcpSocketOptions::apply(qintptr descriptor, QString *errorString) const {
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(descriptor);
+    if (fd < 0) {
+        if (errorString)
+            *errorString = "no socket descriptor";
+        return false;
+    }
+
+    bool ok = applyBufferSizes(descriptor, errorString);
+    auto set = [&](int level, int name, int value, const char *label) {
+        ok = setOption(fd, level, name, value, label, errorString) && ok;
+    };
+
+    if (hasKeepAliveTiming())
+        set(SOL_SOCKET, SO_KEEPALIVE, 1, "SO_KEEPALIVE"); // timings are ignored without it
+    if (keepAliveIdleSec > 0)
+        set(IPPROTO_TCP, TCP_KEEPIDLE, keepAliveIdleSec, "TCP_KEEPIDLE");
+    if (keepAliveIntervalSec > 0)
+        set(IPPROTO_TCP, TCP_KEEPINTVL, keepAliveIntervalSec, "TCP_KEEPINTVL");
+    if (keepAliveCount > 0)
+        set(IPPROTO_TCP, TCP_KEEPCNT, keepAliveCount, "TCP_KEEPCNT");
+    if (userTimeoutMs > 0)
+        set(IPPROTO_TCP, TCP_USER_TIMEOUT, userTimeoutMs, "TCP_USER_TIMEOUT");
+    if (quickAck)
+        set(IPPROTO_TCP, TCP_QUICKACK, 1, "TCP_QUICKACK");
+#ifdef SO_BUSY_POLL
+    if (busyPollUs > 0)
+        set(SOL_SOCKET, SO_BUSY_POLL, busyPollUs, "SO_BUSY_POLL");
+#endif
+    return ok;
+#else
+    Q_UNUSED(descriptor);
+    if (isDefault())
+        return true;
+    if (errorString)
+        *errorString = "TCP socket tuning is only implemented on Linux";
+    return false;
+#endif
+}
+
+bool TcpSocketOptions::applyBufferSizes(qintptr descriptor, QString *errorString) const {
+#ifdef Q_OS_LINUX
+    const int fd = static_cast<int>(descriptor);
+    if (fd < 0) {
+        if (errorString)
+            *errorString = "no socket descriptor";
+        return false;
+    }
+    bool ok = true;
+    if (receiveBufferSize > 0)
+        ok = setOption(fd, SOL_SOCKET, SO_RCVBUF, receiveBufferSize, "SO_RCVBUF", errorString) && ok;
+    if (sendBufferSize > 0)
+        ok = setOption(fd, SOL_SOCKET, SO_SNDBUF, sendBufferSize, "SO_SNDBUF", errorString) && ok;
+    return ok;
+#else
+    Q_UNUSED(descriptor);
+    if (!hasBufferSizes())
+        return true;
+    if (errorString)
+        *errorString = "TCP socket tuning is only implemented on Linux";
+    return false;
+#endif
+}
+
+bool TcpSocketOptions::rearmQuickAck(qintptr descriptor) {
+#ifdef Q_OS_LINUX
+    const int one = 1;
+    return descriptor >= 0 && ::setsockopt(static_cast<int>(descriptor), IPPROTO_TCP, TCP_QUICKACK, &one, sizeof(one)) == 0;
+#else
+    Q_UNUSED(descriptor);
+    return false;
+#endif
+}
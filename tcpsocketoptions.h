@@ -0,0 +1,33 @@
+#ifndef TCPSOCKETOPTIONS_H
+#define TCPSOCKETOPTIONS_H
+
+#include <QtGlobal>
+#include <QString>
+
+//Linux socket tuning applied on the native descriptor, 0 / false leaves the kernel default.
+//dead peer detection without traffic takes keepAliveIdleSec + keepAliveIntervalSec * keepAliveCount,
+//with unacknowledged data in flight userTimeoutMs bounds it instead (kernel default is ~15 minutes)
+//the buffer sizes pick the window scale, which is fixed by the SYN. Tcp sets them on the bound client
+//socket before connecting and on the listening socket, whose accepted sockets inherit them. on an
+//established link they only resize the buffer, the window can't grow past what the scale allows
+struct TcpSocketOptions {
+    int receiveBufferSize = 0;    // SO_RCVBUF bytes (the kernel doubles it)
+    int sendBufferSize = 0;       // SO_SNDBUF bytes
+    int keepAliveIdleSec = 0;     // TCP_KEEPIDLE, idle time before the first probe
+    int keepAliveIntervalSec = 0; // TCP_KEEPINTVL, time between probes
+    int keepAliveCount = 0;       // TCP_KEEPCNT, unanswered probes before the link is dropped
+    int userTimeoutMs = 0;        // TCP_USER_TIMEOUT, max time sent data may stay unacknowledged
+    bool quickAck = false;        // TCP_QUICKACK, not sticky in the kernel, re-armed after every read
+    int busyPollUs = 0;           // SO_BUSY_POLL, raising it above net.core.busy_poll needs CAP_NET_ADMIN
+
+    bool isDefault() const;
+    bool hasBufferSizes() const { return receiveBufferSize > 0 || sendBufferSize > 0; }
+    bool hasKeepAliveTiming() const { return keepAliveIdleSec > 0 || keepAliveIntervalSec > 0 || keepAliveCount > 0; }
+
+    //set everything configured, failures are collected in errorString and the rest is still applied
+    bool apply(qintptr descriptor, QString *errorString = nullptr) const;
+    bool applyBufferSizes(qintptr descriptor, QString *errorString = nullptr) const; // SO_RCVBUF/SO_SNDBUF only, before connect or listen
+    static bool rearmQuickAck(qintptr descriptor);
+};
+
+#endif // TCPSOCKETOPTIONS_H
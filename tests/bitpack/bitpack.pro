@@ -0,0 +1,10 @@
+include(../tests.pri)
+
+TARGET = tst_bitpack
+
+SOURCES += \
+    tst_bitpack.cpp \
+    $$COMMMODULE/bitpack.cpp
+
+HEADERS += \
+    $$COMMMODULE/bitpack.h
@@ -0,0 +1,161 @@
+#include <QtTest>
+#include "bitpack.h"
+
+//coil and discrete input bitsets in the Modbus wire layout (user-006)
+class BitPackTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void packMatchesWireLayout();
+    void packUnpackRoundTrip_data();
+    void packUnpackRoundTrip();
+    void partialByteTails();
+    void changed();
+    void changedIgnoresPadding();
+    void nextSetBit();
+    void nextSetBitStopsAtCount();
+};
+
+static QVector<quint16> pattern(int count, quint32 seed)
+{
+    QVector<quint16> values(count);
+    for (int i = 0; i < count; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        //non zero values other than 1 must set the bit as well
+        values[i] = (seed >> 28) & 1 ? quint16(seed >> 8) | 0x100 : 0;
+    }
+    return values;
+}
+
+//bit 0 of byte 0 is the first coil, as in a Modbus read coils reply
+void BitPackTest::packMatchesWireLayout()
+{
+    const quint16 values[10] = {1, 0, 1, 1, 0, 0, 0, 0, 0, 1};
+    uchar bits[2] = {0xFF, 0xFF};
+    BitPack::pack(values, 10, bits);
+    QCOMPARE(int(bits[0]), 0x0D);
+    QCOMPARE(int(bits[1]), 0x02);
+    QCOMPARE(BitPack::byteCount(10), 2);
+    QVERIFY(BitPack::testBit(bits, 9));
+    QVERIFY(!BitPack::testBit(bits, 8));
+}
+
+void BitPackTest::packUnpackRoundTrip_data()
+{
+    QTest::addColumn<int>("count");
+    //around the 16 (SSE2) and 32 (AVX2) value steps and the 8 value bytes
+    for (int count : {1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 100, 2000, 2001})
+        QTest::newRow(qPrintable(QString::number(count))) << count;
+}
+
+void BitPackTest::packUnpackRoundTrip()
+{
+    QFETCH(int, count);
+    const QVector<quint16> values = pattern(count, quint32(count));
+    QByteArray packed(BitPack::byteCount(count), 0);
+    uchar *bits = reinterpret_cast<uchar *>(packed.data());
+    BitPack::pack(values.constData(), count, bits);
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(BitPack::testBit(bits, i), values.at(i) != 0);
+
+    QVector<quint16> words(count, 0xAAAA);
+    BitPack::unpack(bits, count, words.data());
+    QVector<uchar> bytes(count, 0xAA);
+    BitPack::unpack(bits, count, bytes.data());
+    for (int i = 0; i < count; ++i) {
+        QCOMPARE(words.at(i), quint16(values.at(i) ? 1 : 0));
+        QCOMPARE(bytes.at(i), uchar(values.at(i) ? 1 : 0));
+    }
+}
+
+//the last byte only carries count % 8 values, pack clears the rest and unpack never writes past count
+void BitPackTest::partialByteTails()
+{
+    for (int count = 1; count <= 40; ++count) {
+        const QVector<quint16> ones(count, 1);
+        QVector<uchar> packed(BitPack::byteCount(count) + 1, 0xFF);
+        BitPack::pack(ones.constData(), count, packed.data());
+        if (count % 8)
+            QCOMPARE(int(packed.at(count / 8)), (1 << (count % 8)) - 1);
+        QCOMPARE(int(packed.last()), 0xFF); // nothing written after the bitset
+
+        QVector<quint16> words(count + 4, 0x5555);
+        BitPack::unpack(packed.constData(), count, words.data());
+        for (int i = 0; i < count; ++i)
+            QCOMPARE(words.at(i), quint16(1));
+        for (int i = count; i < words.size(); ++i)
+            QCOMPARE(words.at(i), quint16(0x5555));
+        QVector<uchar> bytes(count + 4, 0x55);
+        BitPack::unpack(packed.constData(), count, bytes.data());
+        for (int i = count; i < bytes.size(); ++i)
+            QCOMPARE(bytes.at(i), uchar(0x55));
+    }
+}
+
+void BitPackTest::changed()
+{
+    const int count = 1000;
+    const QVector<quint16> before = pattern(count, 1);
+    QVector<quint16> after = before;
+    const QList<int> flipped = {0, 7, 8, 63, 64, 511, 999};
+    for (int i : flipped)
+        after[i] = after.at(i) ? 0 : 1;
+
+    QVector<uchar> a(BitPack::byteCount(count)), b(a.size()), diff(a.size(), 0xFF);
+    BitPack::pack(before.constData(), count, a.data());
+    BitPack::pack(after.constData(), count, b.data());
+    QCOMPARE(BitPack::changed(a.constData(), b.constData(), count, diff.data()), flipped.size());
+    QList<int> found;
+    for (int i = BitPack::nextSetBit(diff.constData(), count, 0); i >= 0; i = BitPack::nextSetBit(diff.constData(), count, i + 1))
+        found.append(i);
+    QCOMPARE(found, flipped);
+
+    QCOMPARE(BitPack::changed(a.constData(), a.constData(), count, diff.data()), 0);
+}
+
+//garbage after the last value in either snapshot is not a change
+void BitPackTest::changedIgnoresPadding()
+{
+    const uchar previous[2] = {0x00, 0x00};
+    const uchar current[2] = {0x01, 0xF8};
+    uchar diff[2];
+    QCOMPARE(BitPack::changed(previous, current, 11, diff), 1);
+    QCOMPARE(int(diff[0]), 0x01);
+    QCOMPARE(int(diff[1]), 0x00);
+}
+
+void BitPackTest::nextSetBit()
+{
+    const int count = 700;
+    QVector<uchar> bits(BitPack::byteCount(count), 0);
+    QCOMPARE(BitPack::nextSetBit(bits.constData(), count, 0), -1);
+
+    //sparse bits, more than 64 clear bits between some of them
+    const QList<int> set = {3, 70, 71, 200, 640, 699};
+    for (int i : set)
+        bits[i >> 3] |= uchar(1 << (i & 7));
+    for (int from = 0; from < count; ++from) {
+        int expected = -1;
+        for (int i : set) {
+            if (i >= from) {
+                expected = i;
+                break;
+            }
+        }
+        QCOMPARE(BitPack::nextSetBit(bits.constData(), count, from), expected);
+    }
+    QCOMPARE(BitPack::nextSetBit(bits.constData(), count, -1), -1);
+    QCOMPARE(BitPack::nextSetBit(bits.constData(), count, count), -1);
+}
+
+//padding bits set in the last byte are not reported
+void BitPackTest::nextSetBitStopsAtCount()
+{
+    const uchar bits[3] = {0x00, 0x00, 0xF0};
+    QCOMPARE(BitPack::nextSetBit(bits, 20, 0), -1);
+    QCOMPARE(BitPack::nextSetBit(bits, 21, 0), 20);
+}
+
+QTEST_GUILESS_MAIN(BitPackTest)
+#include "tst_bitpack.moc"
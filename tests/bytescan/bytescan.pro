@@ -0,0 +1,11 @@
+include(../tests.pri)
+
+TARGET = tst_bytescan
+
+SOURCES += \
+    tst_bytescan.cpp \
+    $$COMMMODULE/bytescan.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytescan.h
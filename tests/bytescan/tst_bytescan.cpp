@@ -0,0 +1,132 @@
+#include <QtTest>
+#include "bytescan.h"
+#include "testutil.h"
+
+//delimiter search kernels and their throughput at different frame densities (user-004)
+class ByteScanTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void kernelsAgree_data();
+    void kernelsAgree();
+    void tailsAndAlignment();
+    void indexOfAny_data();
+    void indexOfAny();
+};
+
+//payload bytes never collide with the delimiters, every frameLength-th byte is a '>' and the next one a '<'
+static QByteArray syntheticStream(int size, int frameLength)
+{
+    QByteArray data(size, 0);
+    quint32 seed = 0x2545F491u;
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        char c = static_cast<char>(seed >> 24);
+        if (c == '<' || c == '>')
+            c = 'x';
+        data[i] = c;
+    }
+    for (int i = frameLength - 1; frameLength > 0 && i < size; i += frameLength) {
+        data[i] = '>';
+        if (i + 1 < size)
+            data[i + 1] = '<';
+    }
+    return data;
+}
+
+//walks the whole buffer hit by hit, the way the framing helpers do
+static int countHits(ByteScan::Kernel kernel, const QByteArray &data)
+{
+    int hits = 0;
+    int from = 0;
+    while (from < data.size()) {
+        const int at = ByteScan::indexOfAny(kernel, data.constData() + from, data.size() - from, '<', '>');
+        if (at < 0)
+            break;
+        ++hits;
+        from += at + 1;
+    }
+    return hits;
+}
+
+static const QList<ByteScan::Kernel> allKernels = {ByteScan::Kernel::Scalar, ByteScan::Kernel::Sse2, ByteScan::Kernel::Avx2};
+
+void ByteScanTest::kernelsAgree_data()
+{
+    QTest::addColumn<int>("frameLength");
+    QTest::newRow("no delimiters") << 0;
+    QTest::newRow("every 4 bytes") << 4;
+    QTest::newRow("every 64 bytes") << 64;
+    QTest::newRow("every 1000 bytes") << 1000;
+}
+
+void ByteScanTest::kernelsAgree()
+{
+    QFETCH(int, frameLength);
+    const QByteArray data = syntheticStream(64 * 1024 + 7, frameLength);
+    const int expected = countHits(ByteScan::Kernel::Scalar, data);
+    for (ByteScan::Kernel kernel : allKernels) {
+        if (!ByteScan::supports(kernel))
+            continue;
+        QCOMPARE(countHits(kernel, data), expected);
+    }
+    QCOMPARE(ByteScan::indexOfAny(data.constData(), data.size(), '<', '>'),
+             ByteScan::indexOfAny(ByteScan::Kernel::Scalar, data.constData(), data.size(), '<', '>'));
+}
+
+//a single delimiter at every position of every length up to two AVX2 blocks, at every start offset
+void ByteScanTest::tailsAndAlignment()
+{
+    QByteArray buffer(128, 'x');
+    for (int offset = 0; offset < 32; ++offset) {
+        for (int size = 0; size <= 64; ++size) {
+            const char *data = buffer.constData() + offset;
+            for (ByteScan::Kernel kernel : allKernels)
+                QCOMPARE(ByteScan::indexOfAny(kernel, data, size, '<', '>'), -1);
+            for (int at = 0; at < size; ++at) {
+                buffer[offset + at] = (at & 1) ? '<' : '>';
+                for (ByteScan::Kernel kernel : allKernels) {
+                    if (ByteScan::indexOfAny(kernel, data, size, '<', '>') != at)
+                        QFAIL(qPrintable(QString("kernel %1 offset %2 size %3 at %4")
+                                         .arg(int(kernel)).arg(offset).arg(size).arg(at)));
+                }
+                buffer[offset + at] = 'x';
+            }
+        }
+    }
+}
+
+void ByteScanTest::indexOfAny_data()
+{
+    QTest::addColumn<int>("kernel");
+    QTest::addColumn<int>("frameLength");
+
+    const struct { ByteScan::Kernel kernel; const char *name; } kernels[] = {
+        {ByteScan::Kernel::Scalar, "scalar"}, {ByteScan::Kernel::Sse2, "sse2"}, {ByteScan::Kernel::Avx2, "avx2"}};
+    for (const auto &k : kernels) {
+        if (!ByteScan::supports(k.kernel))
+            continue;
+        for (int frameLength : {8, 64, 512, 0})
+            QTest::newRow(qPrintable(QString("%1, %2").arg(k.name)
+                                     .arg(frameLength ? QString("frame every %1 bytes").arg(frameLength) : QString("no frames"))))
+                    << int(k.kernel) << frameLength;
+    }
+}
+
+void ByteScanTest::indexOfAny()
+{
+    QFETCH(int, kernel);
+    QFETCH(int, frameLength);
+    const QByteArray data = syntheticStream(1024 * 1024, frameLength);
+    int hits = 0;
+    QBENCHMARK {
+        hits = countHits(static_cast<ByteScan::Kernel>(kernel), data);
+    }
+    QVERIFY(hits >= 0);
+    const double mbs = TestUtil::megabytesPerSecond([&]() { countHits(static_cast<ByteScan::Kernel>(kernel), data); }, data.size());
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(mbs, 'f', 0) << "MB/s," << hits << "hits";
+}
+
+QTEST_GUILESS_MAIN(ByteScanTest)
+#include "tst_bytescan.moc"
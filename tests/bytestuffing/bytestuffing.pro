@@ -0,0 +1,18 @@
+include(../tests.pri)
+
+TARGET = tst_bytestuffing
+
+SOURCES += \
+    tst_bytestuffing.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/checksum.cpp \
+    $$COMMMODULE/commmanager.cpp \
+    $$COMMMODULE/crc16.cpp \
+    $$COMMMODULE/framereassembler.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/commmanager.h \
+    $$COMMMODULE/framereassembler.h
@@ -0,0 +1,224 @@
+#include <QtTest>
+#include "bytestuffing.h"
+#include "commmanager.h"
+#include "framereassembler.h"
+#include "testutil.h"
+
+Q_DECLARE_METATYPE(ByteStuffing::Mode)
+
+//COBS/SLIP framing, round trips, resynchronisation and cost against delimiter framing (user-010)
+class ByteStuffingTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void streamAcrossChunks_data();
+    void streamAcrossChunks();
+    void resyncAfterCorruptInput_data();
+    void resyncAfterCorruptInput();
+    void oversizeFrameDropped_data();
+    void oversizeFrameDropped();
+    void decode_data();
+    void decode();
+    void encode_data();
+    void encode();
+};
+
+static void addModeColumn()
+{
+    QTest::addColumn<ByteStuffing::Mode>("mode");
+}
+
+static void addModeRows()
+{
+    addModeColumn();
+    QTest::newRow("COBS") << ByteStuffing::Mode::Cobs;
+    QTest::newRow("SLIP") << ByteStuffing::Mode::Slip;
+}
+
+//payloads that hit the special bytes of both modes and the 254 byte COBS blocks
+static QList<QByteArray> payloads()
+{
+    QList<QByteArray> list = {
+        QByteArray("a"), QByteArray(1, '\0'), QByteArray(3, '\0'), QByteArray("\xC0", 1), QByteArray("\xDB", 1),
+        QByteArray("\xDB\xDC\xC0\xDD\x00\xC0", 6), QByteArray("ab\0cd\0", 6),
+        QByteArray(253, 'x'), QByteArray(254, 'x'), QByteArray(255, 'x'), QByteArray(508, 'x'), QByteArray(1000, '\0')};
+    QByteArray random(3000, 0);
+    quint32 seed = 7;
+    for (int i = 0; i < random.size(); ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        random[i] = static_cast<char>(seed >> 24);
+    }
+    list.append(random);
+    QByteArray withRun = QByteArray(300, 'y');
+    withRun[254] = '\0';
+    list.append(withRun);
+    return list;
+}
+
+static QList<QByteArray> feedChunks(ByteStuffingDecoder &decoder, const QByteArray &stream, int chunk)
+{
+    QList<QByteArray> frames;
+    for (int i = 0; i < stream.size(); i += chunk)
+        frames += decoder.feed(stream.mid(i, chunk));
+    return frames;
+}
+
+void ByteStuffingTest::roundTrip_data()
+{
+    addModeRows();
+}
+
+void ByteStuffingTest::roundTrip()
+{
+    QFETCH(ByteStuffing::Mode, mode);
+    for (const QByteArray &payload : payloads()) {
+        const QByteArray encoded = ByteStuffing::encode(mode, payload);
+        QVERIFY(encoded.size() <= ByteStuffing::maxEncodedSize(mode, payload.size()));
+        //the delimiter only ever closes the frame
+        const char delimiter = mode == ByteStuffing::Mode::Cobs ? '\0' : '\xC0';
+        QCOMPARE(encoded.indexOf(delimiter, mode == ByteStuffing::Mode::Slip ? 1 : 0), encoded.size() - 1);
+
+        const QByteArray body = mode == ByteStuffing::Mode::Cobs ? encoded.left(encoded.size() - 1) : encoded;
+        QCOMPARE(ByteStuffing::decode(mode, body), payload);
+        ByteStuffingDecoder decoder(mode, 8192);
+        QCOMPARE(decoder.feed(encoded), QList<QByteArray>{payload});
+    }
+}
+
+void ByteStuffingTest::streamAcrossChunks_data()
+{
+    addModeRows();
+}
+
+//the same stream fed in any chunking gives the same frames
+void ByteStuffingTest::streamAcrossChunks()
+{
+    QFETCH(ByteStuffing::Mode, mode);
+    const QList<QByteArray> expected = payloads();
+    QByteArray stream;
+    for (const QByteArray &payload : expected)
+        stream += ByteStuffing::encode(mode, payload);
+    for (int chunk : {1, 2, 3, 7, 254, 255, 4096, stream.size()}) {
+        ByteStuffingDecoder decoder(mode, 8192);
+        QCOMPARE(feedChunks(decoder, stream, chunk), expected);
+    }
+}
+
+void ByteStuffingTest::resyncAfterCorruptInput_data()
+{
+    addModeColumn();
+    QTest::addColumn<QByteArray>("garbage");
+    //COBS: a code byte promising more data than arrives before the 0x00
+    QTest::newRow("COBS truncated block") << ByteStuffing::Mode::Cobs << QByteArray("\x09" "ab\0", 4);
+    QTest::newRow("COBS noise") << ByteStuffing::Mode::Cobs << QByteArray("\xFF\x01\x02\x03\0", 5);
+    //SLIP: an escape followed by something other than ESC_END/ESC_ESC
+    QTest::newRow("SLIP bad escape") << ByteStuffing::Mode::Slip << QByteArray("\xC0" "ab\xDB" "x" "cd\xC0", 8);
+    QTest::newRow("SLIP escape before END") << ByteStuffing::Mode::Slip << QByteArray("\xC0" "ab\xDB\xC0", 5);
+}
+
+//a broken frame costs that frame only, the next one decodes, also when the break spans reads
+void ByteStuffingTest::resyncAfterCorruptInput()
+{
+    QFETCH(ByteStuffing::Mode, mode);
+    QFETCH(QByteArray, garbage);
+    const QByteArray good = ByteStuffing::encode(mode, QByteArray("payload\0\xC0\xDB", 10));
+    const QByteArray stream = good + garbage + good;
+    for (int chunk : {1, 2, 3, 5, stream.size()}) {
+        ByteStuffingDecoder decoder(mode, 8192);
+        QList<int> dropped;
+        connect(&decoder, &ByteStuffingDecoder::frameDropped, &decoder, [&](int size) { dropped.append(size); });
+        const QList<QByteArray> frames = feedChunks(decoder, stream, chunk);
+        QCOMPARE(frames.size(), 2);
+        QCOMPARE(frames.at(0), QByteArray("payload\0\xC0\xDB", 10));
+        QCOMPARE(frames.at(1), frames.at(0));
+        QCOMPARE(dropped.size(), 1);
+    }
+}
+
+void ByteStuffingTest::oversizeFrameDropped_data()
+{
+    addModeRows();
+}
+
+void ByteStuffingTest::oversizeFrameDropped()
+{
+    QFETCH(ByteStuffing::Mode, mode);
+    const QByteArray stream = ByteStuffing::encode(mode, QByteArray(65, 'x')) + ByteStuffing::encode(mode, QByteArray(64, 'y'));
+    for (int chunk : {1, 10, stream.size()}) {
+        ByteStuffingDecoder decoder(mode, 64);
+        QCOMPARE(feedChunks(decoder, stream, chunk), QList<QByteArray>{QByteArray(64, 'y')});
+    }
+}
+
+void ByteStuffingTest::decode_data()
+{
+    QTest::addColumn<int>("framing"); //0 delimiters, 1 COBS, 2 SLIP
+    QTest::newRow("delimiters <...> (FrameReassembler)") << 0;
+    QTest::newRow("COBS (ByteStuffingDecoder)") << 1;
+    QTest::newRow("SLIP (ByteStuffingDecoder)") << 2;
+}
+
+//the same text payloads, framed each way and decoded from 4 KiB reads
+void ByteStuffingTest::decode()
+{
+    QFETCH(int, framing);
+    QByteArray stream;
+    int frames = 0;
+    for (int i = 0; i < 2000; ++i) {
+        const QByteArray payload = "value," + QByteArray::number(i * 31) + ",state," + QByteArray(i % 64, 'p');
+        if (framing == 0)
+            stream += "<" + payload + ">";
+        else
+            stream += ByteStuffing::encode(framing == 1 ? ByteStuffing::Mode::Cobs : ByteStuffing::Mode::Slip, payload);
+    }
+    FrameReassembler reassembler('<', '>', 4096);
+    ByteStuffingDecoder decoder(framing == 2 ? ByteStuffing::Mode::Slip : ByteStuffing::Mode::Cobs, 4096);
+    const auto pass = [&]() {
+        frames = 0;
+        for (int i = 0; i < stream.size(); i += 4096) {
+            const QByteArray chunk = stream.mid(i, 4096);
+            frames += framing == 0 ? reassembler.feed(chunk).size() : decoder.feed(chunk).size();
+        }
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(frames, 2000);
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, stream.size()), 'f', 0) << "MB/s";
+}
+
+void ByteStuffingTest::encode_data()
+{
+    QTest::addColumn<int>("framing");
+    QTest::newRow("delimiters <...> (writeFrame)") << 0;
+    QTest::newRow("COBS (writeStuffedFrame)") << 1;
+    QTest::newRow("SLIP (writeStuffedFrame)") << 2;
+}
+
+//one frame at a time into a reused buffer, as the writers do
+void ByteStuffingTest::encode()
+{
+    QFETCH(int, framing);
+    CommManager manager;
+    const QByteArray payload = "value,12345,state," + QByteArray(40, 'p');
+    QByteArray out;
+    const auto pass = [&]() {
+        for (int i = 0; i < 1000; ++i) {
+            if (framing == 0)
+                manager.writeFrame(out, payload, '<', '>');
+            else
+                manager.writeStuffedFrame(out, payload, framing == 1 ? ByteStuffing::Mode::Cobs : ByteStuffing::Mode::Slip);
+        }
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QVERIFY(!out.isEmpty());
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, 1000 * payload.size()), 'f', 0) << "MB/s of payload";
+}
+
+QTEST_GUILESS_MAIN(ByteStuffingTest)
+#include "tst_bytestuffing.moc"
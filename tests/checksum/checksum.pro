@@ -0,0 +1,12 @@
+include(../tests.pri)
+
+TARGET = tst_checksum
+
+SOURCES += \
+    tst_checksum.cpp \
+    $$COMMMODULE/checksum.cpp \
+    $$COMMMODULE/crc16.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/checksum.h
@@ -0,0 +1,147 @@
+#include <QtTest>
+#include "checksum.h"
+#include "testutil.h"
+
+Q_DECLARE_METATYPE(Checksum::Algorithm)
+
+//selectable frame checksums, check values, CRC-32C paths and throughput (user-009)
+class ChecksumTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void checkValues_data();
+    void checkValues();
+    void incrementalMatchesCompute_data();
+    void incrementalMatchesCompute();
+    void wireByteOrder();
+    void crc32cPathsAgree();
+    void throughput_data();
+    void throughput();
+};
+
+static QByteArray testData(int size)
+{
+    QByteArray data(size, 0);
+    quint32 seed = 0x9E3779B9u;
+    for (int i = 0; i < size; ++i) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
+static void addAlgorithmColumn()
+{
+    QTest::addColumn<Checksum::Algorithm>("algorithm");
+}
+
+//catalogue check values over "123456789"
+void ChecksumTest::checkValues_data()
+{
+    addAlgorithmColumn();
+    QTest::addColumn<quint32>("check");
+    QTest::newRow("CRC-16/MODBUS") << Checksum::Algorithm::Crc16Modbus << quint32(0x4B37);
+    QTest::newRow("CRC-16/CCITT-FALSE") << Checksum::Algorithm::Crc16Ccitt << quint32(0x29B1);
+    QTest::newRow("CRC-32C") << Checksum::Algorithm::Crc32c << quint32(0xE3069283);
+}
+
+void ChecksumTest::checkValues()
+{
+    QFETCH(Checksum::Algorithm, algorithm);
+    QFETCH(quint32, check);
+    QCOMPARE(Checksum::compute(algorithm, QByteArray("123456789")), check);
+    QCOMPARE(QByteArray(Checksum::name(algorithm)), QByteArray(QTest::currentDataTag()));
+}
+
+void ChecksumTest::incrementalMatchesCompute_data()
+{
+    addAlgorithmColumn();
+    QTest::newRow("CRC-16/MODBUS") << Checksum::Algorithm::Crc16Modbus;
+    QTest::newRow("CRC-16/CCITT-FALSE") << Checksum::Algorithm::Crc16Ccitt;
+    QTest::newRow("CRC-32C") << Checksum::Algorithm::Crc32c;
+}
+
+//odd chunk sizes so every path has tails to handle
+void ChecksumTest::incrementalMatchesCompute()
+{
+    QFETCH(Checksum::Algorithm, algorithm);
+    const QByteArray data = testData(4099);
+    const quint32 expected = Checksum::compute(algorithm, data);
+    for (int chunk : {1, 3, 7, 8, 13, 64, 1000}) {
+        Checksum sum(algorithm);
+        for (int i = 0; i < data.size(); i += chunk)
+            sum.update(data.mid(i, chunk));
+        QCOMPARE(sum.value(), expected);
+        sum.reset();
+        sum.update(data);
+        QCOMPARE(sum.value(), expected);
+    }
+}
+
+void ChecksumTest::wireByteOrder()
+{
+    char out[4];
+    Checksum::write(Checksum::Algorithm::Crc16Modbus, 0x4B37, out);
+    QCOMPARE(QByteArray(out, 2), QByteArray("\x37\x4B", 2));
+    Checksum::write(Checksum::Algorithm::Crc16Ccitt, 0x29B1, out);
+    QCOMPARE(QByteArray(out, 2), QByteArray("\x29\xB1", 2));
+    Checksum::write(Checksum::Algorithm::Crc32c, 0xE3069283, out);
+    QCOMPARE(QByteArray(out, 4), QByteArray("\x83\x92\x06\xE3", 4));
+    for (Checksum::Algorithm algorithm : {Checksum::Algorithm::Crc16Modbus, Checksum::Algorithm::Crc16Ccitt, Checksum::Algorithm::Crc32c}) {
+        const quint32 value = Checksum::size(algorithm) == 2 ? 0x9283u : 0xE3069283u;
+        Checksum::write(algorithm, value, out);
+        QCOMPARE(Checksum::read(algorithm, out), value);
+    }
+}
+
+//the crc32 instruction and the slice-by-8 tables at every length and alignment around the 8 byte steps
+void ChecksumTest::crc32cPathsAgree()
+{
+    if (!Checksum::supports(Checksum::Crc32cKernel::Sse42))
+        QSKIP("no SSE4.2 on this CPU");
+    const QByteArray data = testData(300);
+    for (int offset = 0; offset < 8; ++offset) {
+        for (int size = 0; size + offset <= data.size(); ++size) {
+            const char *p = data.constData() + offset;
+            if (Checksum::crc32c(Checksum::Crc32cKernel::Table, p, size) != Checksum::crc32c(Checksum::Crc32cKernel::Sse42, p, size))
+                QFAIL(qPrintable(QString("offset %1 size %2").arg(offset).arg(size)));
+        }
+    }
+    QCOMPARE(Checksum::crc32c(Checksum::Crc32cKernel::Table, "123456789", 9), 0xE3069283u);
+    QCOMPARE(Checksum::crc32c(Checksum::Crc32cKernel::Sse42, "123456789", 9), 0xE3069283u);
+    const QByteArray big = testData(1 << 20);
+    QCOMPARE(Checksum::crc32c(Checksum::Crc32cKernel::Sse42, big.constData(), big.size()), Checksum::compute(Checksum::Algorithm::Crc32c, big));
+    QCOMPARE(Checksum::crc32c(Checksum::Crc32cKernel::Table, big.constData(), big.size()), Checksum::compute(Checksum::Algorithm::Crc32c, big));
+}
+
+void ChecksumTest::throughput_data()
+{
+    addAlgorithmColumn();
+    QTest::addColumn<int>("kernel"); // -1 runtime pick, else the forced CRC-32C path
+    QTest::newRow("CRC-16/MODBUS") << Checksum::Algorithm::Crc16Modbus << -1;
+    QTest::newRow("CRC-16/CCITT-FALSE") << Checksum::Algorithm::Crc16Ccitt << -1;
+    QTest::newRow("CRC-32C slice-by-8") << Checksum::Algorithm::Crc32c << int(Checksum::Crc32cKernel::Table);
+    if (Checksum::supports(Checksum::Crc32cKernel::Sse42))
+        QTest::newRow("CRC-32C sse4.2") << Checksum::Algorithm::Crc32c << int(Checksum::Crc32cKernel::Sse42);
+}
+
+void ChecksumTest::throughput()
+{
+    QFETCH(Checksum::Algorithm, algorithm);
+    QFETCH(int, kernel);
+    const QByteArray data = testData(64 * 1024);
+    quint32 value = 0;
+    const auto pass = [&]() {
+        value = kernel < 0 ? Checksum::compute(algorithm, data)
+                           : Checksum::crc32c(static_cast<Checksum::Crc32cKernel>(kernel), data.constData(), data.size());
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(value, Checksum::compute(algorithm, data));
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, data.size()), 'f', 0) << "MB/s";
+}
+
+QTEST_GUILESS_MAIN(ChecksumTest)
+#include "tst_checksum.moc"
@@ -0,0 +1,50 @@
+#include "alloccounter.h"
+#include <atomic>
+#include <cstdlib>
+
+#if defined(Q_OS_LINUX) && defined(__GLIBC__)
+#define ALLOC_COUNTER_HOOKS
+#endif
+
+static std::atomic<quint64> allocCalls(0);
+
+#ifdef ALLOC_COUNTER_HOOKS
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *p, size_t size);
+void __libc_free(void *p);
+
+//glibc lets a program replace the malloc family as long as all four are defined
+void *malloc(size_t size) noexcept {
+    allocCalls.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) noexcept {
+    allocCalls.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) noexcept {
+    allocCalls.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+void free(void *p) noexcept {
+    __libc_free(p);
+}
+}
+#endif
+
+bool AllocCounter::isActive() {
+#ifdef ALLOC_COUNTER_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+quint64 AllocCounter::count() {
+    return allocCalls.load(std::memory_order_relaxed);
+}
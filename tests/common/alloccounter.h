@@ -0,0 +1,23 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <QtGlobal>
+
+//counts heap allocations of the whole test binary. QByteArray/QVector allocate with malloc and
+//operator new ends there too, so alloccounter.cpp wraps malloc/calloc/realloc (glibc only)
+namespace AllocCounter {
+    bool isActive(); //false where the hooks are not available, tests skip then
+    quint64 count();
+
+    //allocations made while the scope is alive
+    class Scope
+    {
+    public:
+        Scope() : start(count()) {}
+        quint64 allocations() const { return count() - start; }
+    private:
+        quint64 start;
+    };
+}
+
+#endif // ALLOCCOUNTER_H
@@ -0,0 +1,90 @@
+#ifndef PTYPAIR_H
+#define PTYPAIR_H
+
+#include <QByteArray>
+#include <QString>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdlib>
+#endif
+
+//pseudo terminal pair standing in for a serial line, the code under test opens slaveName()
+//like a tty and the test plays the device on the master side. line speed is only bookkeeping
+//on a pty, bytes arrive as fast as they are written.
+class PtyPair
+{
+public:
+    PtyPair()
+    {
+#ifdef Q_OS_LINUX
+        master = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (master >= 0 && (::grantpt(master) != 0 || ::unlockpt(master) != 0)) {
+            ::close(master);
+            master = -1;
+        }
+        if (master >= 0)
+            slave = QString::fromLocal8Bit(::ptsname(master));
+#endif
+    }
+    ~PtyPair()
+    {
+#ifdef Q_OS_LINUX
+        if (master >= 0)
+            ::close(master);
+#endif
+    }
+    PtyPair(const PtyPair &) = delete;
+    PtyPair &operator=(const PtyPair &) = delete;
+
+    bool isValid() const { return master >= 0; }
+    int masterFd() const { return master; }
+    QString slaveName() const { return slave; }
+    std::string slavePath() const { return slave.toStdString(); }
+
+    //the device sends, false if the pty buffer did not take everything
+    bool write(const QByteArray &data)
+    {
+#ifdef Q_OS_LINUX
+        int offset = 0;
+        while (offset < data.size()) {
+            const ssize_t n = ::write(master, data.constData() + offset, static_cast<size_t>(data.size() - offset));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            offset += static_cast<int>(n);
+        }
+        return true;
+#else
+        Q_UNUSED(data);
+        return false;
+#endif
+    }
+
+    //what the code under test sent so far, never blocks
+    QByteArray readAll()
+    {
+        QByteArray data;
+#ifdef Q_OS_LINUX
+        char chunk[4096];
+        for (;;) {
+            const ssize_t n = ::read(master, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                break;
+            data.append(chunk, static_cast<int>(n));
+        }
+#endif
+        return data;
+    }
+
+private:
+    int master = -1;
+    QString slave;
+};
+
+#endif // PTYPAIR_H
@@ -0,0 +1,88 @@
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#include <unistd.h>
+#include <cstdio>
+#include <ctime>
+#endif
+
+namespace TestUtil {
+
+//run the event loop until condition() holds, unlike QTRY_* there is no 50 ms poll step,
+//so wall clock measurements around it stay accurate
+inline bool waitUntil(const std::function<bool()> &condition, int timeoutMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+    while (!condition()) {
+        if (clock.elapsed() > timeoutMs)
+            return false;
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+    }
+    return true;
+}
+
+//runs pass() for about minMs and returns the rate in MB/s, for a throughput line next to QBENCHMARK
+inline double megabytesPerSecond(const std::function<void()> &pass, qint64 bytesPerPass, int minMs = 200)
+{
+    QElapsedTimer clock;
+    clock.start();
+    qint64 passes = 0;
+    do {
+        pass();
+        ++passes;
+    } while (clock.elapsed() < minMs);
+    return double(passes) * bytesPerPass / (clock.nsecsElapsed() / 1e9) / 1e6;
+}
+
+//a few hundred sockets on each side are over the usual 1024 soft limit
+inline void raiseFileLimit()
+{
+#ifdef Q_OS_LINUX
+    rlimit limit;
+    if (::getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &limit);
+    }
+#endif
+}
+
+//CPU time of the whole process in us, all threads
+inline qint64 processCpuUs()
+{
+#ifdef Q_OS_LINUX
+    timespec now;
+    ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+#else
+    return 0;
+#endif
+}
+
+//resident set size of the process in bytes, 0 where /proc is not available
+inline qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    long pages = 0;
+    long resident = 0;
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm)
+        return 0;
+    const int fields = std::fscanf(statm, "%ld %ld", &pages, &resident);
+    std::fclose(statm);
+    return fields == 2 ? static_cast<qint64>(resident) * ::sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+}
+
+#endif // TESTUTIL_H
@@ -0,0 +1,20 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_connectionmanager
+
+SOURCES += \
+    tst_connectionmanager.cpp \
+    $$COMMMODULE/iothread.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/reconnectpolicy.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/tcpconnectionmanager.cpp \
+    $$COMMMODULE/tcpendpointgroup.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/iothread.h \
+    $$COMMMODULE/tcpconnectionmanager.h \
+    $$COMMMODULE/tcpendpointgroup.h
@@ -0,0 +1,140 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QVector>
+#include "tcpconnectionmanager.h"
+#include "latencyhistogram.h"
+#include "testutil.h"
+
+//TcpConnectionManager with hundreds of endpoints against local loopback listeners:
+//staggered startup, memory per connection, event loop latency of the I/O threads (user-016)
+class ConnectionManagerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void hundredsOfEndpoints();
+};
+
+//echoes everything and can drop all its connections at once
+class EchoListener : public QTcpServer
+{
+public:
+    explicit EchoListener(QObject *parent = nullptr) : QTcpServer(parent)
+    {
+        connect(this, &QTcpServer::newConnection, this, [this]() {
+            while (QTcpSocket *socket = nextPendingConnection()) {
+                sockets.append(socket);
+                connect(socket, &QTcpSocket::readyRead, socket, [socket]() { socket->write(socket->readAll()); });
+            }
+        });
+    }
+
+    void dropAll()
+    {
+        for (QTcpSocket *socket : sockets)
+            socket->abort();
+        qDeleteAll(sockets);
+        sockets.clear();
+    }
+
+    QList<QTcpSocket *> sockets;
+};
+
+void ConnectionManagerTest::initTestCase()
+{
+    TestUtil::raiseFileLimit();
+}
+
+void ConnectionManagerTest::hundredsOfEndpoints()
+{
+    const int endpointCount = 400;
+    const int listenerCount = 8;
+    const int messageSize = 64;
+
+    QVector<EchoListener *> listeners;
+    QObject owner;
+    for (int i = 0; i < listenerCount; ++i) {
+        EchoListener *listener = new EchoListener(&owner);
+        QVERIFY(listener->listen(QHostAddress::LocalHost, 0));
+        listeners.append(listener);
+    }
+
+    TcpConnectionManager manager(2);
+    manager.setStartupRate(32);
+    manager.setTickInterval(10);
+    manager.setReconnectInterval(100);
+
+    QHash<int, qint64> received;
+    QHash<int, int> connects;
+    connect(&manager, &TcpConnectionManager::dataReceived, &manager, [&](int id, const QByteArray &data) {
+        received[id] += data.size();
+    });
+    connect(&manager, &TcpConnectionManager::endpointStateChanged, &manager, [&](int id, TcpEndpointState state) {
+        if (state == TcpEndpointState::Connected)
+            ++connects[id];
+    });
+    auto connectedCount = [&]() {
+        int connected = 0;
+        for (int id : manager.endpointIds())
+            connected += manager.stats(id).state == TcpEndpointState::Connected ? 1 : 0;
+        return connected;
+    };
+
+    const qint64 residentBefore = TestUtil::residentBytes();
+    for (int i = 0; i < endpointCount; ++i)
+        manager.addEndpoint("127.0.0.1", listeners[i % listenerCount]->serverPort());
+    QElapsedTimer clock;
+    clock.start();
+    manager.start();
+    QVERIFY2(TestUtil::waitUntil([&]() { return connectedCount() == endpointCount; }, 30000),
+             qPrintable(QString("%1 of %2 endpoints connected").arg(connectedCount()).arg(endpointCount)));
+    const qint64 startupMs = clock.elapsed();
+    // both ends of every connection live in this process, so this is an upper bound per endpoint
+    const qint64 residentPerEndpoint = (TestUtil::residentBytes() - residentBefore) / endpointCount;
+
+    //every endpoint sends and waits for the echo, the I/O threads do the socket work
+    manager.resetLoopLatency();
+    const QByteArray message(messageSize, 'e');
+    LatencyHistogram roundTrip;
+    const int rounds = 10;
+    for (int round = 0; round < rounds; ++round) {
+        const qint64 sentNs = clock.nsecsElapsed();
+        for (int id : manager.endpointIds())
+            manager.sendData(id, message);
+        const qint64 target = qint64(round + 1) * messageSize;
+        QVERIFY(TestUtil::waitUntil([&]() {
+            for (int id : manager.endpointIds()) {
+                if (received.value(id) < target)
+                    return false;
+            }
+            return true;
+        }, 10000));
+        roundTrip.record((clock.nsecsElapsed() - sentNs) / 1000);
+    }
+
+    //all gateways drop at once, the shared timers bring them back
+    clock.restart();
+    for (EchoListener *listener : listeners)
+        listener->dropAll();
+    QVERIFY(TestUtil::waitUntil([&]() {
+        for (int id : manager.endpointIds()) {
+            if (connects.value(id) < 2 || manager.stats(id).state != TcpEndpointState::Connected)
+                return false;
+        }
+        return true;
+    }, 30000));
+    const qint64 recoveryMs = clock.elapsed();
+
+    qInfo().noquote() << QString("%1 endpoints on %2 I/O threads: connected in %3 ms, reconnected in %4 ms, ~%5 KiB resident per endpoint")
+                         .arg(endpointCount).arg(manager.ioThreadCount()).arg(startupMs).arg(recoveryMs)
+                         .arg(residentPerEndpoint / 1024.0, 0, 'f', 1);
+    qInfo().noquote() << QString("timer lateness: max %1 us, average %2 us").arg(manager.maxLoopLatencyUs()).arg(manager.averageLoopLatencyUs());
+    qInfo().noquote() << "all endpoints echo round" << roundTrip.toString();
+    QVERIFY2(manager.maxLoopLatencyUs() < 500000, "I/O thread timer ran more than 500 ms late");
+    manager.stop();
+}
+
+QTEST_GUILESS_MAIN(ConnectionManagerTest)
+#include "tst_connectionmanager.moc"
@@ -0,0 +1,11 @@
+include(../tests.pri)
+
+TARGET = tst_crc16
+
+SOURCES += \
+    tst_crc16.cpp \
+    $$COMMMODULE/crc16.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/crc16.h
@@ -0,0 +1,99 @@
+#include <QtTest>
+#include "crc16.h"
+#include "testutil.h"
+
+//slice-by-8 CRC-16/IBM against the bit-by-bit loop it replaced (user-001)
+class Crc16Test : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void checkValue();
+    void matchesBitwise();
+    void chunkedUpdatesMatchCompute();
+    void throughput_data();
+    void throughput();
+};
+
+//the former CommManager::calculateCRC
+static quint16 bitwiseCrc(const char *data, int size)
+{
+    quint16 crc = 0xFFFF;
+    for (int n = 0; n < size; ++n) {
+        crc ^= static_cast<quint8>(data[n]);
+        for (int i = 0; i < 8; ++i) {
+            if (crc & 0x0001)
+                crc = (crc >> 1) ^ 0xA001;
+            else
+                crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+static QByteArray pattern(int size)
+{
+    QByteArray data(size, 0);
+    quint32 x = 0x12345678;
+    for (int i = 0; i < size; ++i) {
+        x = x * 1103515245u + 12345u;
+        data[i] = static_cast<char>(x >> 24);
+    }
+    return data;
+}
+
+void Crc16Test::checkValue()
+{
+    QCOMPARE(Crc16::compute("123456789", 9), quint16(0x4B37));
+    QCOMPARE(Crc16::compute(QByteArray()), quint16(Crc16::InitialValue));
+}
+
+//every length from 0 to 100 covers the 8 byte steps and all tail lengths
+void Crc16Test::matchesBitwise()
+{
+    const QByteArray data = pattern(100);
+    for (int size = 0; size <= data.size(); ++size)
+        QCOMPARE(Crc16::compute(data.constData(), size), bitwiseCrc(data.constData(), size));
+}
+
+void Crc16Test::chunkedUpdatesMatchCompute()
+{
+    const QByteArray data = pattern(4096);
+    const quint16 whole = Crc16::compute(data);
+    for (int chunk = 1; chunk <= 17; ++chunk) {
+        quint16 crc = Crc16::InitialValue;
+        for (int offset = 0; offset < data.size(); offset += chunk)
+            crc = Crc16::update(crc, data.constData() + offset, qMin(chunk, data.size() - offset));
+        QCOMPARE(crc, whole);
+    }
+    QCOMPARE(Crc16::update(Crc16::update(Crc16::InitialValue, data.left(1000)), data.mid(1000)), whole);
+}
+
+void Crc16Test::throughput_data()
+{
+    QTest::addColumn<bool>("sliced");
+    QTest::addColumn<int>("size");
+    QTest::newRow("slice-by-8, 256 B") << true << 256;
+    QTest::newRow("bitwise, 256 B") << false << 256;
+    QTest::newRow("slice-by-8, 64 KiB") << true << 65536;
+    QTest::newRow("bitwise, 64 KiB") << false << 65536;
+}
+
+void Crc16Test::throughput()
+{
+    QFETCH(bool, sliced);
+    QFETCH(int, size);
+    const QByteArray data = pattern(size);
+    volatile quint16 sink = 0;
+    auto pass = [&]() {
+        sink = sliced ? Crc16::compute(data.constData(), size) : bitwiseCrc(data.constData(), size);
+    };
+    QBENCHMARK {
+        pass();
+    }
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, size), 'f', 0) << "MB/s";
+    Q_UNUSED(sink);
+}
+
+QTEST_GUILESS_MAIN(Crc16Test)
+#include "tst_crc16.moc"
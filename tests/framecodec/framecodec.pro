@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+TARGET = tst_framecodec
+
+SOURCES += \
+    tst_framecodec.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/checksum.cpp \
+    $$COMMMODULE/commmanager.cpp \
+    $$COMMMODULE/crc16.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/commmanager.h \
+    $$COMMMODULE/framecodec.h
@@ -0,0 +1,214 @@
+#include <QtTest>
+#include "commmanager.h"
+#include "framecodec.h"
+#include "testutil.h"
+
+typedef FrameCodec<'$', '#', ','> Codec;
+
+//compile time FrameCodec against the runtime CommManager helpers, same output and side by side cost (user-007)
+class FrameCodecTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitMatches_data();
+    void splitMatches();
+    void encodeMatches();
+    void fieldsMatch();
+    void crcMatches();
+    void split_data();
+    void split();
+    void encode_data();
+    void encode();
+    void crc_data();
+    void crc();
+
+private:
+    CommManager manager;
+};
+
+static QList<QByteArray> toFrames(const QByteArray &buffer, const QVector<FrameView> &views)
+{
+    QList<QByteArray> frames;
+    for (const FrameView &view : views)
+        frames.append(buffer.mid(view.offset, view.length));
+    return frames;
+}
+
+//a long run of frames with noise in between, enough to keep the vector loops busy
+static QByteArray burst(int frames)
+{
+    QByteArray buffer;
+    for (int i = 0; i < frames; ++i) {
+        buffer += "noise";
+        buffer += "$,";
+        buffer += QByteArray::number(i * 37);
+        buffer += ",payload-";
+        buffer += QByteArray(i % 40, 'x');
+        buffer += "#";
+    }
+    return buffer;
+}
+
+void FrameCodecTest::splitMatches_data()
+{
+    QTest::addColumn<QByteArray>("buffer");
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("single") << QByteArray("$,1,2#");
+    QTest::newRow("noise around") << QByteArray("ab$,1#cd$,2#ef");
+    QTest::newRow("start restarts frame") << QByteArray("$,1$,2#");
+    QTest::newRow("stray end") << QByteArray("#$,1##");
+    QTest::newRow("unterminated tail") << QByteArray("$,1#$,2");
+    QTest::newRow("empty frame") << QByteArray("$#");
+    QTest::newRow("burst") << burst(200);
+}
+
+void FrameCodecTest::splitMatches()
+{
+    QFETCH(QByteArray, buffer);
+    QVector<FrameView> codecViews;
+    QVector<FrameView> managerViews;
+    Codec::split(buffer, codecViews);
+    manager.splitFrameViews(buffer, '$', '#', managerViews);
+    QCOMPARE(toFrames(buffer, codecViews), toFrames(buffer, managerViews));
+    QCOMPARE(toFrames(buffer, codecViews), manager.splitFrames(buffer, '$', '#'));
+}
+
+void FrameCodecTest::encodeMatches()
+{
+    for (const QByteArray &payload : {QByteArray("x"), QByteArray("hello"), QByteArray(1000, 'p')})
+        QCOMPARE(Codec::encode(payload), manager.addFrameDelimiter(payload, '$', '#'));
+
+    const QList<QList<QByteArray>> fieldSets = {{"1"}, {"1", "22", "333"}, {"", "", ""}, {QByteArray(300, 'f'), "x"}};
+    for (const QList<QByteArray> &fields : fieldSets)
+        QCOMPARE(Codec::encode(fields), manager.addFrameDelimiter(fields, '$', '#', ','));
+
+    //the one difference: the runtime helpers reject an empty payload, the codec frames it as "$#"
+    QCOMPARE(Codec::encode(QByteArray()), QByteArray("$#"));
+    QVERIFY(manager.addFrameDelimiter(QByteArray(), '$', '#').isEmpty());
+
+    //the reusable out buffer form matches writeFrame
+    QByteArray codecOut;
+    QByteArray managerOut;
+    Codec::encode(fieldSets.at(2), codecOut);
+    manager.writeFrame(managerOut, fieldSets.at(2), '$', '#', ',');
+    QCOMPARE(codecOut, managerOut);
+}
+
+void FrameCodecTest::fieldsMatch()
+{
+    for (const QByteArray &frame : {QByteArray("$,1,22,333#"), QByteArray("$#"), QByteArray("$abc#"), QByteArray("x$,,#y"), QByteArray("no frame")}) {
+        QVector<FrameView> codecFields;
+        QVector<FrameView> managerFields;
+        Codec::fields(frame, codecFields);
+        manager.stripFrameDelimiterViews(frame, '$', '#', ',', managerFields);
+        QCOMPARE(toFrames(frame, codecFields), toFrames(frame, managerFields));
+
+        const FrameView codecBody = Codec::payload(frame);
+        const FrameView managerBody = manager.stripFrameDelimiterView(frame, '$', '#');
+        QCOMPARE(codecBody.isValid(), managerBody.isValid());
+        if (codecBody.isValid())
+            QCOMPARE(frame.mid(codecBody.offset, codecBody.length), frame.mid(managerBody.offset, managerBody.length));
+    }
+}
+
+//FrameCodec always uses CRC-16/IBM, the CommManager default
+void FrameCodecTest::crcMatches()
+{
+    QCOMPARE(Codec::crc("123456789", 9), quint16(0x4B37));
+    const QByteArray data = burst(50);
+    for (int size : {0, 1, 3, 4, 5, 63, data.size()}) {
+        const QByteArray part = data.left(size);
+        QCOMPARE(Codec::crc(part.constData(), part.size()), manager.calculateCRC(part));
+        QByteArray framed = part;
+        Codec::appendCrc(framed);
+        QCOMPARE(framed, manager.appendCRC(part));
+        QCOMPARE(Codec::validateCrc(framed.constData(), framed.size()), manager.validateCRC(framed));
+        framed[0] = char(framed.at(0) ^ 0x01);
+        QCOMPARE(Codec::validateCrc(framed.constData(), framed.size()), manager.validateCRC(framed));
+    }
+}
+
+void FrameCodecTest::split_data()
+{
+    QTest::addColumn<int>("path");
+    QTest::newRow("FrameCodec::split") << 0;
+    QTest::newRow("CommManager::splitFrameViews") << 1;
+    QTest::newRow("CommManager::splitFrames") << 2;
+}
+
+void FrameCodecTest::split()
+{
+    QFETCH(int, path);
+    const QByteArray buffer = burst(2000);
+    QVector<FrameView> views;
+    int frames = 0;
+    const auto pass = [&]() {
+        if (path == 0)
+            frames = Codec::split(buffer, views);
+        else if (path == 1)
+            frames = manager.splitFrameViews(buffer, '$', '#', views);
+        else
+            frames = manager.splitFrames(buffer, '$', '#').size();
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(frames, 2000);
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, buffer.size()), 'f', 0) << "MB/s";
+}
+
+void FrameCodecTest::encode_data()
+{
+    QTest::addColumn<int>("path");
+    QTest::newRow("FrameCodec::encode") << 0;
+    QTest::newRow("CommManager::writeFrame") << 1;
+    QTest::newRow("CommManager::addFrameDelimiter") << 2;
+}
+
+void FrameCodecTest::encode()
+{
+    QFETCH(int, path);
+    const QList<QByteArray> fields = {"1234", "-56", "temperature", "7.25", "ok"};
+    QByteArray out;
+    const auto pass = [&]() {
+        for (int i = 0; i < 1000; ++i) {
+            if (path == 0)
+                Codec::encode(fields, out);
+            else if (path == 1)
+                manager.writeFrame(out, fields, '$', '#', ',');
+            else
+                out = manager.addFrameDelimiter(fields, '$', '#', ',');
+        }
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(out, QByteArray("$,1234,-56,temperature,7.25,ok#"));
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, 1000 * out.size()), 'f', 0) << "MB/s";
+}
+
+void FrameCodecTest::crc_data()
+{
+    QTest::addColumn<bool>("codec");
+    QTest::newRow("FrameCodec::crc") << true;
+    QTest::newRow("CommManager::calculateCRC") << false;
+}
+
+void FrameCodecTest::crc()
+{
+    QFETCH(bool, codec);
+    const QByteArray data = burst(2000);
+    quint16 value = 0;
+    const auto pass = [&]() {
+        value = codec ? Codec::crc(data.constData(), data.size()) : manager.calculateCRC(data);
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(value, manager.calculateCRC(data));
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, data.size()), 'f', 0) << "MB/s";
+}
+
+QTEST_GUILESS_MAIN(FrameCodecTest)
+#include "tst_framecodec.moc"
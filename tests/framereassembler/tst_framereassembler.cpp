@@ -0,0 +1,154 @@
+#include <QtTest>
+#include "framereassembler.h"
+#include "serial.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+//stream reassembly of <...> frames across reads (user-002)
+class FrameReassemblerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void splitAcrossChunks_data();
+    void splitAcrossChunks();
+    void startByteRestartsFrame();
+    void exactSizeLimit_data();
+    void exactSizeLimit();
+    void clearFramingFromFrameSlot();
+    void setFramingFromFrameSlot();
+};
+
+//feeds the chunks one by one and collects what frameReady delivered
+static QList<QByteArray> feedAll(FrameReassembler &reassembler, const QList<QByteArray> &chunks, QList<int> *dropped = nullptr)
+{
+    QList<QByteArray> emitted;
+    QObject receiver;
+    QObject::connect(&reassembler, &FrameReassembler::frameReady, &receiver, [&](const QByteArray &frame) { emitted.append(frame); });
+    if (dropped)
+        QObject::connect(&reassembler, &FrameReassembler::frameDropped, &receiver, [dropped](int size) { dropped->append(size); });
+    QList<QByteArray> returned;
+    for (const QByteArray &chunk : chunks)
+        returned += reassembler.feed(chunk);
+    if (returned != emitted)
+        qWarning() << "feed() returned" << returned << "but emitted" << emitted;
+    return emitted;
+}
+
+void FrameReassemblerTest::splitAcrossChunks_data()
+{
+    QTest::addColumn<QList<QByteArray>>("chunks");
+    QTest::addColumn<QList<QByteArray>>("frames");
+
+    QTest::newRow("whole") << QList<QByteArray>{"<ab>"} << QList<QByteArray>{"<ab>"};
+    QTest::newRow("split in the payload") << QList<QByteArray>{"<a", "b>"} << QList<QByteArray>{"<ab>"};
+    QTest::newRow("one byte per chunk") << QList<QByteArray>{"<", "a", "b", ">"} << QList<QByteArray>{"<ab>"};
+    QTest::newRow("two frames, split between them") << QList<QByteArray>{"<1><", "2>"} << QList<QByteArray>{"<1>", "<2>"};
+    QTest::newRow("noise before and between") << QList<QByteArray>{"xx<1>y", "y<2", ">z"} << QList<QByteArray>{"<1>", "<2>"};
+    QTest::newRow("end byte without start") << QList<QByteArray>{">", "<1>"} << QList<QByteArray>{"<1>"};
+}
+
+void FrameReassemblerTest::splitAcrossChunks()
+{
+    QFETCH(QList<QByteArray>, chunks);
+    QFETCH(QList<QByteArray>, frames);
+    FrameReassembler reassembler('<', '>');
+    QCOMPARE(feedAll(reassembler, chunks), frames);
+    QCOMPARE(reassembler.pendingBytes(), 0);
+}
+
+//a start byte inside a frame drops what came before it, in the same chunk or from an earlier one
+void FrameReassemblerTest::startByteRestartsFrame()
+{
+    FrameReassembler reassembler('<', '>');
+    QCOMPARE(feedAll(reassembler, {"<ab<cd>"}), QList<QByteArray>{"<cd>"});
+    QCOMPARE(feedAll(reassembler, {"<ab", "c<d", "e>"}), QList<QByteArray>{"<de>"});
+}
+
+void FrameReassemblerTest::exactSizeLimit_data()
+{
+    QTest::addColumn<QList<QByteArray>>("chunks");
+    QTest::addColumn<bool>("accepted");
+
+    // limit 6 bytes including both delimiters
+    QTest::newRow("at the limit") << QList<QByteArray>{"<abcd>"} << true;
+    QTest::newRow("at the limit, split") << QList<QByteArray>{"<abc", "d>"} << true;
+    QTest::newRow("end byte one past the limit") << QList<QByteArray>{"<abcde>"} << false;
+    QTest::newRow("end byte one past the limit, own chunk") << QList<QByteArray>{"<abcde", ">"} << false;
+    QTest::newRow("payload past the limit") << QList<QByteArray>{"<abcdefgh>"} << false;
+}
+
+void FrameReassemblerTest::exactSizeLimit()
+{
+    QFETCH(QList<QByteArray>, chunks);
+    QFETCH(bool, accepted);
+    FrameReassembler reassembler('<', '>', 6);
+    QList<int> dropped;
+    const QList<QByteArray> frames = feedAll(reassembler, chunks, &dropped);
+    QCOMPARE(frames.size(), accepted ? 1 : 0);
+    QCOMPARE(dropped.size(), accepted ? 0 : 1);
+    if (!accepted)
+        QCOMPARE(dropped.first(), 7);
+    QCOMPARE(reassembler.pendingBytes(), 0);
+
+    //the stream goes on normally afterwards
+    QCOMPARE(feedAll(reassembler, {"<ok>"}), QList<QByteArray>{"<ok>"});
+}
+
+//the framer is inside feed() while the slot runs, the rest of the chunk must not be delivered
+void FrameReassemblerTest::clearFramingFromFrameSlot()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 115200));
+    serial.setFraming('<', '>');
+    QList<QByteArray> frames;
+    int chunks = 0;
+    connect(&serial, &Serial::frameReady, &serial, [&](const QByteArray &frame) {
+        frames.append(frame);
+        serial.clearFraming();
+    });
+    connect(&serial, &Serial::dataReady, &serial, [&](const QByteArray &) { ++chunks; });
+
+    QVERIFY(pty.write("<1><2><3>"));
+    QVERIFY(TestUtil::waitUntil([&]() { return !frames.isEmpty(); }, 2000));
+    QTest::qWait(20);
+    QCOMPARE(frames, QList<QByteArray>{"<1>"});
+
+    QVERIFY(pty.write("<4>"));
+    QVERIFY(TestUtil::waitUntil([&]() { return chunks >= 2; }, 2000));
+    QCOMPARE(frames.size(), 1); // framing stays off
+}
+
+//switching to byte stuffing from the slot releases the reassembler the same way
+void FrameReassemblerTest::setFramingFromFrameSlot()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 115200));
+    serial.setFraming('<', '>');
+    QList<QByteArray> frames;
+    connect(&serial, &Serial::frameReady, &serial, [&](const QByteArray &frame) {
+        frames.append(frame);
+        if (frames.size() == 1)
+            serial.setFraming(ByteStuffing::Mode::Slip);
+    });
+
+    QVERIFY(pty.write("<1><2>"));
+    QVERIFY(TestUtil::waitUntil([&]() { return !frames.isEmpty(); }, 2000));
+    QVERIFY(pty.write(QByteArray("slip\xC0", 5)));
+    QVERIFY(TestUtil::waitUntil([&]() { return frames.size() == 2; }, 2000));
+    QCOMPARE(frames.at(0), QByteArray("<1>"));
+    QCOMPARE(frames.at(1), QByteArray("slip"));
+}
+
+QTEST_GUILESS_MAIN(FrameReassemblerTest)
+#include "tst_framereassembler.moc"
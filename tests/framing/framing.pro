@@ -0,0 +1,16 @@
+include(../tests.pri)
+
+TARGET = tst_framing
+
+SOURCES += \
+    tst_framing.cpp \
+    $$PWD/../common/alloccounter.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/checksum.cpp \
+    $$COMMMODULE/commmanager.cpp \
+    $$COMMMODULE/crc16.cpp
+
+HEADERS += \
+    $$PWD/../common/alloccounter.h \
+    $$COMMMODULE/commmanager.h
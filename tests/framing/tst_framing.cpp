@@ -0,0 +1,141 @@
+#include <QtTest>
+#include "commmanager.h"
+#include "alloccounter.h"
+#include <climits>
+
+//view based framing and integer parsing (user-003)
+class FramingTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void parseInteger_data();
+    void parseInteger();
+    void viewsMatchCopyingHelpers();
+    void burstDecodesWithoutAllocating();
+    void writersAcceptOutAsPayload();
+};
+
+void FramingTest::parseInteger_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("ok");
+    QTest::addColumn<int>("value");
+
+    QTest::newRow("plain") << QByteArray("1234") << true << 1234;
+    QTest::newRow("signs and spaces") << QByteArray(" \t-42 \r\n") << true << -42;
+    QTest::newRow("plus") << QByteArray("+7") << true << 7;
+    QTest::newRow("int max") << QByteArray("2147483647") << true << INT_MAX;
+    QTest::newRow("int min") << QByteArray("-2147483648") << true << INT_MIN;
+    QTest::newRow("overflow") << QByteArray("2147483648") << false << 0;
+    QTest::newRow("underflow") << QByteArray("-2147483649") << false << 0;
+    QTest::newRow("sign only") << QByteArray("-") << false << 0;
+    QTest::newRow("inner space") << QByteArray("1 2") << false << 0;
+    QTest::newRow("empty") << QByteArray("") << false << 0;
+}
+
+void FramingTest::parseInteger()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(bool, ok);
+    QFETCH(int, value);
+
+    CommManager comm;
+    int parsed = 0;
+    QCOMPARE(comm.parseInteger(text.constData(), text.size(), &parsed), ok);
+    if (ok)
+        QCOMPARE(parsed, value);
+}
+
+void FramingTest::viewsMatchCopyingHelpers()
+{
+    CommManager comm;
+    const QByteArray buffer("xx<1,-2,3>noise<40,50><>");
+
+    const QList<QByteArray> frames = comm.splitFrames(buffer, '<', '>');
+    QVector<FrameView> views;
+    QCOMPARE(comm.splitFrameViews(buffer, '<', '>', views), frames.size());
+    for (int i = 0; i < views.size(); ++i)
+        QCOMPARE(buffer.mid(views[i].offset, views[i].length), frames[i]);
+
+    QVector<FrameView> fields;
+    for (int i = 0; i < views.size(); ++i) {
+        const QList<QByteArray> copied = comm.stripFrameDelimiter(frames[i], '<', '>', ',');
+        QCOMPARE(comm.stripFrameDelimiterViews(buffer, views[i], '<', '>', ',', fields), copied.size());
+        for (int f = 0; f < fields.size(); ++f)
+            QCOMPARE(buffer.mid(fields[f].offset, fields[f].length), copied[f]);
+    }
+}
+
+//hundreds of frames from one read, decoded with the view API into warm vectors
+void FramingTest::burstDecodesWithoutAllocating()
+{
+    if (!AllocCounter::isActive())
+        QSKIP("allocation hooks need glibc");
+
+    CommManager comm;
+    QByteArray buffer;
+    const int frameCount = 500;
+    for (int i = 0; i < frameCount; ++i)
+        buffer += "<" + QByteArray::number(i) + ",-" + QByteArray::number(i * 3) + "," + QByteArray::number(i * 7) + ">";
+
+    QVector<FrameView> frames;
+    QVector<FrameView> fields;
+    frames.reserve(frameCount);
+    fields.reserve(8);
+
+    qint64 sum = 0;
+    quint64 allocations = 0;
+    for (int round = 0; round < 3; ++round) {
+        AllocCounter::Scope scope;
+        sum = 0;
+        const int found = comm.splitFrameViews(buffer, '<', '>', frames);
+        for (const FrameView &frame : frames) {
+            comm.stripFrameDelimiterViews(buffer, frame, '<', '>', ',', fields);
+            for (const FrameView &field : fields) {
+                int value = 0;
+                if (comm.extractIntegerValue(buffer, field, &value))
+                    sum += value;
+            }
+        }
+        allocations = scope.allocations();
+        QCOMPARE(found, frameCount);
+    }
+
+    qint64 expected = 0;
+    for (int i = 0; i < frameCount; ++i)
+        expected += i - i * 3 + i * 7;
+    QCOMPARE(sum, expected);
+    qInfo() << frameCount << "frames," << buffer.size() << "bytes," << allocations << "allocations";
+    QCOMPARE(allocations, quint64(0));
+}
+
+//writeFrame(buf, buf) and friends frame the buffer in place (user-008)
+void FramingTest::writersAcceptOutAsPayload()
+{
+    CommManager comm;
+    const QByteArray payload("0123456789abcdef0123456789abcdef");
+
+    QByteArray buffer = payload;
+    buffer.reserve(256); // no reallocation, the payload really is moved inside the buffer
+    comm.writeFrame(buffer, buffer, '<', '>', true);
+    QByteArray expected;
+    comm.writeFrame(expected, payload, '<', '>', true);
+    QCOMPARE(buffer, expected);
+
+    QList<QByteArray> fields;
+    fields << QByteArray("first") << QByteArray("second field") << QByteArray("third");
+    QByteArray copied;
+    comm.writeFrame(copied, fields, '<', '>', ',', true);
+    QCOMPARE(comm.writeFrame(fields[1], fields, '<', '>', ',', true), copied.size());
+    QCOMPARE(fields[1], copied);
+
+    QByteArray stuffed("\x00\x01\x00\xff\x00", 5);
+    QByteArray stuffedExpected;
+    comm.writeStuffedFrame(stuffedExpected, stuffed, ByteStuffing::Mode::Cobs, true);
+    comm.writeStuffedFrame(stuffed, stuffed, ByteStuffing::Mode::Cobs, true);
+    QCOMPARE(stuffed, stuffedExpected);
+}
+
+QTEST_GUILESS_MAIN(FramingTest)
+#include "tst_framing.moc"
@@ -0,0 +1,7 @@
+include(../tests.pri)
+
+TARGET = tst_packettrace
+
+SOURCES += \
+    tst_packettrace.cpp \
+    $$COMMMODULE/packettrace.cpp
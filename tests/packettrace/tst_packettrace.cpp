@@ -0,0 +1,51 @@
+#include <QtTest>
+#include "packettrace.h"
+
+//link registration of the binary trace (user-015)
+class PacketTraceTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reconnectsReuseLinkIds();
+    void unregisteredNameStaysUntilReuse();
+};
+
+//a process that reconnects for ever registers far more than 65536 links over its lifetime
+void PacketTraceTest::reconnectsReuseLinkIds()
+{
+    const int before = PacketTrace::linkCount();
+    const quint16 fixed = PacketTrace::registerLink("fixed");
+    quint16 highest = fixed;
+    for (int i = 0; i < 70000; ++i) {
+        const quint16 link = PacketTrace::registerLink(QString("tcp %1").arg(i));
+        highest = qMax(highest, link);
+        PacketTrace::unregisterLink(link);
+    }
+    QVERIFY(highest <= fixed + 1);
+    QCOMPARE(PacketTrace::linkName(fixed), QString("fixed"));
+
+    PacketTrace::setLinkName(fixed, "renamed");
+    QCOMPARE(PacketTrace::linkName(fixed), QString("renamed"));
+    PacketTrace::unregisterLink(fixed);
+    PacketTrace::unregisterLink(fixed); // twice must not free the id for two owners
+    QCOMPARE(PacketTrace::linkCount(), before);
+
+    const quint16 a = PacketTrace::registerLink("a");
+    const quint16 b = PacketTrace::registerLink("b");
+    QVERIFY(a != b);
+    PacketTrace::unregisterLink(a);
+    PacketTrace::unregisterLink(b);
+}
+
+void PacketTraceTest::unregisteredNameStaysUntilReuse()
+{
+    const quint16 link = PacketTrace::registerLink("serial /dev/ttyS3");
+    PacketTrace::unregisterLink(link);
+    QCOMPARE(PacketTrace::linkName(link), QString("serial /dev/ttyS3"));
+    PacketTrace::setLinkName(link, "ignored"); // no owner any more
+    QCOMPARE(PacketTrace::linkName(link), QString("serial /dev/ttyS3"));
+}
+
+QTEST_GUILESS_MAIN(PacketTraceTest)
+#include "tst_packettrace.moc"
@@ -0,0 +1,49 @@
+include(../tests.pri)
+
+QT += network serialport serialbus
+
+TARGET = tst_queuedsignals
+
+SOURCES += \
+    tst_queuedsignals.cpp \
+    $$COMMMODULE/bitpack.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/crc16.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/iothread.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/modbus.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/reconnectpolicy.cpp \
+    $$COMMMODULE/registerconvert.cpp \
+    $$COMMMODULE/rtuframer.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/sendqueue.cpp \
+    $$COMMMODULE/serial.cpp \
+    $$COMMMODULE/serialmanager.cpp \
+    $$COMMMODULE/serialpollloop.cpp \
+    $$COMMMODULE/serialportoptions.cpp \
+    $$COMMMODULE/tcp.cpp \
+    $$COMMMODULE/tcpconnectionmanager.cpp \
+    $$COMMMODULE/tcpendpointgroup.cpp \
+    $$COMMMODULE/tcpsocketoptions.cpp \
+    $$COMMMODULE/udp.cpp \
+    $$COMMMODULE/unixsocket.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/iothread.h \
+    $$COMMMODULE/modbus.h \
+    $$COMMMODULE/rtuframer.h \
+    $$COMMMODULE/sendqueue.h \
+    $$COMMMODULE/serial.h \
+    $$COMMMODULE/serialmanager.h \
+    $$COMMMODULE/serialpollloop.h \
+    $$COMMMODULE/tcp.h \
+    $$COMMMODULE/tcpconnectionmanager.h \
+    $$COMMMODULE/tcpendpointgroup.h \
+    $$COMMMODULE/udp.h \
+    $$COMMMODULE/unixsocket.h
@@ -0,0 +1,80 @@
+#include <QtTest>
+#include <QMetaMethod>
+#include <QStringList>
+#include <functional>
+#include "modbus.h"
+#include "serial.h"
+#include "serialmanager.h"
+#include "tcp.h"
+#include "tcpconnectionmanager.h"
+#include "udp.h"
+#include "unixsocket.h"
+#include "testutil.h"
+
+//transports run on an IoThread, so every receiver on another thread gets their signals queued and
+//Qt silently drops a signal whose argument type is not a registered metatype (user-012)
+class QueuedSignalsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void signalArgumentsAreRegistered();
+    void bitsReadyIsDeliveredQueued();
+};
+
+//signals declared by the class itself (not QObject's) with an argument unknown to QMetaType
+static QStringList unregisteredArguments(const QMetaObject &meta)
+{
+    QStringList missing;
+    for (int m = meta.methodOffset(); m < meta.methodCount(); ++m) {
+        const QMetaMethod method = meta.method(m);
+        if (method.methodType() != QMetaMethod::Signal)
+            continue;
+        for (int a = 0; a < method.parameterCount(); ++a) {
+            if (method.parameterType(a) == QMetaType::UnknownType)
+                missing << QString("%1::%2 argument %3").arg(meta.className()).arg(QString(method.methodSignature())).arg(a);
+        }
+    }
+    return missing;
+}
+
+//the transports register their types in the constructor, so each is created before it is checked
+void QueuedSignalsTest::signalArgumentsAreRegistered()
+{
+    const QList<std::function<QObject *()>> transports = {
+        []() -> QObject * { return new Modbus; },
+        []() -> QObject * { return new Serial; },
+        []() -> QObject * { return new SerialManager(1); },
+        []() -> QObject * { return new Tcp; },
+        []() -> QObject * { return new TcpConnectionManager(1); },
+        []() -> QObject * { return new Udp; },
+        []() -> QObject * { return new UnixSocket; }
+    };
+
+    QStringList missing;
+    for (const std::function<QObject *()> &create : transports) {
+        QScopedPointer<QObject> transport(create());
+        missing += unregisteredArguments(*transport->metaObject());
+    }
+    QVERIFY2(missing.isEmpty(), qPrintable(missing.join(", ")));
+}
+
+void QueuedSignalsTest::bitsReadyIsDeliveredQueued()
+{
+    Modbus modbus;
+    QObject receiver;
+    Modbus::RegisterType received = Modbus::RegisterType::Invalid;
+    int receivedCount = 0;
+    connect(&modbus, &Modbus::bitsReady, &receiver, [&](Modbus::RegisterType type, int, int count, const QByteArray &) {
+        received = type;
+        receivedCount = count;
+    }, Qt::QueuedConnection);
+
+    emit modbus.bitsReady(Modbus::RegisterType::Coils, 10, 12, QByteArray(2, '\x55'));
+    QVERIFY(TestUtil::waitUntil([&]() { return receivedCount != 0; }, 1000));
+    QCOMPARE(received, Modbus::RegisterType::Coils);
+    QCOMPARE(receivedCount, 12);
+}
+
+QTEST_GUILESS_MAIN(QueuedSignalsTest)
+#include "tst_queuedsignals.moc"
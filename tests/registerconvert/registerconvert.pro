@@ -0,0 +1,11 @@
+include(../tests.pri)
+
+TARGET = tst_registerconvert
+
+SOURCES += \
+    tst_registerconvert.cpp \
+    $$COMMMODULE/registerconvert.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/registerconvert.h
@@ -0,0 +1,260 @@
+#include <QtTest>
+#include <QDataStream>
+#include <QtEndian>
+#include <cstring>
+#include "registerconvert.h"
+#include "testutil.h"
+
+Q_DECLARE_METATYPE(RegisterConvert::Kernel)
+
+//register block conversion against the per-value paths it replaced (user-005)
+class RegisterConvertTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void cleanup();
+    void byteOrders_data();
+    void byteOrders();
+    void floatRoundTrip_data();
+    void floatRoundTrip();
+    void wireBytes_data();
+    void wireBytes();
+    void registersToBytes_data();
+    void registersToBytes();
+    void bytesToFloat_data();
+    void bytesToFloat();
+};
+
+typedef RegisterConvert::ByteOrder BO;
+typedef RegisterConvert::WordOrder WO;
+
+struct KernelRow
+{
+    RegisterConvert::Kernel kernel;
+    const char *name;
+};
+
+//the paths this CPU can run, probing leaves the last one selected until cleanup()
+static QList<KernelRow> supportedKernels()
+{
+    QList<KernelRow> rows;
+    for (const KernelRow &k : {KernelRow{RegisterConvert::Kernel::Scalar, "scalar"}, KernelRow{RegisterConvert::Kernel::Sse2, "sse2"},
+                               KernelRow{RegisterConvert::Kernel::Avx2, "avx2"}}) {
+        if (RegisterConvert::setKernel(k.kernel))
+            rows.append(k);
+    }
+    return rows;
+}
+
+void RegisterConvertTest::cleanup()
+{
+    //back to what the runtime dispatch picks
+    if (!RegisterConvert::setKernel(RegisterConvert::Kernel::Avx2))
+        RegisterConvert::setKernel(RegisterConvert::Kernel::Sse2);
+}
+
+//0x41424344 ("ABCD") as it sits in two registers for each ordering
+void RegisterConvertTest::byteOrders_data()
+{
+    QTest::addColumn<RegisterConvert::Kernel>("kernel");
+    QTest::addColumn<int>("byteOrder");
+    QTest::addColumn<int>("wordOrder");
+    QTest::addColumn<quint16>("first");
+    QTest::addColumn<quint16>("second");
+
+    const struct { const char *name; BO bo; WO wo; quint16 first, second; } orders[] = {
+        {"ABCD", BO::BigEndian, WO::HighWordFirst, 0x4142, 0x4344},
+        {"BADC", BO::LittleEndian, WO::HighWordFirst, 0x4241, 0x4443},
+        {"CDAB", BO::BigEndian, WO::LowWordFirst, 0x4344, 0x4142},
+        {"DCBA", BO::LittleEndian, WO::LowWordFirst, 0x4443, 0x4241}};
+    for (const KernelRow &k : supportedKernels()) {
+        for (const auto &o : orders)
+            QTest::newRow(qPrintable(QString("%1, %2").arg(k.name).arg(o.name))) << k.kernel << int(o.bo) << int(o.wo) << o.first << o.second;
+    }
+}
+
+void RegisterConvertTest::byteOrders()
+{
+    QFETCH(RegisterConvert::Kernel, kernel);
+    QFETCH(int, byteOrder);
+    QFETCH(int, wordOrder);
+    QFETCH(quint16, first);
+    QFETCH(quint16, second);
+    QVERIFY(RegisterConvert::setKernel(kernel));
+    const BO bo = BO(byteOrder);
+    const WO wo = WO(wordOrder);
+
+    //odd counts so the vector loops and their tails both run
+    for (int count : {1, 3, 4, 9, 17, 40}) {
+        QVector<quint32> values(count);
+        QVector<quint16> regs(2 * count);
+        for (int i = 0; i < count; ++i) {
+            values[i] = 0x41424344u + (quint32(i) << 24 | quint32(i));
+            regs[2 * i] = first;
+            regs[2 * i + 1] = second;
+        }
+
+        QVector<quint16> written(2 * count);
+        RegisterConvert::fromUInt32(values.constData(), count, written.data(), bo, wo);
+        QVector<quint32> read(count);
+        RegisterConvert::toUInt32(written.constData(), count, read.data(), bo, wo);
+        QCOMPARE(read, values);
+
+        QVector<quint32> decoded(count);
+        RegisterConvert::toUInt32(regs.constData(), count, decoded.data(), bo, wo);
+        for (quint32 v : decoded)
+            QCOMPARE(v, 0x41424344u);
+        QVector<qint32> signedValues(count);
+        RegisterConvert::toInt32(regs.constData(), count, signedValues.data(), bo, wo);
+        QCOMPARE(signedValues.first(), qint32(0x41424344));
+
+        QVector<quint16> encoded(2 * count);
+        const QVector<quint32> same(count, 0x41424344u);
+        RegisterConvert::fromUInt32(same.constData(), count, encoded.data(), bo, wo);
+        QCOMPARE(encoded, regs);
+    }
+
+    //16 bit values only see the byte order
+    const quint16 reg = 0x8001;
+    qint16 v16 = 0;
+    RegisterConvert::toInt16(&reg, 1, &v16, bo);
+    QCOMPARE(v16, bo == BO::BigEndian ? qint16(-32767) : qint16(0x0180));
+}
+
+void RegisterConvertTest::floatRoundTrip_data()
+{
+    QTest::addColumn<RegisterConvert::Kernel>("kernel");
+    for (const KernelRow &k : supportedKernels())
+        QTest::newRow(k.name) << k.kernel;
+}
+
+//1.5f is 0x3FC00000, the float path must match the integer one bit for bit
+void RegisterConvertTest::floatRoundTrip()
+{
+    QFETCH(RegisterConvert::Kernel, kernel);
+    QVERIFY(RegisterConvert::setKernel(kernel));
+    const quint16 abcd[2] = {0x3FC0, 0x0000};
+    float f = 0;
+    RegisterConvert::toFloat32(abcd, 1, &f);
+    QCOMPARE(f, 1.5f);
+
+    QVector<float> values(37);
+    for (int i = 0; i < values.size(); ++i)
+        values[i] = -12.5f + 3.25f * i;
+    for (BO bo : {BO::BigEndian, BO::LittleEndian}) {
+        for (WO wo : {WO::HighWordFirst, WO::LowWordFirst}) {
+            QVector<quint16> regs(2 * values.size());
+            RegisterConvert::fromFloat32(values.constData(), values.size(), regs.data(), bo, wo);
+            QVector<float> back(values.size());
+            RegisterConvert::toFloat32(regs.constData(), values.size(), back.data(), bo, wo);
+            QCOMPARE(back, values);
+        }
+    }
+}
+
+void RegisterConvertTest::wireBytes_data()
+{
+    QTest::addColumn<RegisterConvert::Kernel>("kernel");
+    for (const KernelRow &k : supportedKernels())
+        QTest::newRow(k.name) << k.kernel;
+}
+
+//wire bytes are big endian registers, also from and into odd addresses
+void RegisterConvertTest::wireBytes()
+{
+    QFETCH(RegisterConvert::Kernel, kernel);
+    QVERIFY(RegisterConvert::setKernel(kernel));
+    QVector<quint16> regs(21);
+    for (int i = 0; i < regs.size(); ++i)
+        regs[i] = quint16(0x0102 * (i + 1));
+    for (int offset : {0, 1}) {
+        QByteArray bytes(2 * regs.size() + 1, 0);
+        char *out = bytes.data() + offset;
+        RegisterConvert::registersToBytes(regs.constData(), regs.size(), out);
+        for (int i = 0; i < regs.size(); ++i)
+            QCOMPARE(qFromBigEndian<quint16>(out + 2 * i), regs.at(i));
+        QVector<quint16> back(regs.size());
+        RegisterConvert::bytesToRegisters(out, regs.size(), back.data());
+        QCOMPARE(back, regs);
+    }
+}
+
+void RegisterConvertTest::registersToBytes_data()
+{
+    QTest::addColumn<bool>("block");
+    QTest::newRow("per register append") << false;
+    QTest::newRow("registersToBytes") << true;
+}
+
+//the reply repacking in Modbus::readModbusData, old and new
+void RegisterConvertTest::registersToBytes()
+{
+    QFETCH(bool, block);
+    QVector<quint16> regs(4096);
+    for (int i = 0; i < regs.size(); ++i)
+        regs[i] = quint16(i * 7919);
+    QByteArray data;
+    const auto pass = [&]() {
+        data.clear();
+        if (block) {
+            data.resize(regs.size() * 2);
+            RegisterConvert::registersToBytes(regs.constData(), regs.size(), data.data());
+        } else {
+            for (const quint16 val : regs) {
+                data.append(static_cast<char>((val >> 8) & 0xFF));
+                data.append(static_cast<char>(val & 0xFF));
+            }
+        }
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(data.size(), regs.size() * 2);
+    QCOMPARE(qFromBigEndian<quint16>(data.constData() + 2 * 100), regs.at(100));
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, data.size()), 'f', 0) << "MB/s";
+}
+
+void RegisterConvertTest::bytesToFloat_data()
+{
+    QTest::addColumn<bool>("block");
+    QTest::newRow("QDataStream per value") << false;
+    QTest::newRow("bytesToRegisters + toFloat32") << true;
+}
+
+//decoding a block of ABCD floats from reply bytes
+void RegisterConvertTest::bytesToFloat()
+{
+    QFETCH(bool, block);
+    const int count = 2048;
+    QByteArray bytes(count * 4, 0);
+    for (int i = 0; i < count; ++i) {
+        const float f = 0.5f * i;
+        quint32 v;
+        std::memcpy(&v, &f, sizeof(v));
+        qToBigEndian(v, bytes.data() + 4 * i);
+    }
+    QVector<float> values(count);
+    QVector<quint16> regs(2 * count);
+    const auto pass = [&]() {
+        if (block) {
+            RegisterConvert::bytesToRegisters(bytes.constData(), 2 * count, regs.data());
+            RegisterConvert::toFloat32(regs.constData(), count, values.data());
+        } else {
+            QDataStream stream(bytes);
+            stream.setByteOrder(QDataStream::BigEndian);
+            stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+            for (int i = 0; i < count; ++i)
+                stream >> values[i];
+        }
+    };
+    QBENCHMARK {
+        pass();
+    }
+    QCOMPARE(values.at(0), 0.0f);
+    QCOMPARE(values.at(count - 1), 0.5f * (count - 1));
+    qInfo().noquote() << QTest::currentDataTag() << ":" << QString::number(TestUtil::megabytesPerSecond(pass, bytes.size()), 'f', 0) << "MB/s";
+}
+
+QTEST_GUILESS_MAIN(RegisterConvertTest)
+#include "tst_registerconvert.moc"
@@ -0,0 +1,170 @@
+#include <QtTest>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "serial.h"
+#include "crc16.h"
+#include "latencyhistogram.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+//RtuFramer behind Serial over a pty at 9600 8E1. a device thread writes each frame in pieces
+//with inter-character delays, the test measures last byte written to frameReady (user-024)
+class RtuFramerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void endOfFrameDetection_data();
+    void endOfFrameDetection();
+    void interCharacterViolation();
+};
+
+static qint64 steadyNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static QByteArray withCrc(QByteArray frame)
+{
+    const quint16 crc = Crc16::compute(frame);
+    frame.append(static_cast<char>(crc & 0xFF));
+    frame.append(static_cast<char>(crc >> 8));
+    return frame;
+}
+
+//plays a slave: frames go out in pieces of pieceSize bytes separated by gapUs, lastByteNs is
+//the time the final piece of the current frame was written
+class SlowDevice
+{
+public:
+    SlowDevice(PtyPair &pty, const QByteArray &frame, int frames, int pieceSize, int gapUs, int frameGapMs)
+        : writer([=, &pty]() {
+              for (int f = 0; f < frames && !stopped; ++f) {
+                  while (!stopped && acknowledged.load() < f)
+                      std::this_thread::sleep_for(std::chrono::microseconds(100));
+                  std::this_thread::sleep_for(std::chrono::milliseconds(frameGapMs));
+                  for (int offset = 0; offset < frame.size(); offset += pieceSize) {
+                      if (offset > 0)
+                          std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+                      if (offset + pieceSize >= frame.size())
+                          lastByteNs = steadyNs();
+                      pty.write(frame.mid(offset, pieceSize));
+                  }
+              }
+          })
+    {
+    }
+    ~SlowDevice()
+    {
+        stopped = true;
+        writer.join();
+    }
+    void frameSeen() { ++acknowledged; } // the next frame is written once this one arrived
+
+    std::atomic<qint64> lastByteNs{0};
+
+private:
+    std::atomic<bool> stopped{false};
+    std::atomic<int> acknowledged{0};
+    std::thread writer;
+};
+
+void RtuFramerTest::init()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+}
+
+void RtuFramerTest::endOfFrameDetection_data()
+{
+    QTest::addColumn<QByteArray>("frame");
+    QTest::addColumn<bool>("predicted");
+
+    QByteArray registers;
+    registers.append(char(0x01)).append(char(0x03)).append(char(20));
+    for (int i = 0; i < 20; ++i)
+        registers.append(char(i));
+    QTest::newRow("read holding registers, length predicted") << withCrc(registers) << true;
+
+    QByteArray custom;
+    custom.append(char(0x01)).append(char(0x41)); // user defined function code, ends on t3.5
+    for (int i = 0; i < 12; ++i)
+        custom.append(char(0x30 + i));
+    QTest::newRow("custom function code, t3.5 silence") << withCrc(custom) << false;
+}
+
+//pieces of 4 bytes with 300 us between them, well inside t1.5 (1719 us at 9600 8E1)
+void RtuFramerTest::endOfFrameDetection()
+{
+    QFETCH(QByteArray, frame);
+    QFETCH(bool, predicted);
+    const int frames = 200;
+
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 9600, Serial::DataBits::Data8, Serial::Parity::Even));
+    serial.setRtuFraming(RtuFramer::Mode::Responses);
+    RtuFramer *framer = serial.rtuFraming();
+    QVERIFY(framer);
+
+    SlowDevice device(pty, frame, frames, 4, 300, 5);
+    LatencyHistogram endToEnd;
+    int received = 0;
+    bool intact = true;
+    connect(&serial, &Serial::frameReady, &serial, [&](const QByteArray &payload) {
+        endToEnd.record((steadyNs() - device.lastByteNs.load()) / 1000);
+        intact = intact && payload == frame.left(frame.size() - 2);
+        ++received;
+        device.frameSeen();
+    });
+    QVERIFY2(TestUtil::waitUntil([&]() { return received == frames; }, 30000),
+             qPrintable(QString("%1 of %2 frames").arg(received).arg(frames)));
+
+    qInfo().noquote() << QTest::currentDataTag();
+    qInfo().noquote() << QString("  t1.5 %1 us, t3.5 %2 us, by length %3, by silence %4")
+                         .arg(framer->t15Us()).arg(framer->t35Us())
+                         .arg(framer->framesByLength()).arg(framer->framesBySilence());
+    qInfo().noquote() << "  last byte written to frameReady" << endToEnd.toString();
+    qInfo().noquote() << "  last chunk read to frameReady" << framer->detectionHistogram().toString();
+    QVERIFY(intact);
+    QCOMPARE(framer->crcErrors(), quint64(0));
+    if (predicted) {
+        QCOMPARE(framer->framesByLength(), quint64(frames));
+        QVERIFY2(endToEnd.percentileUs(50.0) < framer->t35Us(), "predicted frames should not wait for t3.5");
+    } else {
+        QCOMPARE(framer->framesBySilence(), quint64(frames));
+        QVERIFY(endToEnd.percentileUs(50.0) >= framer->t35Us() / 2);
+    }
+}
+
+//a gap between t1.5 and t3.5 inside a frame is a timing violation, the frame is still taken
+void RtuFramerTest::interCharacterViolation()
+{
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 9600, Serial::DataBits::Data8, Serial::Parity::Even));
+    serial.setRtuFraming(RtuFramer::Mode::Responses);
+    RtuFramer *framer = serial.rtuFraming();
+
+    QByteArray registers;
+    registers.append(char(0x02)).append(char(0x03)).append(char(4)).append(char(0)).append(char(1)).append(char(0)).append(char(2));
+    const QByteArray frame = withCrc(registers);
+    const int gapUs = (framer->t15Us() + framer->t35Us()) / 2;
+    int received = 0;
+    SlowDevice device(pty, frame, 20, 3, gapUs, 10);
+    connect(&serial, &Serial::frameReady, &serial, [&](const QByteArray &) {
+        ++received;
+        device.frameSeen();
+    });
+    QVERIFY(TestUtil::waitUntil([&]() { return received == 20; }, 10000));
+    qInfo().noquote() << QString("%1 us gaps: %2 violations in %3 frames").arg(gapUs).arg(framer->interCharacterViolations()).arg(received);
+    QVERIFY(framer->interCharacterViolations() > 0);
+}
+
+QTEST_GUILESS_MAIN(RtuFramerTest)
+#include "tst_rtuframer.moc"
@@ -0,0 +1,31 @@
+include(../tests.pri)
+
+QT += serialport
+
+TARGET = tst_rxchannel
+
+SOURCES += \
+    tst_rxchannel.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/crc16.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/iothread.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/rtuframer.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/rxchannel.cpp \
+    $$COMMMODULE/serial.cpp \
+    $$COMMMODULE/serialportoptions.cpp
+
+HEADERS += \
+    $$PWD/../common/ptypair.h \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/iothread.h \
+    $$COMMMODULE/rtuframer.h \
+    $$COMMMODULE/rxchannel.h \
+    $$COMMMODULE/serial.h \
+    $$COMMMODULE/spscqueue.h
@@ -0,0 +1,185 @@
+#include <QtTest>
+#include <QThread>
+#include <functional>
+#include "iothread.h"
+#include "rxchannel.h"
+#include "serial.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+//hand off from an I/O thread to the consumer in each delivery mode, and the single producer rule (user-012)
+class RxChannelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void queuedSignal();
+    void directCallback();
+    void polling();
+    void secondProducerIsRejected();
+    void serialOnIoThread();
+};
+
+//runs f on a fresh thread and waits for it
+static void runOnThread(const std::function<void()> &f)
+{
+    QScopedPointer<QThread> thread(QThread::create(f));
+    thread->start();
+    thread->wait();
+}
+
+static QByteArray chunk(int i)
+{
+    return QByteArray::number(i).rightJustified(8, '0');
+}
+
+//everything arrives once, in order, on the consumer thread
+void RxChannelTest::queuedSignal()
+{
+    const int count = 5000;
+    RxChannel channel(RxChannel::DeliveryMode::QueuedSignal, 8192);
+    QList<QByteArray> received;
+    bool onConsumerThread = true;
+    connect(&channel, &RxChannel::dataReady, this, [&](const QByteArray &data) {
+        onConsumerThread &= QThread::currentThread() == thread();
+        received.append(data);
+    });
+
+    runOnThread([&]() {
+        for (int i = 0; i < count; ++i)
+            channel.push(chunk(i));
+    });
+    QVERIFY(TestUtil::waitUntil([&]() { return received.size() == count; }, 5000));
+    QVERIFY(onConsumerThread);
+    for (int i = 0; i < count; ++i)
+        QCOMPARE(received.at(i), chunk(i));
+    QCOMPARE(channel.dropped(), quint64(0));
+    QCOMPARE(channel.pending(), 0);
+}
+
+//the callback runs on the producer thread, nothing is queued
+void RxChannelTest::directCallback()
+{
+    RxChannel channel(RxChannel::DeliveryMode::DirectCallback);
+    Qt::HANDLE producer = nullptr;
+    Qt::HANDLE callbackThread = nullptr;
+    int calls = 0;
+    channel.setCallback([&](const QByteArray &data) {
+        callbackThread = QThread::currentThreadId();
+        calls += data == "x";
+    });
+    int emitted = 0;
+    connect(&channel, &RxChannel::dataReady, this, [&]() { ++emitted; });
+
+    runOnThread([&]() {
+        producer = QThread::currentThreadId();
+        for (int i = 0; i < 100; ++i)
+            channel.push("x");
+    });
+    QCOMPARE(calls, 100);
+    QCOMPARE(callbackThread, producer);
+    QCOMPARE(channel.pending(), 0);
+    QTest::qWait(10);
+    QCOMPARE(emitted, 0);
+}
+
+//consumer polls while the producer is still pushing, a small ring so both sides wrap many times
+void RxChannelTest::polling()
+{
+    const int count = 100000;
+    RxChannel channel(RxChannel::DeliveryMode::Polling, 64);
+    int emitted = 0;
+    connect(&channel, &RxChannel::dataReady, this, [&]() { ++emitted; });
+
+    QScopedPointer<QThread> producer(QThread::create([&]() {
+        for (int i = 0; i < count; ++i) {
+            while (channel.pending() >= 64)
+                QThread::yieldCurrentThread(); // back off instead of dropping
+            channel.push(chunk(i));
+        }
+    }));
+    producer->start();
+
+    //alternate single polls and batches until everything is in or the producer stalls
+    int next = 0;
+    bool inOrder = true;
+    QByteArray data;
+    QList<QByteArray> batch;
+    QElapsedTimer clock;
+    clock.start();
+    while (next < count && clock.elapsed() < 10000) {
+        if (next % 2) {
+            if (channel.poll(data)) {
+                inOrder &= data == chunk(next);
+                ++next;
+            }
+        } else {
+            batch.clear();
+            channel.pollAll(batch);
+            for (const QByteArray &d : batch) {
+                inOrder &= d == chunk(next);
+                ++next;
+            }
+        }
+    }
+    producer->wait();
+    QCOMPARE(next, count);
+    QVERIFY(inOrder);
+    QCOMPARE(channel.dropped(), quint64(0));
+    QVERIFY(!channel.poll(data));
+    QCOMPARE(emitted, 0);
+}
+
+//the ring is single producer, a push from another thread is dropped rather than racing the owner
+//(the owner is this thread, which outlives the intruder, so its id cannot be reused in between)
+void RxChannelTest::secondProducerIsRejected()
+{
+    RxChannel channel(RxChannel::DeliveryMode::Polling, 16);
+    channel.push("owner");
+    runOnThread([&]() { channel.push("intruder"); });
+    channel.push("owner again");
+    QCOMPARE(channel.dropped(), quint64(1));
+    QList<QByteArray> out;
+    QCOMPARE(channel.pollAll(out), 2);
+    QCOMPARE(out, (QList<QByteArray>{"owner", "owner again"}));
+}
+
+//a Serial read on an IoThread reaches the consumer through the channel, as MainWindow wires it
+void RxChannelTest::serialOnIoThread()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial *serial = new Serial;
+    RxChannel channel(RxChannel::DeliveryMode::QueuedSignal);
+    QVERIFY(channel.attach(serial));
+    QByteArray received;
+    bool onConsumerThread = true;
+    connect(&channel, &RxChannel::dataReady, this, [&](const QByteArray &data) {
+        onConsumerThread &= QThread::currentThread() == thread();
+        received += data;
+    });
+
+    IoThread io("RxChannelTest");
+    QVERIFY(io.attach(serial));
+    io.start();
+    bool opened = false;
+    io.postBlocking([&]() { opened = serial->connectDevice(pty.slavePath(), 115200); });
+    QVERIFY(opened);
+
+    const QByteArray payload(3000, 'r');
+    QVERIFY(pty.write(payload));
+    QVERIFY(TestUtil::waitUntil([&]() { return received.size() >= payload.size(); }, 5000));
+    QCOMPARE(received, payload);
+    QVERIFY(onConsumerThread);
+    QCOMPARE(channel.dropped(), quint64(0));
+
+    io.postBlocking([&]() { serial->disconnectDevice(); });
+    io.stop();
+    delete serial;
+}
+
+QTEST_GUILESS_MAIN(RxChannelTest)
+#include "tst_rxchannel.moc"
@@ -0,0 +1,34 @@
+include(../tests.pri)
+
+QT += network serialport
+
+TARGET = tst_rxpool
+
+SOURCES += \
+    tst_rxpool.cpp \
+    $$PWD/../common/alloccounter.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/crc16.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/reconnectpolicy.cpp \
+    $$COMMMODULE/rtuframer.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/sendqueue.cpp \
+    $$COMMMODULE/serial.cpp \
+    $$COMMMODULE/serialportoptions.cpp \
+    $$COMMMODULE/tcp.cpp \
+    $$COMMMODULE/tcpsocketoptions.cpp
+
+HEADERS += \
+    $$PWD/../common/alloccounter.h \
+    $$PWD/../common/ptypair.h \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/rtuframer.h \
+    $$COMMMODULE/sendqueue.h \
+    $$COMMMODULE/serial.h \
+    $$COMMMODULE/tcp.h
@@ -0,0 +1,153 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <cstring>
+#include "rxbufferpool.h"
+#include "serial.h"
+#include "tcp.h"
+#include "alloccounter.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+//pooled receive chunks of Tcp and Serial, the steady state must not allocate (user-014)
+class RxPoolTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void steadyStateDoesNotAllocate();
+    void pinnedChunksAreSkipped();
+    void tcpSoak();
+    void serialSoak();
+};
+
+static quint16 freePort()
+{
+    QTcpServer probe;
+    probe.listen(QHostAddress::LocalHost, 0);
+    return probe.serverPort();
+}
+
+//reads of varying size into the pool, the consumer only looks at each chunk
+void RxPoolTest::steadyStateDoesNotAllocate()
+{
+    if (!AllocCounter::isActive())
+        QSKIP("allocation hooks need glibc");
+
+    RxBufferPool pool(4096, 8);
+    quint64 checksum = 0;
+    auto read = [&](int i) {
+        QByteArray &chunk = pool.acquire();
+        chunk.resize(1 + (i * 37) % pool.chunkSize());
+        std::memset(chunk.data(), i & 0xFF, static_cast<size_t>(chunk.size()));
+        const QByteArray &view = chunk; // what dataReady hands out
+        checksum += static_cast<quint8>(view.at(view.size() - 1));
+    };
+    for (int i = 0; i < 16; ++i)
+        read(i); // warm up
+    const quint64 poolAllocations = pool.allocationCount();
+
+    AllocCounter::Scope scope;
+    for (int i = 0; i < 100000; ++i)
+        read(i);
+    QCOMPARE(scope.allocations(), quint64(0));
+    QCOMPARE(pool.allocationCount(), poolAllocations);
+    QVERIFY(checksum > 0);
+}
+
+//a consumer keeping a chunk pins it, the pool goes around it and only allocates once all are held
+void RxPoolTest::pinnedChunksAreSkipped()
+{
+    RxBufferPool pool(1024, 4);
+    QList<QByteArray> kept;
+    for (int i = 0; i < 4; ++i) {
+        QByteArray &chunk = pool.acquire();
+        chunk.append(char('a' + i));
+        kept.append(chunk);
+    }
+    QCOMPARE(pool.allocationCount(), quint64(4));
+    QCOMPARE(pool.pinnedCount(), 4);
+
+    QByteArray &replacement = pool.acquire(); // every chunk held, one is replaced
+    replacement.append('x');
+    QCOMPARE(pool.allocationCount(), quint64(5));
+    QCOMPARE(kept.at(0), QByteArray("a")); // the consumer's data is untouched
+
+    kept.clear();
+    QCOMPARE(pool.pinnedCount(), 0);
+    for (int i = 0; i < 100; ++i)
+        pool.acquire().append('y');
+    QCOMPARE(pool.allocationCount(), quint64(5));
+}
+
+//20000 messages over loopback into a Tcp server, the pool stops growing after the first reads
+void RxPoolTest::tcpSoak()
+{
+    const int messages = 20000;
+    const int messageSize = 256;
+
+    Tcp server;
+    qint64 received = 0;
+    connect(&server, &Tcp::dataReceived, &server, [&](int, const QByteArray &data) { received += data.size(); });
+    const quint16 port = freePort();
+    QVERIFY(server.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected(5000));
+    QVERIFY(TestUtil::waitUntil([&]() { return server.connectionCount() == 1; }, 2000));
+
+    const QByteArray message(messageSize, 't');
+    auto pump = [&](int count) {
+        const qint64 target = received + qint64(count) * messageSize;
+        for (int i = 0; i < count; ++i) {
+            client.write(message);
+            if (i % 64 == 63)
+                QCoreApplication::processEvents();
+        }
+        return TestUtil::waitUntil([&]() { return received >= target; }, 10000);
+    };
+    QVERIFY(pump(500)); // warm up
+    const quint64 warm = server.rxAllocationCount();
+    QVERIFY(pump(messages));
+
+    qInfo().noquote() << QString("tcp: %1 bytes, pool allocations %2 after warm up, %3 in total")
+                         .arg(received).arg(server.rxAllocationCount() - warm).arg(server.rxAllocationCount());
+    QCOMPARE(server.rxAllocationCount(), warm);
+}
+
+void RxPoolTest::serialSoak()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+    const int messages = 20000;
+    const int messageSize = 32;
+
+    PtyPair device;
+    QVERIFY(device.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(device.slavePath(), 115200));
+    qint64 received = 0;
+    connect(&serial, &Serial::dataReady, &serial, [&](const QByteArray &data) { received += data.size(); });
+
+    const QByteArray message(messageSize, 's');
+    auto pump = [&](int count) {
+        for (int i = 0; i < count; ++i) {
+            const qint64 target = received + messageSize;
+            if (!device.write(message) || !TestUtil::waitUntil([&]() { return received >= target; }, 2000))
+                return false;
+        }
+        return true;
+    };
+    QVERIFY(pump(100)); // warm up
+    const quint64 warm = serial.rxAllocationCount();
+    QVERIFY(pump(messages));
+
+    qInfo().noquote() << QString("serial: %1 bytes, pool allocations %2 after warm up, %3 in total")
+                         .arg(received).arg(serial.rxAllocationCount() - warm).arg(serial.rxAllocationCount());
+    QCOMPARE(serial.rxAllocationCount(), warm);
+}
+
+QTEST_GUILESS_MAIN(RxPoolTest)
+#include "tst_rxpool.moc"
@@ -0,0 +1,13 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_sendqueue
+
+SOURCES += \
+    tst_sendqueue.cpp \
+    $$COMMMODULE/sendqueue.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/sendqueue.h
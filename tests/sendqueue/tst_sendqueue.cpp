@@ -0,0 +1,204 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "sendqueue.h"
+#include "testutil.h"
+
+//coalesced gather writes over a loopback connection (user-013)
+class SendQueueTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void coalescesWithinWindow();
+    void thresholdWritesAtOnce();
+    void moreThanMaxIovecs();
+    void partialSendKeepsOrder();
+    void backpressureSignals();
+    void limitRejectsEnqueue();
+
+private:
+    void connectPair();
+    void startReading();
+    bool receive(qint64 bytes, int timeoutMs = 10000);
+
+    QTcpServer server;
+    QTcpSocket *client = nullptr;
+    QTcpSocket *peer = nullptr; //accepted end, what the queue writes arrives here
+    QByteArray received;
+};
+
+//message i is its index repeated, so any reordering or loss shows in the received stream
+static QByteArray message(int i, int size)
+{
+    return QByteArray(size, static_cast<char>('A' + i % 26));
+}
+
+static QByteArray expectedStream(int count, int size)
+{
+    QByteArray all;
+    for (int i = 0; i < count; ++i)
+        all += message(i, size);
+    return all;
+}
+
+void SendQueueTest::init()
+{
+    received.clear();
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    connectPair();
+}
+
+void SendQueueTest::cleanup()
+{
+    delete client;
+    client = nullptr;
+    delete peer;
+    peer = nullptr;
+    server.close();
+}
+
+void SendQueueTest::connectPair()
+{
+    client = new QTcpSocket;
+    client->connectToHost(QHostAddress::LocalHost, server.serverPort());
+    QVERIFY(client->waitForConnected(5000));
+    QVERIFY(TestUtil::waitUntil([&]() { return server.hasPendingConnections(); }, 5000));
+    peer = server.nextPendingConnection();
+    peer->setParent(nullptr);
+}
+
+void SendQueueTest::startReading()
+{
+    peer->setReadBufferSize(0);
+    connect(peer, &QTcpSocket::readyRead, this, [this]() { received += peer->readAll(); });
+    received += peer->readAll();
+}
+
+bool SendQueueTest::receive(qint64 bytes, int timeoutMs)
+{
+    return TestUtil::waitUntil([&]() { return received.size() >= bytes; }, timeoutMs);
+}
+
+//small writes inside the window leave as one gather write when the timer runs out
+void SendQueueTest::coalescesWithinWindow()
+{
+    startReading();
+    SendQueue queue(client);
+    queue.setCoalescing(20, 1 << 20);
+    for (int i = 0; i < 50; ++i)
+        QVERIFY(queue.enqueue(message(i, 10)));
+    QCOMPARE(queue.queueDepth(), 50);
+    QCOMPARE(queue.writeCount(), quint64(0));
+
+    QVERIFY(receive(500));
+    QCOMPARE(queue.writeCount(), quint64(1));
+    QCOMPARE(queue.queueDepth(), 0);
+    QCOMPARE(received, expectedStream(50, 10));
+}
+
+void SendQueueTest::thresholdWritesAtOnce()
+{
+    startReading();
+    SendQueue queue(client);
+    queue.setCoalescing(10000, 1000);
+    for (int i = 0; i < 9; ++i)
+        queue.enqueue(message(i, 100));
+    QCOMPARE(queue.writeCount(), quint64(0));
+    queue.enqueue(message(9, 100)); // reaches the threshold, no waiting for the window
+    QCOMPARE(queue.writeCount(), quint64(1));
+    QCOMPARE(queue.queuedBytes(), qint64(0));
+    QVERIFY(receive(1000));
+    QCOMPARE(received, expectedStream(10, 100));
+}
+
+//sendmsg takes 64 iovecs, the rest follows through the socket's own buffer in order
+void SendQueueTest::moreThanMaxIovecs()
+{
+    startReading();
+    SendQueue queue(client);
+    queue.setCoalescing(10000, 1 << 30);
+    const int count = 200;
+    for (int i = 0; i < count; ++i)
+        queue.enqueue(message(i, 7 + i % 5));
+    queue.flush();
+    QCOMPARE(queue.writeCount(), quint64(1));
+    QCOMPARE(queue.queueDepth(), 0);
+
+    QByteArray expected;
+    for (int i = 0; i < count; ++i)
+        expected += message(i, 7 + i % 5);
+    QVERIFY(receive(expected.size()));
+    QCOMPARE(received, expected);
+}
+
+//with the peer not reading, the kernel takes only part of a large flush, the remainder has to
+//reach the wire right after it, starting mid message
+void SendQueueTest::partialSendKeepsOrder()
+{
+    client->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 16384);
+    peer->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 16384);
+    peer->setReadBufferSize(1); // Qt stops pulling from the kernel, the window closes
+    SendQueue queue(client);
+    queue.setCoalescing(10000, 1 << 30);
+    const int count = 64;
+    const int size = 64 * 1024 + 3; // odd size, the cut lands inside a message
+    for (int i = 0; i < count; ++i)
+        queue.enqueue(message(i, size));
+    queue.flush();
+    QCOMPARE(queue.writeCount(), quint64(1));
+    QVERIFY2(client->bytesToWrite() > 0, "the kernel took the whole flush, no partial send to test");
+    QVERIFY(client->bytesToWrite() < qint64(count) * size);
+
+    startReading();
+    QVERIFY(receive(qint64(count) * size, 20000));
+    QCOMPARE(received.size(), count * size);
+    QVERIFY(received == expectedStream(count, size));
+}
+
+void SendQueueTest::backpressureSignals()
+{
+    client->setSocketOption(QAbstractSocket::SendBufferSizeSocketOption, 16384);
+    peer->setReadBufferSize(1);
+    SendQueue queue(client);
+    queue.setCoalescing(0);
+    queue.setWatermarks(512 * 1024, 64 * 1024);
+    QList<bool> changes;
+    connect(&queue, &SendQueue::backpressureChanged, this, [&](bool active) { changes.append(active); });
+
+    const int count = 64;
+    const int size = 32 * 1024;
+    for (int i = 0; i < count && !queue.isBackpressured(); ++i)
+        queue.enqueue(message(i, size));
+    QVERIFY(queue.isBackpressured());
+    QCOMPARE(changes, QList<bool>{true});
+    QVERIFY(queue.bytesInFlight() >= 512 * 1024);
+
+    startReading();
+    QVERIFY(TestUtil::waitUntil([&]() { return !queue.isBackpressured(); }, 10000));
+    QCOMPARE(changes, (QList<bool>{true, false}));
+    QVERIFY(queue.bytesInFlight() <= 64 * 1024);
+}
+
+//above the hard limit enqueue refuses the message and queues nothing of it
+void SendQueueTest::limitRejectsEnqueue()
+{
+    SendQueue queue(client);
+    queue.setCoalescing(10000, 1 << 30);
+    queue.setWatermarks(1000, 500, 2000);
+    QVERIFY(queue.enqueue(message(0, 1500)));
+    QVERIFY(!queue.enqueue(message(1, 501)));
+    QCOMPARE(queue.queuedBytes(), qint64(1500));
+    QVERIFY(queue.enqueue(message(1, 500)));
+    QCOMPARE(queue.queueDepth(), 2);
+
+    startReading();
+    queue.flush();
+    QVERIFY(receive(2000));
+    QCOMPARE(received, message(0, 1500) + message(1, 500));
+}
+
+QTEST_GUILESS_MAIN(SendQueueTest)
+#include "tst_sendqueue.moc"
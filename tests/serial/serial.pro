@@ -0,0 +1,26 @@
+include(../tests.pri)
+
+QT += serialport
+
+TARGET = tst_serial
+
+SOURCES += \
+    tst_serial.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/crc16.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/rtuframer.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/serial.cpp \
+    $$COMMMODULE/serialportoptions.cpp
+
+HEADERS += \
+    $$PWD/../common/ptypair.h \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/rtuframer.h \
+    $$COMMMODULE/serial.h
@@ -0,0 +1,299 @@
+#include <QtTest>
+#include "serial.h"
+#include "latencyhistogram.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+#ifdef Q_OS_LINUX
+#include <termios.h>
+#endif
+
+//Serial end to end over a pty pair: custom rates, low latency mode on and off again,
+//device write to dataReady latency (user-021), RS-485 fallback on a tty without it (user-025),
+//LatencyHistogram and the per chunk timing histograms (user-023)
+class SerialTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void customBaudRate();
+    void lowLatencyModeRestoresDriverValues();
+    void originalValuesRoundTrip();
+    void endToEndLatency();
+    void rs485SoftwareFallback();
+    void histogramBucketPlacement_data();
+    void histogramBucketPlacement();
+    void histogramPercentiles();
+    void chunkTimingHistograms();
+};
+
+static cc_t readTiming(const Serial &serial, int index)
+{
+    termios tio;
+    if (::tcgetattr(static_cast<int>(serial.serial->handle()), &tio) != 0)
+        return 0xFF;
+    return tio.c_cc[index];
+}
+
+void SerialTest::init()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("pty based, Linux only");
+#endif
+}
+
+//QSerialPort takes the rate itself, Serial only reads it back
+void SerialTest::customBaudRate()
+{
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 921600));
+    QCOMPARE(serial.characterTimeUs(), 11); // 10 bits at 921600 baud, rounded up
+    QVERIFY(SerialPortOptions::checkBaudRate(serial.serial->handle(), 921600));
+    QVERIFY(!SerialPortOptions::checkBaudRate(serial.serial->handle(), 115200));
+}
+
+void SerialTest::lowLatencyModeRestoresDriverValues()
+{
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 115200));
+    const cc_t minBefore = readTiming(serial, VMIN);
+    const cc_t timeBefore = readTiming(serial, VTIME);
+
+    serial.setLowLatencyMode(true);
+    QCOMPARE(int(readTiming(serial, VMIN)), 1);
+    QCOMPARE(int(readTiming(serial, VTIME)), 0);
+
+    serial.setLowLatencyMode(false);
+    QCOMPARE(readTiming(serial, VMIN), minBefore);
+    QCOMPARE(readTiming(serial, VTIME), timeBefore);
+
+    //changing options while they are on starts again from the driver values
+    SerialPortOptions options;
+    options.readTimeoutDs = 5;
+    serial.setPortOptions(options);
+    QCOMPARE(int(readTiming(serial, VTIME)), 5);
+    serial.setLowLatencyMode(true);
+    serial.setPortOptions(SerialPortOptions());
+    QCOMPARE(readTiming(serial, VMIN), minBefore);
+    QCOMPARE(readTiming(serial, VTIME), timeBefore);
+}
+
+//apply() records only what it replaced, restore() writes exactly that back
+void SerialTest::originalValuesRoundTrip()
+{
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    const int fd = ::open(pty.slavePath().c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    QVERIFY(fd >= 0);
+    termios before;
+    QVERIFY(::tcgetattr(fd, &before) == 0);
+
+    SerialPortOptions options;
+    options.minChars = before.c_cc[VMIN] == 7 ? 8 : 7;
+    SerialPortOptions::Original original;
+    QVERIFY(options.apply(fd, pty.slaveName(), nullptr, &original));
+    QCOMPARE(original.minChars, int(before.c_cc[VMIN]));
+    QCOMPARE(original.readTimeoutDs, -1); // not touched
+    QCOMPARE(original.lowLatency, -1);
+
+    QVERIFY(original.restore(fd, pty.slaveName()));
+    termios after;
+    QVERIFY(::tcgetattr(fd, &after) == 0);
+    ::close(fd);
+    QCOMPARE(after.c_cc[VMIN], before.c_cc[VMIN]);
+    QCOMPARE(after.c_cc[VTIME], before.c_cc[VTIME]);
+}
+
+//the device answers one 32 byte message at a time, the time is taken from the master write
+//to the dataReady that completes the message
+void SerialTest::endToEndLatency()
+{
+    const int rounds = 2000;
+    const int messageSize = 32;
+
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 3000000));
+    serial.setLowLatencyMode(true); // the flag itself is not supported on a pty, VMIN/VTIME are
+
+    QByteArray received;
+    connect(&serial, &Serial::dataReady, &serial, [&](const QByteArray &data) { received.append(data); });
+
+    LatencyHistogram latency;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < rounds; ++i) {
+        QByteArray message(messageSize, char('A' + i % 26));
+        const int target = received.size() + messageSize;
+        const qint64 sentNs = clock.nsecsElapsed();
+        QVERIFY(pty.write(message));
+        QVERIFY2(TestUtil::waitUntil([&]() { return received.size() >= target; }, 2000),
+                 qPrintable(QString("message %1 not received").arg(i)));
+        latency.record((clock.nsecsElapsed() - sentNs) / 1000);
+        QCOMPARE(received.mid(received.size() - messageSize), message);
+    }
+
+    serial.sendData("reply");
+    QVERIFY(TestUtil::waitUntil([&]() { return pty.readAll() == "reply"; }, 2000));
+
+    const Serial::ReadLatencyStats stats = serial.readLatency();
+    qInfo().noquote() << "pty write to dataReady" << latency.toString();
+    qInfo().noquote() << QString("reads %1, bytes %2, max chunk %3, estimated queueing avg %4 us max %5 us")
+                         .arg(stats.reads).arg(stats.bytes).arg(stats.maxChunk)
+                         .arg(stats.averageQueuedUs).arg(stats.maxQueuedUs);
+    QCOMPARE(stats.bytes, quint64(rounds) * messageSize);
+    QCOMPARE(latency.count(), quint64(rounds));
+}
+
+//a pty has no kernel RS-485, TIOCGRS485 fails and RTS is toggled in software. the turnaround is
+//only measured when our own frame is not echoed back
+void SerialTest::rs485SoftwareFallback()
+{
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 115200));
+    QString error;
+    SerialRs485Options options;
+    options.enabled = true;
+    QVERIFY(!options.apply(serial.serial->handle(), &error));
+    QVERIFY(error.startsWith("TIOCGRS485"));
+
+    serial.setRs485(options);
+    QVERIFY(serial.isRs485SoftwareRts());
+    int chunks = 0;
+    connect(&serial, &Serial::dataReady, &serial, [&](const QByteArray &) { ++chunks; });
+
+    QByteArray sent;
+    serial.sendData("request");
+    QVERIFY(TestUtil::waitUntil([&]() { sent += pty.readAll(); return sent == "request"; }, 2000));
+    QVERIFY(pty.write("reply"));
+    QVERIFY(TestUtil::waitUntil([&]() { return chunks > 0; }, 2000));
+    QCOMPARE(serial.turnaroundHistogram().count(), quint64(1));
+
+    options.receiveDuringSend = true;
+    serial.setRs485(options);
+    sent.clear();
+    serial.sendData("request");
+    QVERIFY(TestUtil::waitUntil([&]() { sent += pty.readAll(); return sent == "request"; }, 2000));
+    QVERIFY(pty.write("request")); // the echo of our own frame
+    QVERIFY(TestUtil::waitUntil([&]() { return chunks > 1; }, 2000));
+    QCOMPARE(serial.turnaroundHistogram().count(), quint64(1));
+}
+
+void SerialTest::histogramBucketPlacement_data()
+{
+    QTest::addColumn<qint64>("us");
+    QTest::addColumn<int>("bucket");
+    QTest::newRow("negative") << qint64(-5) << 0;
+    QTest::newRow("0 us") << qint64(0) << 0;
+    QTest::newRow("1 us") << qint64(1) << 1;
+    QTest::newRow("2 us") << qint64(2) << 2;
+    QTest::newRow("3 us") << qint64(3) << 2;
+    QTest::newRow("4 us") << qint64(4) << 3;
+    QTest::newRow("1023 us") << qint64(1023) << 10;
+    QTest::newRow("1024 us") << qint64(1024) << 11;
+    QTest::newRow("1 s") << qint64(1000000) << 20;
+    QTest::newRow("1 hour") << qint64(3600) * 1000000 << LatencyHistogram::BucketCount - 1;
+}
+
+//bucket i holds [2^(i-1), 2^i) us, the last one is open ended
+void SerialTest::histogramBucketPlacement()
+{
+    QFETCH(qint64, us);
+    QFETCH(int, bucket);
+
+    LatencyHistogram histogram;
+    histogram.record(us);
+    for (int i = 0; i < LatencyHistogram::BucketCount; ++i)
+        QCOMPARE(histogram.bucket(i), quint64(i == bucket ? 1 : 0));
+    if (bucket < LatencyHistogram::BucketCount - 1)
+        QVERIFY(qMax(us, qint64(0)) < LatencyHistogram::bucketUpperUs(bucket));
+    if (bucket > 0)
+        QVERIFY(us >= LatencyHistogram::bucketUpperUs(bucket - 1));
+}
+
+//percentiles report the upper bound of the bucket holding that rank, capped by the maximum
+void SerialTest::histogramPercentiles()
+{
+    LatencyHistogram histogram;
+    QCOMPARE(histogram.percentileUs(50.0), qint64(0));
+    QCOMPARE(histogram.minUs(), qint64(0));
+
+    for (int i = 0; i < 98; ++i)
+        histogram.record(10);   // [8, 16)
+    histogram.record(300);      // [256, 512)
+    histogram.record(5000);     // [4096, 8192)
+    QCOMPARE(histogram.count(), quint64(100));
+    QCOMPARE(histogram.minUs(), qint64(10));
+    QCOMPARE(histogram.maxUs(), qint64(5000));
+    QCOMPARE(histogram.meanUs(), qint64((98 * 10 + 300 + 5000) / 100));
+
+    QCOMPARE(histogram.percentileUs(0.0), qint64(16));
+    QCOMPARE(histogram.percentileUs(50.0), qint64(16));
+    QCOMPARE(histogram.percentileUs(97.0), qint64(16));
+    QCOMPARE(histogram.percentileUs(99.0), qint64(512));
+    QCOMPARE(histogram.percentileUs(100.0), qint64(5000)); // bucket bound 8192, capped at max
+    QCOMPARE(histogram.percentileUs(150.0), qint64(5000));
+
+    histogram.reset();
+    QCOMPARE(histogram.count(), quint64(0));
+    QCOMPARE(histogram.bucket(4), quint64(0));
+}
+
+//chunks written 20 ms apart land in the gap bucket [16384, 32768) us or above, and a dataReady
+//slot that takes 2 ms shows up in every readToEmit sample
+void SerialTest::chunkTimingHistograms()
+{
+    const int chunks = 20;
+    const int spacingMs = 20;
+    const int slotUs = 2000;
+
+    PtyPair pty;
+    QVERIFY(pty.isValid());
+    Serial serial;
+    QVERIFY(serial.connectDevice(pty.slavePath(), 115200));
+    QByteArray received;
+    connect(&serial, &Serial::dataReady, &serial, [&](const QByteArray &data) {
+        received.append(data);
+        QElapsedTimer slot;
+        slot.start();
+        while (slot.nsecsElapsed() < slotUs * 1000)
+            ; // busy, a sleep could return early
+    });
+    serial.resetTiming();
+    serial.resetReadLatency();
+
+    for (int i = 0; i < chunks; ++i) {
+        const QByteArray chunk(8, char('a' + i));
+        const int target = received.size() + chunk.size();
+        QVERIFY(pty.write(chunk));
+        QVERIFY(TestUtil::waitUntil([&]() { return received.size() >= target; }, 2000));
+        QTest::qWait(spacingMs);
+    }
+
+    const quint64 reads = serial.readLatency().reads;
+    const LatencyHistogram &gap = serial.gapHistogram();
+    const LatencyHistogram &readToEmit = serial.readToEmitHistogram();
+    qInfo().noquote() << "gap" << gap.toString();
+    qInfo().noquote() << "readToEmit" << readToEmit.toString();
+    QVERIFY(reads >= quint64(chunks)); // a chunk may arrive in two reads
+    QCOMPARE(readToEmit.count(), reads);
+    QCOMPARE(gap.count(), reads - 1);
+
+    quint64 spaced = 0;
+    for (int i = 15; i < LatencyHistogram::BucketCount; ++i)
+        spaced += gap.bucket(i);
+    QCOMPARE(spaced, quint64(chunks - 1)); // split reads only add short gaps
+    QVERIFY(gap.percentileUs(100.0) >= spacingMs * 1000);
+    QVERIFY2(readToEmit.minUs() >= slotUs, qPrintable(readToEmit.toString()));
+}
+
+QTEST_GUILESS_MAIN(SerialTest)
+#include "tst_serial.moc"
@@ -0,0 +1,138 @@
+#include <QtTest>
+#include <QVector>
+#include <memory>
+#include "serialmanager.h"
+#include "latencyhistogram.h"
+#include "ptypair.h"
+#include "testutil.h"
+
+#include <ctime>
+
+//SerialManager with many pty pairs on one or two epoll loops, per port latency and CPU use (user-022)
+class SerialManagerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void manyPorts_data();
+    void manyPorts();
+    void sendReachesDevice();
+};
+
+//the clock of SerialChunk::timestampNs
+static qint64 monotonicNs()
+{
+    timespec now;
+    ::clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<qint64>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void SerialManagerTest::initTestCase()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("epoll and pty based, Linux only");
+#endif
+    TestUtil::raiseFileLimit();
+}
+
+void SerialManagerTest::manyPorts_data()
+{
+    QTest::addColumn<int>("portCount");
+    QTest::addColumn<int>("loopCount");
+    QTest::newRow("16 ports, 1 loop") << 16 << 1;
+    QTest::newRow("32 ports, 1 loop") << 32 << 1;
+    QTest::newRow("32 ports, 2 loops") << 32 << 2;
+}
+
+//every round each device sends one message, the round ends when all of them arrived through
+//chunkReceived. wakeup latency: device write to the epoll wakeup stamped on the chunk,
+//delivery latency: device write to the queued chunkReceived slot on this thread
+void SerialManagerTest::manyPorts()
+{
+    QFETCH(int, portCount);
+    QFETCH(int, loopCount);
+    const int rounds = 200;
+    const int messageSize = 16;
+
+    std::vector<std::unique_ptr<PtyPair>> devices;
+    SerialManager manager(loopCount);
+    QHash<int, int> indexOf;
+    for (int i = 0; i < portCount; ++i) {
+        devices.emplace_back(new PtyPair);
+        QVERIFY(devices.back()->isValid());
+        const int id = manager.addPort(devices.back()->slavePath(), 115200);
+        QVERIFY(id > 0);
+        indexOf.insert(id, i);
+    }
+    QCOMPARE(manager.portCount(), portCount);
+
+    QVector<int> pending(portCount);
+    QVector<qint64> sentNs(portCount);
+    QVector<LatencyHistogram> wakeup(portCount);
+    LatencyHistogram delivery;
+    int complete = 0;
+    connect(&manager, &SerialManager::chunkReceived, &manager, [&](const SerialChunk &chunk) {
+        const int i = indexOf.value(chunk.portId, -1);
+        if (i < 0 || pending[i] <= 0)
+            return;
+        pending[i] -= chunk.data.size();
+        if (pending[i] <= 0) {
+            wakeup[i].record((chunk.timestampNs - sentNs[i]) / 1000);
+            delivery.record((monotonicNs() - sentNs[i]) / 1000);
+            ++complete;
+        }
+    });
+    manager.start();
+
+    const QByteArray message(messageSize, 'd');
+    const qint64 cpuStart = TestUtil::processCpuUs();
+    const qint64 wallStart = monotonicNs();
+    for (int round = 0; round < rounds; ++round) {
+        complete = 0;
+        for (int i = 0; i < portCount; ++i) {
+            pending[i] = messageSize;
+            sentNs[i] = monotonicNs();
+            QVERIFY(devices[i]->write(message));
+        }
+        QVERIFY2(TestUtil::waitUntil([&]() { return complete == portCount; }, 5000),
+                 qPrintable(QString("round %1: %2 of %3 ports").arg(round).arg(complete).arg(portCount)));
+    }
+    const qint64 wallUs = (monotonicNs() - wallStart) / 1000;
+    const qint64 cpuUs = TestUtil::processCpuUs() - cpuStart;
+    manager.stop();
+
+    qint64 worstPortP50 = 0;
+    qint64 worstPortP99 = 0;
+    for (int i = 0; i < portCount; ++i) {
+        QCOMPARE(wakeup[i].count(), quint64(rounds));
+        worstPortP50 = qMax(worstPortP50, wakeup[i].percentileUs(50.0));
+        worstPortP99 = qMax(worstPortP99, wakeup[i].percentileUs(99.0));
+    }
+    qInfo().noquote() << QString("%1 ports on %2 loop(s), %3 rounds in %4 ms, cpu %5% of one core")
+                         .arg(portCount).arg(loopCount).arg(rounds).arg(wallUs / 1000)
+                         .arg(100.0 * cpuUs / qMax<qint64>(1, wallUs), 0, 'f', 1);
+    qInfo().noquote() << QString("write to wakeup, worst port p50 %1 us, worst port p99 %2 us").arg(worstPortP50).arg(worstPortP99);
+    qInfo().noquote() << "write to chunkReceived" << delivery.toString();
+    QCOMPARE(delivery.count(), quint64(rounds) * portCount);
+    for (int id : manager.portIds())
+        QCOMPARE(manager.stats(id).bytesReceived, quint64(rounds) * messageSize);
+}
+
+void SerialManagerTest::sendReachesDevice()
+{
+    PtyPair device;
+    QVERIFY(device.isValid());
+    SerialManager manager;
+    const int id = manager.addPort(device.slavePath(), 115200);
+    QVERIFY(id > 0);
+    manager.start();
+    QVERIFY(manager.sendData(id, "poll"));
+    QByteArray seen;
+    QVERIFY(TestUtil::waitUntil([&]() { seen += device.readAll(); return seen.size() >= 4; }, 2000));
+    QCOMPARE(seen, QByteArray("poll"));
+    manager.stop();
+}
+
+QTEST_GUILESS_MAIN(SerialManagerTest)
+#include "tst_serialmanager.moc"
@@ -0,0 +1,231 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "tcp.h"
+#include "tcpsocketoptions.h"
+#include "latencyhistogram.h"
+#include "testutil.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+
+//TcpSocketOptions on loopback: what reaches the descriptor, echo latency per option and how
+//fast a hung peer is noticed (user-018). a peer host that vanishes needs packet loss, which
+//loopback cannot produce without root (netns/iptables), so keepalive timing is only checked
+//on the descriptor and the detection case uses a peer that stops reading (zero window)
+class SocketOptionsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void optionsReachDescriptor();
+    void echoLatency_data();
+    void echoLatency();
+    void hungPeerDetection_data();
+    void hungPeerDetection();
+};
+
+static quint16 freePort()
+{
+    QTcpServer probe;
+    probe.listen(QHostAddress::LocalHost, 0);
+    return probe.serverPort();
+}
+
+static int intOption(int fd, int level, int name)
+{
+    int value = -1;
+    socklen_t size = sizeof(value);
+    ::getsockopt(fd, level, name, &value, &size);
+    return value;
+}
+
+//accepts one connection and never reads from it, its tiny receive buffer closes the window fast
+class StalledPeer
+{
+public:
+    StalledPeer()
+    {
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        const int small = 4096;
+        ::setsockopt(listenFd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small)); // inherited by the accepted socket
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t size = sizeof(address);
+        if (::bind(listenFd, reinterpret_cast<sockaddr *>(&address), size) == 0 && ::listen(listenFd, 1) == 0
+                && ::getsockname(listenFd, reinterpret_cast<sockaddr *>(&address), &size) == 0)
+            listenPort = ntohs(address.sin_port);
+    }
+    ~StalledPeer()
+    {
+        if (peerFd >= 0)
+            ::close(peerFd);
+        if (listenFd >= 0)
+            ::close(listenFd);
+    }
+    quint16 port() const { return listenPort; }
+    bool accept()
+    {
+        peerFd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        return peerFd >= 0;
+    }
+
+private:
+    int listenFd = -1;
+    int peerFd = -1;
+    quint16 listenPort = 0;
+};
+
+void SocketOptionsTest::initTestCase()
+{
+#ifndef Q_OS_LINUX
+    QSKIP("Linux socket options");
+#endif
+}
+
+void SocketOptionsTest::optionsReachDescriptor()
+{
+    QTcpServer listener;
+    QVERIFY(listener.listen(QHostAddress::LocalHost, 0));
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, listener.serverPort());
+    QVERIFY(socket.waitForConnected(2000));
+
+    TcpSocketOptions options;
+    options.keepAliveIdleSec = 5;
+    options.keepAliveIntervalSec = 2;
+    options.keepAliveCount = 3;
+    options.userTimeoutMs = 4000;
+    options.sendBufferSize = 32 * 1024;
+    QString error;
+    QVERIFY2(options.apply(socket.socketDescriptor(), &error), qPrintable(error));
+
+    const int fd = static_cast<int>(socket.socketDescriptor());
+    QCOMPARE(intOption(fd, IPPROTO_TCP, TCP_KEEPIDLE), 5);
+    QCOMPARE(intOption(fd, IPPROTO_TCP, TCP_KEEPINTVL), 2);
+    QCOMPARE(intOption(fd, IPPROTO_TCP, TCP_KEEPCNT), 3);
+    QCOMPARE(intOption(fd, IPPROTO_TCP, TCP_USER_TIMEOUT), 4000);
+    QCOMPARE(intOption(fd, SOL_SOCKET, SO_KEEPALIVE), 1);
+    QVERIFY(intOption(fd, SOL_SOCKET, SO_SNDBUF) >= 32 * 1024); // the kernel doubles it
+}
+
+void SocketOptionsTest::echoLatency_data()
+{
+    QTest::addColumn<int>("buffers");
+    QTest::addColumn<bool>("quickAck");
+    QTest::addColumn<int>("busyPollUs");
+    QTest::newRow("defaults") << 0 << false << 0;
+    QTest::newRow("small buffers") << 8192 << false << 0;
+    QTest::newRow("quick ack") << 0 << true << 0;
+    QTest::newRow("busy poll 50 us") << 0 << false << 50;
+    QTest::newRow("all") << 8192 << true << 50;
+}
+
+//Tcp client and Tcp server with the same options, one 64 byte message in flight
+void SocketOptionsTest::echoLatency()
+{
+    QFETCH(int, buffers);
+    QFETCH(bool, quickAck);
+    QFETCH(int, busyPollUs);
+    const int rounds = 2000;
+    const int messageSize = 64;
+
+    TcpSocketOptions options;
+    options.receiveBufferSize = buffers;
+    options.sendBufferSize = buffers;
+    options.quickAck = quickAck;
+    options.busyPollUs = busyPollUs;
+
+    Tcp server;
+    Tcp client;
+    server.setSocketOptions(options);
+    client.setSocketOptions(options);
+    int echoed = 0;
+    connect(&server, &Tcp::dataReceived, &server, [&](int connectionId, const QByteArray &data) {
+        server.sendData(connectionId, data);
+    });
+    connect(&client, &Tcp::dataReady, &client, [&](const QByteArray &data) { echoed += data.size(); });
+    const quint16 port = freePort();
+    QVERIFY(server.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+    QVERIFY(client.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return server.connectionCount() == 1 && client.linkState() == Tcp::LinkState::Connected; }, 2000));
+
+    const QByteArray message(messageSize, 'q');
+    LatencyHistogram rtt;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < rounds; ++i) {
+        const int target = echoed + messageSize;
+        const qint64 sentNs = clock.nsecsElapsed();
+        client.sendData(message);
+        QVERIFY(TestUtil::waitUntil([&]() { return echoed >= target; }, 5000));
+        rtt.record((clock.nsecsElapsed() - sentNs) / 1000);
+    }
+    qInfo().noquote() << QTest::currentDataTag() << rtt.toString();
+    QCOMPARE(rtt.count(), quint64(rounds));
+}
+
+void SocketOptionsTest::hungPeerDetection_data()
+{
+    QTest::addColumn<int>("userTimeoutMs");
+    QTest::addColumn<int>("keepAliveSec");
+    QTest::newRow("TCP_USER_TIMEOUT 500 ms") << 500 << 0;
+    QTest::newRow("TCP_USER_TIMEOUT 2000 ms") << 2000 << 0;
+    QTest::newRow("keepalive 1 s + 1 s x 2") << 0 << 1;
+    QTest::newRow("kernel default") << 0 << 0;
+}
+
+//the peer stops reading, our data piles up behind a zero window. with TCP_USER_TIMEOUT the kernel
+//gives up once nothing moved for that long, the default keeps probing for minutes. keepalive does
+//not help here: the kernel only sends keepalive probes on an idle link with nothing in flight, and
+//the stalled peer still acks the zero window probes
+void SocketOptionsTest::hungPeerDetection()
+{
+    QFETCH(int, userTimeoutMs);
+    QFETCH(int, keepAliveSec);
+
+    StalledPeer peer;
+    QVERIFY(peer.port() > 0);
+    TcpSocketOptions options;
+    options.sendBufferSize = 8192;
+    options.userTimeoutMs = userTimeoutMs;
+    options.keepAliveIdleSec = keepAliveSec;
+    options.keepAliveIntervalSec = keepAliveSec;
+    options.keepAliveCount = keepAliveSec > 0 ? 2 : 0;
+
+    Tcp client;
+    client.setSocketOptions(options);
+    QVERIFY(client.connectDevice("127.0.0.1", peer.port(), Tcp::TcpRole::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return client.linkState() == Tcp::LinkState::Connected; }, 2000));
+    QVERIFY(peer.accept());
+
+    const QByteArray block(16 * 1024, 'z');
+    for (int i = 0; i < 64; ++i)
+        client.sendData(block); // far more than both socket buffers hold
+    QElapsedTimer clock;
+    clock.start();
+    const int keepAliveMs = keepAliveSec * 1000 * (1 + options.keepAliveCount);
+    const int waitMs = userTimeoutMs > 0 ? userTimeoutMs * 4 + 2000 : qMax(3000, keepAliveMs * 2);
+    const bool detected = TestUtil::waitUntil([&]() { return client.linkState() != Tcp::LinkState::Connected; }, waitMs);
+    const qint64 detectionMs = clock.elapsed();
+
+    if (userTimeoutMs > 0) {
+        qInfo().noquote() << QTest::currentDataTag() << ": hung peer detected after" << detectionMs << "ms";
+        QVERIFY2(detected, "TCP_USER_TIMEOUT did not drop the stalled connection");
+        QVERIFY(detectionMs >= userTimeoutMs / 2);
+    } else {
+        qInfo().noquote() << QTest::currentDataTag() << ": hung peer not detected within" << waitMs << "ms";
+        QVERIFY(!detected);
+    }
+}
+
+QTEST_GUILESS_MAIN(SocketOptionsTest)
+#include "tst_socketoptions.moc"
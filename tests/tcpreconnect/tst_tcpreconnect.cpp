@@ -0,0 +1,200 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "tcp.h"
+#include "reconnectpolicy.h"
+#include "testutil.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#ifdef Q_OS_UNIX
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+//client reconnect, connect timeout, failover and recovery timing over loopback (user-017)
+class TcpReconnectTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void delayStaysInBounds();
+    void failedConnectRetries();
+    void connectTimeoutEndsHangingAttempt();
+    void failoverRotatesEndpoints();
+    void recoveryAfterFlap();
+};
+
+static quint16 freePort()
+{
+    QTcpServer probe;
+    probe.listen(QHostAddress::LocalHost, 0);
+    return probe.serverPort();
+}
+
+static QString endpoint(quint16 port)
+{
+    return QString("127.0.0.1:%1").arg(port);
+}
+
+//nominal delay doubles from 100 ms up to the 5 s cap, jitter keeps each sample within +-20 % of it
+void TcpReconnectTest::delayStaysInBounds()
+{
+    const ReconnectPolicy policy(100, 5000, 2.0, 0.2);
+    for (int attempt = 0; attempt < 40; ++attempt) {
+        const double nominal = qMin(100.0 * std::pow(2.0, qMin(attempt, 20)), 5000.0);
+        int low = INT_MAX;
+        int high = 0;
+        for (int sample = 0; sample < 500; ++sample) {
+            const int delay = policy.delayMs(attempt);
+            low = qMin(low, delay);
+            high = qMax(high, delay);
+        }
+        QVERIFY2(low >= int(nominal * 0.8) - 1, qPrintable(QString("attempt %1: %2 ms below the jitter range").arg(attempt).arg(low)));
+        QVERIFY2(high <= int(nominal * 1.2) + 1, qPrintable(QString("attempt %1: %2 ms above the jitter range").arg(attempt).arg(high)));
+        QVERIFY2(high <= 5000, qPrintable(QString("attempt %1: %2 ms above the cap").arg(attempt).arg(high)));
+        QVERIFY(high > low); // jitter actually spreads
+    }
+
+    const ReconnectPolicy fixed = ReconnectPolicy::fixed(250);
+    for (int attempt : {0, 1, 10, 1000})
+        QCOMPARE(fixed.delayMs(attempt), 250);
+    QCOMPARE(ReconnectPolicy(100, 30000, 2.0, 0.0).delayMs(1000000), 30000); // no overflow for long outages
+}
+
+//nothing listens at first, the client keeps trying and connects once the server appears
+void TcpReconnectTest::failedConnectRetries()
+{
+    const quint16 port = freePort();
+    Tcp tcp;
+    tcp.setReconnectPolicy(ReconnectPolicy::fixed(30));
+    QList<Tcp::LinkState> states;
+    connect(&tcp, &Tcp::linkStateChanged, this, [&](Tcp::LinkState state) { states.append(state); });
+    QVERIFY(tcp.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client, true, true, 30));
+
+    QVERIFY(TestUtil::waitUntil([&]() { return std::count(states.begin(), states.end(), Tcp::LinkState::Connecting) >= 3; }, 5000));
+    QVERIFY(!states.contains(Tcp::LinkState::Connected));
+    QVERIFY(states.contains(Tcp::LinkState::Backoff));
+
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, port));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Connected; }, 5000));
+    QCOMPARE(tcp.currentEndpoint(), endpoint(port));
+    QCOMPARE(tcp.lastRecoveryMs(), qint64(-1)); // never connected before, nothing was recovered
+}
+
+//a listener whose accept queue is full drops further SYNs, so the connect hangs until the timeout
+void TcpReconnectTest::connectTimeoutEndsHangingAttempt()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("needs a raw listening socket");
+#else
+    const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    QVERIFY(fd >= 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    QCOMPARE(::bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)), 0);
+    QCOMPARE(::listen(fd, 0), 0);
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    const quint16 port = ntohs(addr.sin_port);
+
+    //fill the accept queue, never accepted
+    QList<QTcpSocket *> fillers;
+    for (int i = 0; i < 4; ++i) {
+        QTcpSocket *filler = new QTcpSocket(this);
+        filler->connectToHost(QHostAddress::LocalHost, port);
+        fillers.append(filler);
+    }
+    QTest::qWait(200);
+
+    Tcp tcp;
+    tcp.setConnectTimeout(300);
+    QStringList errors;
+    connect(&tcp, &Tcp::errorOccurredSignal, this, [&](const QString &error) { errors.append(error); });
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY(tcp.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client));
+    QCOMPARE(tcp.linkState(), Tcp::LinkState::Connecting);
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Disconnected; }, 5000));
+    QVERIFY2(clock.elapsed() >= 250, "the attempt failed before the timeout, the listener did not hang it");
+    QVERIFY(clock.elapsed() < 2000);
+    QVERIFY(errors.contains("TCP connect timeout"));
+
+    qDeleteAll(fillers);
+    ::close(fd);
+#endif
+}
+
+//failed attempts move through primary and failovers in order, the first one listening wins
+void TcpReconnectTest::failoverRotatesEndpoints()
+{
+    //both probes held open at once so the two closed ports differ
+    QTcpServer probeA;
+    QTcpServer probeB;
+    QVERIFY(probeA.listen(QHostAddress::LocalHost, 0) && probeB.listen(QHostAddress::LocalHost, 0));
+    const quint16 primary = probeA.serverPort();
+    const quint16 second = probeB.serverPort();
+    probeA.close();
+    probeB.close();
+    QTcpServer third;
+    QVERIFY(third.listen(QHostAddress::LocalHost, 0));
+
+    Tcp tcp;
+    tcp.setReconnectPolicy(ReconnectPolicy::fixed(20));
+    tcp.addFailoverEndpoint("127.0.0.1", second);
+    tcp.addFailoverEndpoint("127.0.0.1", third.serverPort());
+    QStringList tried;
+    connect(&tcp, &Tcp::linkStateChanged, this, [&](Tcp::LinkState state) {
+        if (state == Tcp::LinkState::Connecting)
+            tried.append(tcp.currentEndpoint());
+    });
+    QVERIFY(tcp.connectDevice("127.0.0.1", primary, Tcp::TcpRole::Client, true, true, 20));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Connected; }, 5000));
+    QCOMPARE(tried, (QStringList{endpoint(primary), endpoint(second), endpoint(third.serverPort())}));
+    QCOMPARE(tcp.currentEndpoint(), endpoint(third.serverPort()));
+}
+
+//the server drops the link, the client comes back on the same endpoint and reports the downtime
+void TcpReconnectTest::recoveryAfterFlap()
+{
+    QTcpServer server;
+    QVERIFY(server.listen(QHostAddress::LocalHost, 0));
+    QList<QTcpSocket *> accepted;
+    connect(&server, &QTcpServer::newConnection, this, [&]() {
+        while (server.hasPendingConnections())
+            accepted.append(server.nextPendingConnection());
+    });
+
+    Tcp tcp;
+    const int retryMs = 150;
+    tcp.setReconnectPolicy(ReconnectPolicy::fixed(retryMs));
+    QList<qint64> recoveries;
+    connect(&tcp, &Tcp::recovered, this, [&](qint64 ms) { recoveries.append(ms); });
+    QVERIFY(tcp.connectDevice("127.0.0.1", server.serverPort(), Tcp::TcpRole::Client, true, true, retryMs));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Connected && accepted.size() == 1; }, 5000));
+    QVERIFY(recoveries.isEmpty());
+
+    QElapsedTimer flap;
+    flap.start();
+    accepted.first()->abort();
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Backoff; }, 5000));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcp.linkState() == Tcp::LinkState::Connected; }, 5000));
+    const qint64 observed = flap.elapsed();
+
+    QCOMPARE(recoveries.size(), 1);
+    QCOMPARE(tcp.lastRecoveryMs(), recoveries.first());
+    QVERIFY2(recoveries.first() >= retryMs - 5, qPrintable(QString("%1 ms").arg(recoveries.first())));
+    QVERIFY2(recoveries.first() <= observed, qPrintable(QString("%1 ms reported, %2 ms observed").arg(recoveries.first()).arg(observed)));
+    QCOMPARE(tcp.currentEndpoint(), endpoint(server.serverPort()));
+    QCOMPARE(accepted.size(), 2);
+    qDeleteAll(accepted);
+}
+
+QTEST_GUILESS_MAIN(TcpReconnectTest)
+#include "tst_tcpreconnect.moc"
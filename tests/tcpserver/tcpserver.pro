@@ -0,0 +1,25 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_tcpserver
+
+SOURCES += \
+    tst_tcpserver.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/reconnectpolicy.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/sendqueue.cpp \
+    $$COMMMODULE/tcp.cpp \
+    $$COMMMODULE/tcpsocketoptions.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/sendqueue.h \
+    $$COMMMODULE/tcp.h
@@ -0,0 +1,143 @@
+#include <QtTest>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QVector>
+#include "tcp.h"
+#include "latencyhistogram.h"
+#include "testutil.h"
+
+//TcpRole::Server under load from many loopback clients (user-011)
+class TcpServerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void manyClientsEcho();
+    void closeConnectionFromDataSlot();
+    void closeConnectionFromFrameSlot();
+};
+
+static quint16 freePort()
+{
+    QTcpServer probe;
+    probe.listen(QHostAddress::LocalHost, 0);
+    return probe.serverPort();
+}
+
+void TcpServerTest::initTestCase()
+{
+    TestUtil::raiseFileLimit();
+}
+
+//every client sends a message per round and waits for the echo, clients and server share this
+//thread's event loop, so the numbers are a floor for one I/O thread serving all sockets
+void TcpServerTest::manyClientsEcho()
+{
+    const int clientCount = 500;
+    const int rounds = 20;
+    const int messageSize = 64;
+
+    Tcp server;
+    const quint16 port = freePort();
+    connect(&server, &Tcp::dataReceived, &server, [&server](int connectionId, const QByteArray &data) {
+        server.sendData(connectionId, data);
+    });
+    QVERIFY(server.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+
+    QObject owner;
+    QVector<QTcpSocket *> clients;
+    QVector<qint64> sentNs(clientCount);
+    QVector<int> pending(clientCount);
+    LatencyHistogram rtt;
+    QElapsedTimer clock;
+    clock.start();
+    int echoed = 0;
+    for (int i = 0; i < clientCount; ++i) {
+        QTcpSocket *client = new QTcpSocket(&owner);
+        connect(client, &QTcpSocket::readyRead, client, [&, client, i]() {
+            pending[i] -= client->readAll().size();
+            if (pending[i] == 0) {
+                rtt.record((clock.nsecsElapsed() - sentNs[i]) / 1000);
+                ++echoed;
+            }
+        });
+        client->connectToHost(QHostAddress::LocalHost, port);
+        clients.append(client);
+    }
+    QVERIFY2(TestUtil::waitUntil([&]() { return server.connectionCount() == clientCount; }, 30000),
+             qPrintable(QString("%1 of %2 clients accepted").arg(server.connectionCount()).arg(clientCount)));
+
+    const QByteArray message(messageSize, 'x');
+    QElapsedTimer wall;
+    wall.start();
+    for (int round = 0; round < rounds; ++round) {
+        echoed = 0;
+        for (int i = 0; i < clientCount; ++i) {
+            pending[i] = messageSize;
+            sentNs[i] = clock.nsecsElapsed();
+            clients[i]->write(message);
+        }
+        QVERIFY2(TestUtil::waitUntil([&]() { return echoed == clientCount; }, 10000),
+                 qPrintable(QString("round %1: %2 of %3 echoes").arg(round).arg(echoed).arg(clientCount)));
+    }
+    const double seconds = wall.nsecsElapsed() / 1e9;
+    const double messages = double(clientCount) * rounds;
+
+    qInfo().noquote() << QString("%1 connections, %2 echoes in %3 s, %4 msg/s, %5 MB/s each way, rtt %6")
+                         .arg(clientCount).arg(messages).arg(seconds, 0, 'f', 3)
+                         .arg(messages / seconds, 0, 'f', 0)
+                         .arg(messages * messageSize / seconds / 1e6, 0, 'f', 2)
+                         .arg(rtt.toString());
+    QCOMPARE(rtt.count(), quint64(messages));
+    QVERIFY2(rtt.percentileUs(99.0) < 500000, "p99 echo latency above 500 ms");
+}
+
+//a directly connected slot may close the connection it is being called for, the receive loop
+//must not touch the erased connection afterwards
+void TcpServerTest::closeConnectionFromDataSlot()
+{
+    Tcp server;
+    const quint16 port = freePort();
+    int closedId = -1;
+    connect(&server, &Tcp::dataReceived, &server, [&](int connectionId, const QByteArray &) {
+        server.closeConnection(connectionId);
+        closedId = connectionId;
+    });
+    int dataAfterClose = 0;
+    connect(&server, &Tcp::dataReady, &server, [&](const QByteArray &) { ++dataAfterClose; });
+    QVERIFY(server.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected(5000));
+    client.write(QByteArray(200000, 'a')); // several reads worth, the loop would go on after the close
+    QVERIFY(TestUtil::waitUntil([&]() { return closedId != -1 && client.state() == QAbstractSocket::UnconnectedState; }, 5000));
+    QCOMPARE(server.connectionCount(), 0);
+    QCOMPARE(dataAfterClose, 0); // dataReady comes after dataReceived, the chunk is not delivered twice
+}
+
+void TcpServerTest::closeConnectionFromFrameSlot()
+{
+    Tcp server;
+    const quint16 port = freePort();
+    server.setFraming('<', '>');
+    int frames = 0;
+    connect(&server, &Tcp::frameReceived, &server, [&](int connectionId, const QByteArray &) {
+        ++frames;
+        server.closeConnection(connectionId);
+    });
+    QVERIFY(server.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+
+    QTcpSocket client;
+    client.connectToHost(QHostAddress::LocalHost, port);
+    QVERIFY(client.waitForConnected(5000));
+    client.write("<1><2><3>");
+    QVERIFY(TestUtil::waitUntil([&]() { return frames > 0 && client.state() == QAbstractSocket::UnconnectedState; }, 5000));
+    QCOMPARE(server.connectionCount(), 0);
+    QTest::qWait(20);
+    QCOMPARE(frames, 1); // <2> and <3> were in the same chunk as the frame that closed the connection
+}
+
+QTEST_GUILESS_MAIN(TcpServerTest)
+#include "tst_tcpserver.moc"
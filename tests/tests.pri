@@ -0,0 +1,13 @@
+#common settings of the test projects, sources of the module are added by each project
+
+QT       += testlib
+QT       -= gui
+
+CONFIG += c++14 console testcase
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+COMMMODULE = $$PWD/..
+INCLUDEPATH += $$COMMMODULE $$PWD/common
+DEPENDPATH += $$COMMMODULE $$PWD/common
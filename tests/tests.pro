@@ -0,0 +1,33 @@
+#-------------------------------------------------
+#
+# CommModule tests and loopback/pty benchmarks
+# qmake && make && make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    bitpack \
+    bytescan \
+    bytestuffing \
+    checksum \
+    connectionmanager \
+    crc16 \
+    framecodec \
+    framereassembler \
+    framing \
+    packettrace \
+    queuedsignals \
+    registerconvert \
+    rtuframer \
+    rxchannel \
+    rxpool \
+    sendqueue \
+    serial \
+    serialmanager \
+    socketoptions \
+    tcpreconnect \
+    tcpserver \
+    udp \
+    unixsocket
@@ -0,0 +1,159 @@
+#include <QtTest>
+#include <QUdpSocket>
+#include <QNetworkDatagram>
+#include "udp.h"
+#include "testutil.h"
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+
+//Udp transport on loopback, batched receive against a plain QUdpSocket (user-019)
+class UdpTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void multicastOnUnicastInterface();
+    void invalidBindAddressFails();
+    void reconnectFromDataSlot();
+    void batchedAgainstNaive();
+};
+
+static quint16 freeUdpPort()
+{
+    QUdpSocket probe;
+    probe.bind(QHostAddress::LocalHost, 0);
+    return probe.localPort();
+}
+
+//native sender that picks the loopback interface for multicast
+static bool sendMulticast(const char *group, quint16 port, const QByteArray &data)
+{
+    const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    in_addr loopback;
+    ::inet_pton(AF_INET, "127.0.0.1", &loopback);
+    ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback));
+    sockaddr_in to;
+    std::memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    ::inet_pton(AF_INET, group, &to.sin_addr);
+    const bool ok = ::sendto(fd, data.constData(), static_cast<size_t>(data.size()), 0,
+                             reinterpret_cast<sockaddr *>(&to), sizeof(to)) == data.size();
+    ::close(fd);
+    return ok;
+}
+
+//the interface address selects where the group is joined, the socket must still see group traffic
+void UdpTest::multicastOnUnicastInterface()
+{
+    Udp udp;
+    const quint16 port = freeUdpPort();
+    QList<QByteArray> received;
+    connect(&udp, &Udp::dataReady, &udp, [&](const QByteArray &data) { received.append(data); });
+    QVERIFY(udp.connectDevice("127.0.0.1", port, "", 0, "239.255.42.99"));
+
+    QVERIFY(sendMulticast("239.255.42.99", port, "to the group"));
+    QVERIFY(TestUtil::waitUntil([&]() { return !received.isEmpty(); }, 2000));
+    QCOMPARE(received.first(), QByteArray("to the group"));
+}
+
+void UdpTest::invalidBindAddressFails()
+{
+    Udp udp;
+    int errors = 0;
+    connect(&udp, &Udp::errorOccurredSignal, &udp, [&](const QString &) { ++errors; });
+    QVERIFY(!udp.connectDevice("192.168.1.300", freeUdpPort()));
+    QVERIFY(!udp.isOpen());
+    QCOMPARE(errors, 1);
+    QVERIFY(!udp.connectDevice("127.0.0.1", freeUdpPort(), "", 0, "not-a-group"));
+    QVERIFY(!udp.isOpen());
+    QCOMPARE(errors, 2);
+}
+
+//reconnecting from a dataReady slot closes the socket and reallocates the batch slots under reciveData
+void UdpTest::reconnectFromDataSlot()
+{
+    Udp udp;
+    const quint16 first = freeUdpPort();
+    const quint16 second = freeUdpPort();
+    int datagrams = 0;
+    connect(&udp, &Udp::dataReady, &udp, [&](const QByteArray &) {
+        if (++datagrams == 1)
+            udp.connectDevice("127.0.0.1", second, "127.0.0.1", second);
+    });
+    QVERIFY(udp.connectDevice("127.0.0.1", first, "127.0.0.1", first, "", 8));
+
+    QList<QByteArray> burst;
+    for (int i = 0; i < 8; ++i)
+        burst.append(QByteArray(100, char('a' + i)));
+    QCOMPARE(udp.sendBatch(burst), 8); // all queued before the first read
+    QVERIFY(TestUtil::waitUntil([&]() { return datagrams >= 1; }, 2000));
+    QTest::qWait(50);
+    QCOMPARE(datagrams, 1); // the rest went with the old socket
+
+    udp.sendData("after");
+    QVERIFY(TestUtil::waitUntil([&]() { return datagrams == 2; }, 2000));
+}
+
+//bursts of datagrams sent with sendmmsg, received by Udp (recvmmsg) and by a QUdpSocket that
+//takes one datagram per readyRead
+void UdpTest::batchedAgainstNaive()
+{
+    const int burst = 128; // fits the default receive buffer, so nothing is dropped
+    const int bursts = 400;
+    const int total = burst * bursts;
+    const QByteArray payload(64, 'p');
+    QList<QByteArray> datagrams;
+    for (int i = 0; i < burst; ++i)
+        datagrams.append(payload);
+
+    const quint16 batchedPort = freeUdpPort();
+    const quint16 naivePort = freeUdpPort();
+    Udp sender;
+    QVERIFY(sender.connectDevice("127.0.0.1", 0, "127.0.0.1", batchedPort));
+
+    Udp batched;
+    int batchedCount = 0;
+    connect(&batched, &Udp::dataReady, &batched, [&](const QByteArray &) { ++batchedCount; });
+    QVERIFY(batched.connectDevice("127.0.0.1", batchedPort, "", 0, "", 64));
+
+    QElapsedTimer clock;
+    clock.start();
+    for (int b = 0; b < bursts; ++b) {
+        QCOMPARE(sender.sendBatch(datagrams), burst);
+        QVERIFY(TestUtil::waitUntil([&]() { return batchedCount == (b + 1) * burst; }, 2000));
+    }
+    const double batchedSeconds = clock.nsecsElapsed() / 1e9;
+
+    QUdpSocket naive;
+    int naiveCount = 0;
+    int naiveWakeups = 0;
+    connect(&naive, &QUdpSocket::readyRead, &naive, [&]() {
+        ++naiveWakeups;
+        if (naive.hasPendingDatagrams() && naive.receiveDatagram().data().size() == payload.size())
+            ++naiveCount;
+    });
+    QVERIFY(naive.bind(QHostAddress::LocalHost, naivePort));
+    QVERIFY(sender.connectDevice("127.0.0.1", 0, "127.0.0.1", naivePort));
+
+    clock.restart();
+    for (int b = 0; b < bursts; ++b) {
+        QCOMPARE(sender.sendBatch(datagrams), burst);
+        QVERIFY(TestUtil::waitUntil([&]() { return naiveCount == (b + 1) * burst; }, 2000));
+    }
+    const double naiveSeconds = clock.nsecsElapsed() / 1e9;
+
+    qInfo().noquote() << QString("batched: %1 datagrams/s, %2 datagrams per wakeup").arg(total / batchedSeconds, 0, 'f', 0)
+                         .arg(double(batched.datagramsReceived()) / batched.readWakeups(), 0, 'f', 1);
+    qInfo().noquote() << QString("naive:   %1 datagrams/s, %2 datagrams per wakeup").arg(total / naiveSeconds, 0, 'f', 0)
+                         .arg(double(naiveCount) / naiveWakeups, 0, 'f', 1);
+    QCOMPARE(batched.datagramsReceived(), quint64(total));
+    QVERIFY(batched.readWakeups() < batched.datagramsReceived());
+}
+
+QTEST_GUILESS_MAIN(UdpTest)
+#include "tst_udp.moc"
@@ -0,0 +1,14 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_udp
+
+SOURCES += \
+    tst_udp.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/udp.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/udp.h
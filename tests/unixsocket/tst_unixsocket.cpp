@@ -0,0 +1,230 @@
+#include <QtTest>
+#include <QTcpServer>
+#include "tcp.h"
+#include "unixsocket.h"
+#include "latencyhistogram.h"
+#include "testutil.h"
+
+#include <unistd.h>
+
+//UnixSocket against loopback TCP, both ends in this thread's event loop (user-020)
+class UnixSocketTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void pingPongLatency();
+    void streamThroughput();
+    void largeBlocksByDescriptor();
+    void disconnectFromAcceptSlot();
+    void reconnectFromDataSlot();
+};
+
+static quint16 freePort()
+{
+    QTcpServer probe;
+    probe.listen(QHostAddress::LocalHost, 0);
+    return probe.serverPort();
+}
+
+static std::string socketPath(const char *name)
+{
+    return QString("@commmodule-test-%1-%2").arg(::getpid()).arg(name).toStdString();
+}
+
+//one message in flight, send() writes it from the client and the echo comes back through the server
+static bool measureRoundTrips(const std::function<void(const QByteArray &)> &send, const int &echoedBytes,
+                              int rounds, int messageSize, LatencyHistogram &rtt)
+{
+    const QByteArray message(messageSize, 'm');
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < rounds; ++i) {
+        const int target = echoedBytes + messageSize;
+        const qint64 sentNs = clock.nsecsElapsed();
+        send(message);
+        if (!TestUtil::waitUntil([&]() { return echoedBytes >= target; }, 5000))
+            return false;
+        rtt.record((clock.nsecsElapsed() - sentNs) / 1000);
+    }
+    return true;
+}
+
+//blocks written back to back, returns MB/s at the receiver or 0 on timeout
+static double measureThroughput(const std::function<void(const QByteArray &)> &send, const qint64 &receivedBytes,
+                                int blocks, int blockSize)
+{
+    const QByteArray block(blockSize, 'b');
+    const qint64 target = receivedBytes + qint64(blocks) * blockSize;
+    QElapsedTimer clock;
+    clock.start();
+    for (int i = 0; i < blocks; ++i)
+        send(block);
+    if (!TestUtil::waitUntil([&]() { return receivedBytes >= target; }, 30000))
+        return 0;
+    return double(blocks) * blockSize / (clock.nsecsElapsed() / 1e9) / 1e6;
+}
+
+void UnixSocketTest::pingPongLatency()
+{
+    const int rounds = 2000;
+    const int messageSize = 64;
+
+    UnixSocket unixServer;
+    UnixSocket unixClient;
+    int unixEchoed = 0;
+    connect(&unixServer, &UnixSocket::dataReceived, &unixServer, [&](int connectionId, const QByteArray &data) {
+        unixServer.sendData(connectionId, data);
+    });
+    connect(&unixClient, &UnixSocket::dataReady, &unixClient, [&](const QByteArray &data) { unixEchoed += data.size(); });
+    const std::string path = socketPath("latency");
+    QVERIFY(unixServer.connectDevice(path, UnixSocket::Role::Server));
+    QVERIFY(unixClient.connectDevice(path, UnixSocket::Role::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return unixServer.connectionCount() == 1; }, 2000));
+
+    Tcp tcpServer;
+    Tcp tcpClient;
+    int tcpEchoed = 0;
+    connect(&tcpServer, &Tcp::dataReceived, &tcpServer, [&](int connectionId, const QByteArray &data) {
+        tcpServer.sendData(connectionId, data);
+    });
+    connect(&tcpClient, &Tcp::dataReady, &tcpClient, [&](const QByteArray &data) { tcpEchoed += data.size(); });
+    const quint16 port = freePort();
+    QVERIFY(tcpServer.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+    QVERIFY(tcpClient.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcpServer.connectionCount() == 1 && tcpClient.linkState() == Tcp::LinkState::Connected; }, 2000));
+
+    LatencyHistogram unixRtt;
+    LatencyHistogram tcpRtt;
+    QVERIFY(measureRoundTrips([&](const QByteArray &m) { unixClient.sendData(m); }, unixEchoed, rounds, messageSize, unixRtt));
+    QVERIFY(measureRoundTrips([&](const QByteArray &m) { tcpClient.sendData(m); }, tcpEchoed, rounds, messageSize, tcpRtt));
+
+    qInfo().noquote() << "unix stream rtt" << unixRtt.toString();
+    qInfo().noquote() << "loopback tcp rtt" << tcpRtt.toString();
+    QCOMPARE(unixRtt.count(), quint64(rounds));
+    QCOMPARE(tcpRtt.count(), quint64(rounds));
+}
+
+void UnixSocketTest::streamThroughput()
+{
+    const int blocks = 4096;
+    const int blockSize = 16 * 1024;
+
+    UnixSocket unixServer;
+    UnixSocket unixClient;
+    qint64 unixReceived = 0;
+    connect(&unixServer, &UnixSocket::dataReady, &unixServer, [&](const QByteArray &data) { unixReceived += data.size(); });
+    const std::string path = socketPath("throughput");
+    QVERIFY(unixServer.connectDevice(path, UnixSocket::Role::Server));
+    QVERIFY(unixClient.connectDevice(path, UnixSocket::Role::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return unixServer.connectionCount() == 1; }, 2000));
+
+    Tcp tcpServer;
+    Tcp tcpClient;
+    qint64 tcpReceived = 0;
+    connect(&tcpServer, &Tcp::dataReady, &tcpServer, [&](const QByteArray &data) { tcpReceived += data.size(); });
+    const quint16 port = freePort();
+    QVERIFY(tcpServer.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+    QVERIFY(tcpClient.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcpServer.connectionCount() == 1 && tcpClient.linkState() == Tcp::LinkState::Connected; }, 2000));
+
+    const double unixRate = measureThroughput([&](const QByteArray &b) { unixClient.sendData(b); }, unixReceived, blocks, blockSize);
+    const double tcpRate = measureThroughput([&](const QByteArray &b) { tcpClient.sendData(b); }, tcpReceived, blocks, blockSize);
+
+    qInfo().noquote() << QString("unix stream %1 MB/s, loopback tcp %2 MB/s").arg(unixRate, 0, 'f', 0).arg(tcpRate, 0, 'f', 0);
+    QVERIFY(unixRate > 0);
+    QVERIFY(tcpRate > 0);
+}
+
+//1 MB blocks, SeqPacket hands each over as a sealed memfd, TCP copies it through the socket buffers
+void UnixSocketTest::largeBlocksByDescriptor()
+{
+    const int blocks = 256;
+    const int blockSize = 1024 * 1024;
+
+    UnixSocket server;
+    UnixSocket client;
+    qint64 received = 0;
+    bool intact = true;
+    connect(&server, &UnixSocket::dataReady, &server, [&](const QByteArray &data) {
+        received += data.size();
+        intact = intact && data.size() == blockSize && data.at(blockSize - 1) == 'b';
+    });
+    const std::string path = socketPath("blocks");
+    QVERIFY(server.connectDevice(path, UnixSocket::Role::Server, UnixSocket::Mode::SeqPacket));
+    QVERIFY(client.connectDevice(path, UnixSocket::Role::Client, UnixSocket::Mode::SeqPacket));
+    client.setFdPassingThreshold(64 * 1024);
+    QVERIFY(TestUtil::waitUntil([&]() { return server.connectionCount() == 1; }, 2000));
+
+    Tcp tcpServer;
+    Tcp tcpClient;
+    qint64 tcpReceived = 0;
+    connect(&tcpServer, &Tcp::dataReady, &tcpServer, [&](const QByteArray &data) { tcpReceived += data.size(); });
+    const quint16 port = freePort();
+    QVERIFY(tcpServer.connectDevice("127.0.0.1", port, Tcp::TcpRole::Server));
+    QVERIFY(tcpClient.connectDevice("127.0.0.1", port, Tcp::TcpRole::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return tcpServer.connectionCount() == 1 && tcpClient.linkState() == Tcp::LinkState::Connected; }, 2000));
+
+    const double fdRate = measureThroughput([&](const QByteArray &b) { client.sendData(b); }, received, blocks, blockSize);
+    const double tcpRate = measureThroughput([&](const QByteArray &b) { tcpClient.sendData(b); }, tcpReceived, blocks, blockSize);
+
+    qInfo().noquote() << QString("1 MB blocks: seqpacket+memfd %1 MB/s, loopback tcp %2 MB/s").arg(fdRate, 0, 'f', 0).arg(tcpRate, 0, 'f', 0);
+    QVERIFY(fdRate > 0);
+    QVERIFY(intact);
+    QCOMPARE(client.blocksSentByFd(), quint64(blocks));
+    QCOMPARE(server.blocksReceivedByFd(), quint64(blocks));
+}
+
+//the listen notifier is the sender of the signal that ends up here, it must outlive the slot
+void UnixSocketTest::disconnectFromAcceptSlot()
+{
+    UnixSocket server;
+    UnixSocket client;
+    int accepted = 0;
+    connect(&server, &UnixSocket::clientConnected, &server, [&](int) {
+        ++accepted;
+        server.disconnectDevice();
+    });
+    const std::string path = socketPath("accept");
+    QVERIFY(server.connectDevice(path, UnixSocket::Role::Server));
+    QVERIFY(client.connectDevice(path, UnixSocket::Role::Client));
+    QVERIFY(TestUtil::waitUntil([&]() { return accepted == 1; }, 2000));
+    QVERIFY(!server.isOpen());
+
+    QVERIFY(server.connectDevice(path, UnixSocket::Role::Server)); // the name is free again
+    QTest::qWait(20);
+}
+
+//reconnecting from dataReceived replaces the receive pool under the chunk still being emitted,
+//reciveData must stop before dataReady instead of handing out the stale buffer
+void UnixSocketTest::reconnectFromDataSlot()
+{
+    UnixSocket server;
+    UnixSocket client;
+    const std::string first = socketPath("data-first");
+    const std::string second = socketPath("data-second");
+    int received = 0;
+    int ready = 0;
+    connect(&server, &UnixSocket::dataReceived, &server, [&](int, const QByteArray &) {
+        if (++received == 1)
+            QVERIFY(server.connectDevice(second, UnixSocket::Role::Server, UnixSocket::Mode::Stream, 4096));
+    });
+    connect(&server, &UnixSocket::dataReady, &server, [&](const QByteArray &) { ++ready; });
+    QVERIFY(server.connectDevice(first, UnixSocket::Role::Server));
+    QVERIFY(client.connectDevice(first, UnixSocket::Role::Client));
+    QTest::qWait(20);
+    client.sendData(QByteArray(1000, 'a'));
+    QVERIFY(TestUtil::waitUntil([&]() { return received == 1; }, 2000));
+    QTest::qWait(20);
+    QCOMPARE(ready, 0);
+
+    UnixSocket next;
+    QVERIFY(next.connectDevice(second, UnixSocket::Role::Client));
+    QTest::qWait(20);
+    next.sendData(QByteArray(1000, 'b'));
+    QVERIFY(TestUtil::waitUntil([&]() { return ready == 1; }, 2000));
+    QCOMPARE(received, 2);
+}
+
+QTEST_GUILESS_MAIN(UnixSocketTest)
+#include "tst_unixsocket.moc"
@@ -0,0 +1,27 @@
+include(../tests.pri)
+
+QT += network
+
+TARGET = tst_unixsocket
+
+SOURCES += \
+    tst_unixsocket.cpp \
+    $$COMMMODULE/bytescan.cpp \
+    $$COMMMODULE/bytestuffing.cpp \
+    $$COMMMODULE/framereassembler.cpp \
+    $$COMMMODULE/latencyhistogram.cpp \
+    $$COMMMODULE/packettrace.cpp \
+    $$COMMMODULE/reconnectpolicy.cpp \
+    $$COMMMODULE/rxbufferpool.cpp \
+    $$COMMMODULE/sendqueue.cpp \
+    $$COMMMODULE/tcp.cpp \
+    $$COMMMODULE/tcpsocketoptions.cpp \
+    $$COMMMODULE/unixsocket.cpp
+
+HEADERS += \
+    $$PWD/../common/testutil.h \
+    $$COMMMODULE/bytestuffing.h \
+    $$COMMMODULE/framereassembler.h \
+    $$COMMMODULE/sendqueue.h \
+    $$COMMMODULE/tcp.h \
+    $$COMMMODULE/unixsocket.h
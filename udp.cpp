@@ -0,0 +1,339 @@
+#include "udp.h"
+#include <QMetaMethod>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstring>
+#endif
+
+#define UDP_MAX_BATCH 256
+
+Udp::Udp(QObject *parent) : QObject(parent)
+{
+    traceLink = PacketTrace::registerLink("udp");
+}
+Udp::~Udp()
+{
+    disconnectDevice();
+    PacketTrace::unregisterLink(traceLink);
+}
+
+//bind, optionally join a multicast group, and watch the socket with a QSocketNotifier
+bool Udp::connectDevice(
+                   const std::string &bindIp,
+                   int bindPort,
+                   const std::string &peerIp,
+                   int peerPort,
+                   const std::string &multicastGroup,
+                   int batchSize,
+                   int maxDatagramSize) {
+#ifdef Q_OS_UNIX
+    try {
+        disconnectDevice(); // Close any existing socket first
+
+        fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            cerr << "Cannot create UDP socket: " << std::strerror(errno) << endl;
+            emit errorOccurredSignal(QString("Cannot create UDP socket"));
+            return false;
+        }
+
+        //an address that does not parse must not silently open the port on every interface
+        in_addr interfaceAddress;
+        interfaceAddress.s_addr = htonl(INADDR_ANY);
+        if (!bindIp.empty() && ::inet_pton(AF_INET, bindIp.c_str(), &interfaceAddress) != 1) {
+            cerr << "Invalid UDP bind address " << bindIp << endl;
+            emit errorOccurredSignal(QString("Invalid UDP bind address ") + QString::fromStdString(bindIp));
+            disconnectDevice();
+            return false;
+        }
+        ip_mreq membership;
+        std::memset(&membership, 0, sizeof(membership));
+        if (!multicastGroup.empty() && ::inet_pton(AF_INET, multicastGroup.c_str(), &membership.imr_multiaddr) != 1) {
+            cerr << "Invalid multicast group " << multicastGroup << endl;
+            emit errorOccurredSignal(QString("Invalid multicast group ") + QString::fromStdString(multicastGroup));
+            disconnectDevice();
+            return false;
+        }
+
+        const int one = 1;
+        if (!multicastGroup.empty())
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)); // several listeners per group
+
+        //Linux only delivers group traffic to sockets bound to the group or to INADDR_ANY, with a
+        //group the bind address only selects the interface that joins it and sends from it
+        sockaddr_in local;
+        std::memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons(static_cast<quint16>(bindPort));
+        local.sin_addr = multicastGroup.empty() ? interfaceAddress : membership.imr_multiaddr;
+        if (::bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0) {
+            cerr << "Cannot bind UDP " << bindIp << ":" << bindPort << " : " << std::strerror(errno) << endl;
+            emit errorOccurredSignal(QString("Cannot bind UDP socket"));
+            disconnectDevice();
+            return false;
+        }
+
+        if (!multicastGroup.empty()) {
+            membership.imr_interface = interfaceAddress;
+            if (::setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0) {
+                cerr << "Cannot join multicast group " << multicastGroup << " : " << std::strerror(errno) << endl;
+                emit errorOccurredSignal(QString("Cannot join multicast group"));
+                disconnectDevice();
+                return false;
+            }
+            if (interfaceAddress.s_addr != htonl(INADDR_ANY))
+                ::setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interfaceAddress, sizeof(interfaceAddress));
+        }
+
+        peerAddress = 0;
+        peerPortNo = static_cast<quint16>(peerPort);
+        if (!peerIp.empty()) {
+            in_addr peer;
+            if (::inet_pton(AF_INET, peerIp.c_str(), &peer) == 1)
+                peerAddress = peer.s_addr;
+            else
+                qWarning() << "Invalid UDP peer address" << QString::fromStdString(peerIp);
+        }
+
+        maxDatagram = maxDatagramSize > 0 ? maxDatagramSize : 2048;
+        rxSlots.clear();
+        rxSlots.resize(qBound(1, batchSize, UDP_MAX_BATCH));
+
+        notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+        connect(notifier, &QSocketNotifier::activated, this, &Udp::reciveData);
+
+        PacketTrace::setLinkName(traceLink, QString("udp %1:%2").arg(QString::fromStdString(bindIp)).arg(bindPort));
+        qInfo() << "UDP bound to" << QString::fromStdString(bindIp) << ":" << bindPort
+                << (multicastGroup.empty() ? QString() : "group " + QString::fromStdString(multicastGroup));
+        return true;
+    } catch (...) {
+        cerr << "Exception in connectDevice(UDP)" << endl;
+    }
+#else
+    Q_UNUSED(bindIp); Q_UNUSED(bindPort); Q_UNUSED(peerIp); Q_UNUSED(peerPort);
+    Q_UNUSED(multicastGroup); Q_UNUSED(batchSize); Q_UNUSED(maxDatagramSize);
+    cerr << "UDP transport is only implemented on Unix" << endl;
+#endif
+    return false;
+}
+
+void Udp::disconnectDevice() {
+    try {
+        ++generation; // a reciveData() further up the stack stops at its next check
+        if (notifier) {
+            notifier->setEnabled(false);
+            notifier->disconnect(this);
+            notifier->deleteLater(); // we may be inside its activated() signal
+            notifier = nullptr;
+        }
+#ifdef Q_OS_UNIX
+        if (fd >= 0) {
+            ::close(fd); // also leaves any multicast group
+            fd = -1;
+            qInfo() << "UDP socket closed.";
+        }
+#endif
+    } catch (...) {
+        qCritical() << "Exception in disconnectDevice()";
+    }
+}
+
+//SendData
+void Udp::sendData(const QByteArray &data) {
+    if (!peerAddress || !peerPortNo) {
+        qWarning() << "UDP peer not set!";
+        return;
+    }
+    sendTo(data.constData(), data.size(), peerAddress, peerPortNo);
+}
+
+void Udp::sendData(const QByteArray &data, const std::string &ip, int port) {
+#ifdef Q_OS_UNIX
+    in_addr address;
+    if (::inet_pton(AF_INET, ip.c_str(), &address) != 1) {
+        qWarning() << "Invalid UDP address" << QString::fromStdString(ip);
+        return;
+    }
+    sendTo(data.constData(), data.size(), address.s_addr, static_cast<quint16>(port));
+#else
+    Q_UNUSED(data); Q_UNUSED(ip); Q_UNUSED(port);
+#endif
+}
+
+//all datagrams to the peer in one sendmmsg call, the kernel may take fewer than offered
+int Udp::sendBatch(const QList<QByteArray> &datagrams) {
+    if (fd < 0 || !peerAddress || !peerPortNo) {
+        qWarning() << "UDP socket not open or peer not set!";
+        return 0;
+    }
+    int sent = 0;
+#if defined(Q_OS_LINUX)
+    sockaddr_in peer;
+    std::memset(&peer, 0, sizeof(peer));
+    peer.sin_family = AF_INET;
+    peer.sin_addr.s_addr = peerAddress;
+    peer.sin_port = htons(peerPortNo);
+
+    mmsghdr msgs[UDP_MAX_BATCH];
+    iovec iov[UDP_MAX_BATCH];
+    while (sent < datagrams.size()) {
+        const int count = qMin(datagrams.size() - sent, UDP_MAX_BATCH);
+        for (int i = 0; i < count; ++i) {
+            const QByteArray &datagram = datagrams.at(sent + i);
+            iov[i].iov_base = const_cast<char *>(datagram.constData());
+            iov[i].iov_len = static_cast<size_t>(datagram.size());
+            std::memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_name = &peer;
+            msgs[i].msg_hdr.msg_namelen = sizeof(peer);
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        int n;
+        do {
+            n = ::sendmmsg(fd, msgs, static_cast<unsigned int>(count), 0);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                emit errorOccurredSignal(QString("UDP send failed: ") + std::strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; ++i)
+            PacketTrace::record(traceLink, PacketTrace::Direction::Tx, datagrams.at(sent + i));
+        sent += n;
+        if (n < count)
+            break; // socket buffer full
+    }
+#else
+    for (const QByteArray &datagram : datagrams) {
+        if (!sendTo(datagram.constData(), datagram.size(), peerAddress, peerPortNo))
+            break;
+        ++sent;
+    }
+#endif
+    return sent;
+}
+
+bool Udp::sendTo(const char *data, int size, quint32 ip, quint16 port) {
+#ifdef Q_OS_UNIX
+    if (fd < 0) {
+        qWarning() << "UDP socket not open!";
+        return false;
+    }
+    sockaddr_in to;
+    std::memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = ip;
+    to.sin_port = htons(port);
+    ssize_t n;
+    do {
+        n = ::sendto(fd, data, static_cast<size_t>(size), 0, reinterpret_cast<sockaddr *>(&to), sizeof(to));
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        emit errorOccurredSignal(QString("UDP send failed: ") + std::strerror(errno));
+        return false;
+    }
+    PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data, size);
+    return true;
+#else
+    Q_UNUSED(data); Q_UNUSED(size); Q_UNUSED(ip); Q_UNUSED(port);
+    return false;
+#endif
+}
+
+//drain the socket, up to rxSlots.size() datagrams per recvmmsg call. each datagram is received
+//straight into its own slot and emitted as is, a slot is only reallocated while a consumer holds it
+void Udp::reciveData() {
+#ifdef Q_OS_UNIX
+    try {
+        if (fd < 0)
+            return;
+        //a slot may disconnect or reconnect, which closes fd and reallocates rxSlots under us
+        const quint64 current = generation;
+        auto closedBySlot = [this, current]() { return generation != current; };
+        ++rxWakeups;
+        static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&Udp::dataReady);
+        static const QMetaMethod datagramSignal = QMetaMethod::fromSignal(&Udp::datagramReceived);
+        const bool wantSender = isSignalConnected(datagramSignal);
+        const int batch = rxSlots.size();
+        sockaddr_in from[UDP_MAX_BATCH];
+
+        for (;;) {
+            for (int i = 0; i < batch; ++i) {
+                QByteArray &slot = rxSlots[i];
+                if (!slot.isDetached()) {
+                    slot = QByteArray();
+                    slot.reserve(maxDatagram);
+                }
+                slot.resize(maxDatagram);
+            }
+
+            int received = 0;
+#ifdef Q_OS_LINUX
+            mmsghdr msgs[UDP_MAX_BATCH];
+            iovec iov[UDP_MAX_BATCH];
+            for (int i = 0; i < batch; ++i) {
+                iov[i].iov_base = rxSlots[i].data();
+                iov[i].iov_len = static_cast<size_t>(maxDatagram);
+                std::memset(&msgs[i], 0, sizeof(mmsghdr));
+                msgs[i].msg_hdr.msg_name = &from[i];
+                msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+                msgs[i].msg_hdr.msg_iov = &iov[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            do {
+                received = ::recvmmsg(fd, msgs, static_cast<unsigned int>(batch), MSG_DONTWAIT, nullptr);
+            } while (received < 0 && errno == EINTR);
+#else
+            socklen_t fromLen = sizeof(sockaddr_in);
+            const ssize_t n = ::recvfrom(fd, rxSlots[0].data(), static_cast<size_t>(maxDatagram), MSG_DONTWAIT,
+                                         reinterpret_cast<sockaddr *>(&from[0]), &fromLen);
+            received = n >= 0 ? 1 : -1;
+#endif
+            if (received <= 0) {
+                if (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+                    emit errorOccurredSignal(QString("UDP receive failed: ") + std::strerror(errno));
+                break;
+            }
+
+            for (int i = 0; i < received; ++i) {
+                QByteArray &slot = rxSlots[i];
+#ifdef Q_OS_LINUX
+                slot.resize(static_cast<int>(msgs[i].msg_len));
+                if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+                    ++rxTruncated; // larger than maxDatagramSize
+                    continue;
+                }
+#else
+                slot.resize(static_cast<int>(n));
+#endif
+                ++rxDatagrams;
+                PacketTrace::record(traceLink, PacketTrace::Direction::Rx, slot);
+                if (isSignalConnected(dataReadySignal)) {
+                    emit dataReady(slot);
+                    if (closedBySlot())
+                        return;
+                }
+                if (wantSender) {
+                    char address[INET_ADDRSTRLEN];
+                    ::inet_ntop(AF_INET, &from[i].sin_addr, address, sizeof(address));
+                    emit datagramReceived(slot, QString(address), ntohs(from[i].sin_port));
+                    if (closedBySlot())
+                        return;
+                }
+            }
+            emit readReady();
+            if (received < batch || closedBySlot())
+                break; // drained, or a slot closed the socket
+        }
+    } catch (...) {
+        qCritical() << "Exception in reciveData()";
+    }
+#endif
+}
@@ -0,0 +1,71 @@
+#ifndef UDP_H
+#define UDP_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QVector>
+#include <QList>
+#include <iostream>
+#include "packettrace.h"
+
+// Use std namespace for cout/cerr as in the original file
+using std::cout;
+using std::cerr;
+using std::endl;
+
+//UDP transport on a native IPv4 socket, one readable wakeup drains up to batchSize datagrams
+//with recvmmsg (Linux) and sendBatch hands many datagrams to the kernel with one sendmmsg.
+//other Unix systems fall back to one recvfrom/sendto per datagram.
+class Udp : public QObject
+{
+    Q_OBJECT
+public:
+    explicit Udp(QObject *parent = nullptr);
+    ~Udp();
+
+    bool connectDevice(
+                       const std::string &bindIp = "0.0.0.0",
+                       int bindPort = 0,
+                       const std::string &peerIp = "",        // default destination of sendData
+                       int peerPort = 0,
+                       const std::string &multicastGroup = "", // joined on the bindIp interface, the socket is bound to the group
+                       int batchSize = 32,
+                       int maxDatagramSize = 2048);
+
+    // Public methods
+    void disconnectDevice();
+    void sendData(const QByteArray &data); // to the peer given in connectDevice
+    void sendData(const QByteArray &data, const std::string &ip, int port);
+    int sendBatch(const QList<QByteArray> &datagrams); // to the peer, returns datagrams sent
+
+    bool isOpen() const { return fd >= 0; }
+    quint64 datagramsReceived() const { return rxDatagrams; }
+    quint64 readWakeups() const { return rxWakeups; } // datagramsReceived / readWakeups = batching gain
+    quint64 datagramsDropped() const { return rxTruncated; } // larger than maxDatagramSize
+
+signals:
+    void dataReady(const QByteArray &data); // one datagram
+    void datagramReceived(const QByteArray &data, const QString &senderIp, quint16 senderPort);
+    void readReady();
+    void errorOccurredSignal(const QString &msg);
+
+private slots:
+    void reciveData();
+
+private:
+    bool sendTo(const char *data, int size, quint32 ip, quint16 port);
+
+    int fd = -1;
+    QSocketNotifier *notifier = nullptr;
+    QVector<QByteArray> rxSlots; // one per batch entry, reused unless a consumer still holds it
+    int maxDatagram = 2048;
+    quint32 peerAddress = 0; // network byte order
+    quint16 peerPortNo = 0;  // host byte order
+    quint64 rxDatagrams = 0;
+    quint64 rxWakeups = 0;
+    quint64 rxTruncated = 0;
+    quint64 generation = 0; // bumped on every close, see reciveData
+    quint16 traceLink;
+};
+
+#endif // UDP_H
@@ -0,0 +1,591 @@
+#include "unixsocket.h"
+#include <QMetaMethod>
+#include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#endif
+
+UnixSocket::UnixSocket(QObject *parent) : QObject(parent)
+{
+    traceLink = PacketTrace::registerLink("unix");
+}
+UnixSocket::~UnixSocket()
+{
+    disconnectDevice();
+    PacketTrace::unregisterLink(traceLink);
+}
+
+#ifdef Q_OS_UNIX
+//'@name' goes to the abstract namespace (Linux), anything else is a filesystem path
+static bool fillAddress(const std::string &path, sockaddr_un &address, socklen_t &length) {
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path))
+        return false;
+    std::memcpy(address.sun_path, path.data(), path.size());
+    if (path[0] == '@')
+        address.sun_path[0] = '\0';
+    length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + (path[0] == '@' ? 0 : 1));
+    return true;
+}
+#endif
+
+bool UnixSocket::connectDevice(
+                   const std::string &path,
+                   Role role,
+                   Mode mode,
+                   int maxMessageSize) {
+#ifdef Q_OS_UNIX
+    try {
+        disconnectDevice(); // Close any existing socket first
+
+        socketMode = mode;
+        maxMessage = maxMessageSize > 0 ? maxMessageSize : 64 * 1024;
+        rxPool = RxBufferPool(maxMessage, 8);
+
+        sockaddr_un address;
+        socklen_t addressLength = 0;
+        if (!fillAddress(path, address, addressLength)) {
+            cerr << "Invalid unix socket path " << path << endl;
+            emit errorOccurredSignal(QString("Invalid unix socket path"));
+            return false;
+        }
+
+        const int type = (mode == Mode::SeqPacket ? SOCK_SEQPACKET : SOCK_STREAM) | SOCK_NONBLOCK | SOCK_CLOEXEC;
+        const int fd = ::socket(AF_UNIX, type, 0);
+        if (fd < 0) {
+            cerr << "Cannot create unix socket: " << std::strerror(errno) << endl;
+            emit errorOccurredSignal(QString("Cannot create unix socket"));
+            return false;
+        }
+
+        if (role == Role::Server) {
+            if (path[0] != '@')
+                ::unlink(path.c_str()); // stale socket file of an earlier run
+            if (::bind(fd, reinterpret_cast<sockaddr *>(&address), addressLength) != 0
+                    || ::listen(fd, SOMAXCONN) != 0) {
+                cerr << "Cannot listen on " << path << " : " << std::strerror(errno) << endl;
+                emit errorOccurredSignal(QString("Cannot listen on unix socket"));
+                ::close(fd);
+                return false;
+            }
+            listenFd = fd;
+            boundPath = path[0] == '@' ? std::string() : path;
+            listenNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+            connect(listenNotifier, &QSocketNotifier::activated, this, &UnixSocket::acceptConnections);
+            qInfo() << "Unix socket server listening on" << QString::fromStdString(path);
+        } else {
+            //local connect completes or fails immediately, EAGAIN means the server backlog is full
+            if (::connect(fd, reinterpret_cast<sockaddr *>(&address), addressLength) != 0) {
+                cerr << "Cannot connect to " << path << " : " << std::strerror(errno) << endl;
+                emit errorOccurredSignal(QString("Cannot connect to unix socket"));
+                ::close(fd);
+                return false;
+            }
+            openConnection(client, fd, 0);
+            qInfo() << "Unix socket connected to" << QString::fromStdString(path);
+        }
+        PacketTrace::setLinkName(traceLink, QString("unix %1").arg(QString::fromStdString(path)));
+        return true;
+    } catch (...) {
+        cerr << "Exception in connectDevice(Unix socket)" << endl;
+    }
+#else
+    Q_UNUSED(path); Q_UNUSED(role); Q_UNUSED(mode); Q_UNUSED(maxMessageSize);
+    cerr << "Unix domain sockets are only implemented on Unix" << endl;
+#endif
+    return false;
+}
+
+void UnixSocket::disconnectDevice() {
+    try {
+        ++generation; // a reciveData() further up the stack stops at its next check
+        shutdownConnection(client);
+        for (auto it = connections.begin(); it != connections.end(); ++it)
+            shutdownConnection(it.value());
+        connections.clear();
+        if (listenNotifier) {
+            listenNotifier->setEnabled(false);
+            listenNotifier->disconnect(this);
+            listenNotifier->deleteLater(); // we may be inside its activated() signal
+            listenNotifier = nullptr;
+        }
+#ifdef Q_OS_UNIX
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+            if (!boundPath.empty())
+                ::unlink(boundPath.c_str());
+            boundPath.clear();
+            qInfo() << "Unix socket server closed.";
+        }
+#endif
+    } catch (...) {
+        qCritical() << "Exception in disconnectDevice()";
+    }
+}
+
+void UnixSocket::openConnection(Connection &conn, int fd, int connectionId) {
+    conn.fd = fd;
+    conn.readNotifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(conn.readNotifier, &QSocketNotifier::activated, this, [this, connectionId]() {
+        reciveData(connectionId);
+        emit readReady();
+    });
+    conn.writeNotifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+    conn.writeNotifier->setEnabled(false); // only while writes are pending
+    connect(conn.writeNotifier, &QSocketNotifier::activated, this, [this, connectionId]() {
+        Connection *target = connectionFor(connectionId);
+        if (target && !writePending(*target))
+            closeConnection(connectionId);
+    });
+}
+
+//notifiers are deleted later, this may run from one of their own activated() signals
+void UnixSocket::shutdownConnection(Connection &conn) {
+    for (QSocketNotifier *notifier : {conn.readNotifier, conn.writeNotifier}) {
+        if (notifier) {
+            notifier->setEnabled(false);
+            notifier->deleteLater();
+        }
+    }
+    conn.readNotifier = nullptr;
+    conn.writeNotifier = nullptr;
+#ifdef Q_OS_UNIX
+    for (const Outgoing &out : conn.pending) {
+        if (out.memfd >= 0)
+            ::close(out.memfd);
+    }
+    if (conn.fd >= 0)
+        ::close(conn.fd);
+#endif
+    conn.pending.clear();
+    conn.pendingOffset = 0;
+    conn.fd = -1;
+}
+
+UnixSocket::Connection *UnixSocket::connectionFor(int connectionId) {
+    if (connectionId == 0)
+        return client.fd >= 0 ? &client : nullptr;
+    auto it = connections.find(connectionId);
+    return it == connections.end() ? nullptr : &it.value();
+}
+
+//id 0 is the client socket
+void UnixSocket::closeConnection(int connectionId) {
+    if (connectionId == 0) {
+        if (client.fd >= 0) {
+            shutdownConnection(client);
+            qInfo() << "Unix socket closed.";
+        }
+        return;
+    }
+    auto it = connections.find(connectionId);
+    if (it == connections.end())
+        return;
+    shutdownConnection(it.value());
+    connections.erase(it);
+    qInfo() << "Unix socket client" << connectionId << "disconnected";
+    emit clientDisconnected(connectionId);
+}
+
+void UnixSocket::setFdPassingThreshold(int bytes) {
+    fdThreshold = bytes > 0 ? bytes : 0;
+#ifndef Q_OS_LINUX
+    if (fdThreshold)
+        qWarning() << "memfd block passing is only implemented on Linux, blocks are sent inline";
+#endif
+}
+
+int UnixSocket::pendingWrites() const {
+    int count = client.pending.size();
+    for (const Connection &conn : connections)
+        count += conn.pending.size();
+    return count;
+}
+
+
+//SendData
+void UnixSocket::sendData(const QByteArray &data) {
+    try {
+        if (client.fd >= 0) {
+            if (!writeData(client, data)) {
+                emit errorOccurredSignal("Unix socket send failed");
+                closeConnection(0);
+            }
+            return;
+        }
+        if (listenFd < 0) {
+            qWarning() << "Unix socket not open!";
+            return;
+        }
+        const QList<int> ids = connections.keys();
+        for (int id : ids)
+            sendData(id, data);
+    } catch (...) {
+        qCritical() << "Exception in sendData()";
+    }
+}
+
+void UnixSocket::sendData(int connectionId, const QByteArray &data) {
+    try {
+        Connection *conn = connectionId > 0 ? connectionFor(connectionId) : nullptr;
+        if (!conn) {
+            qWarning() << "Unix socket connection" << connectionId << "not available!";
+            return;
+        }
+        if (!writeData(*conn, data))
+            closeConnection(connectionId);
+    } catch (...) {
+        qCritical() << "Exception in sendData()";
+    }
+}
+
+//write now if nothing is queued, otherwise (or on a full socket buffer) queue behind the write notifier
+bool UnixSocket::writeData(Connection &conn, const QByteArray &data) {
+#ifdef Q_OS_UNIX
+    if (data.isEmpty())
+        return true;
+    Outgoing out;
+    out.data = data;
+    if (socketMode == Mode::SeqPacket && fdThreshold > 0 && data.size() >= fdThreshold)
+        out.memfd = createBlock(data); // -1: sent inline instead
+
+    if (conn.pending.isEmpty()) {
+        if (out.memfd >= 0) {
+            const int sent = sendDescriptor(conn.fd, out.memfd);
+            if (sent != 0) {
+                ::close(out.memfd);
+                if (sent < 0)
+                    return false;
+                ++fdBlocksSent;
+                PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+                return true;
+            }
+        } else {
+            const int written = writeMessage(conn.fd, data.constData(), data.size());
+            if (written < 0)
+                return false;
+            if (written == data.size()) {
+                PacketTrace::record(traceLink, PacketTrace::Direction::Tx, data);
+                return true;
+            }
+            conn.pendingOffset = written; // Stream only, a datagram is all or nothing
+        }
+    }
+    conn.pending.append(out);
+    if (conn.writeNotifier)
+        conn.writeNotifier->setEnabled(true);
+    return true;
+#else
+    Q_UNUSED(conn); Q_UNUSED(data);
+    return false;
+#endif
+}
+
+//drain the queue until the socket buffer is full again
+bool UnixSocket::writePending(Connection &conn) {
+#ifdef Q_OS_UNIX
+    while (!conn.pending.isEmpty()) {
+        const Outgoing &out = conn.pending.first();
+        if (out.memfd >= 0) {
+            const int sent = sendDescriptor(conn.fd, out.memfd);
+            if (sent < 0)
+                return false;
+            if (sent == 0)
+                return true;
+            ::close(out.memfd);
+            ++fdBlocksSent;
+        } else {
+            const int remaining = out.data.size() - conn.pendingOffset;
+            const int written = writeMessage(conn.fd, out.data.constData() + conn.pendingOffset, remaining);
+            if (written < 0)
+                return false;
+            if (written < remaining) {
+                conn.pendingOffset += written;
+                return true;
+            }
+        }
+        PacketTrace::record(traceLink, PacketTrace::Direction::Tx, out.data);
+        conn.pending.removeFirst();
+        conn.pendingOffset = 0;
+    }
+    if (conn.writeNotifier)
+        conn.writeNotifier->setEnabled(false);
+    return true;
+#else
+    Q_UNUSED(conn);
+    return false;
+#endif
+}
+
+int UnixSocket::writeMessage(int fd, const char *data, int size) {
+#ifdef Q_OS_UNIX
+    ssize_t n;
+    do {
+        n = ::send(fd, data, static_cast<size_t>(size), MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n >= 0)
+        return static_cast<int>(n);
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return 0;
+    qWarning() << "Unix socket write failed:" << std::strerror(errno);
+    return -1;
+#else
+    Q_UNUSED(fd); Q_UNUSED(data); Q_UNUSED(size);
+    return -1;
+#endif
+}
+
+//one marker byte carrying the descriptor, the receiver keeps its own reference to the memfd
+int UnixSocket::sendDescriptor(int fd, int memfd) {
+#ifdef Q_OS_UNIX
+    char marker = 'M';
+    iovec iov;
+    iov.iov_base = &marker;
+    iov.iov_len = 1;
+    union {
+        char buf[CMSG_SPACE(sizeof(int))];
+        cmsghdr align;
+    } control;
+    std::memset(&control, 0, sizeof(control));
+
+    msghdr msg;
+    std::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &memfd, sizeof(int));
+
+    ssize_t n;
+    do {
+        n = ::sendmsg(fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+    if (n > 0)
+        return 1;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        return 0;
+    qWarning() << "Unix socket descriptor send failed:" << std::strerror(errno);
+    return -1;
+#else
+    Q_UNUSED(fd); Q_UNUSED(memfd);
+    return -1;
+#endif
+}
+
+//sealed so the receiver can trust the size and the content can no longer change under it
+int UnixSocket::createBlock(const QByteArray &data) {
+#ifdef Q_OS_LINUX
+    const int memfd = ::memfd_create("commmodule-block", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memfd < 0) {
+        qWarning() << "memfd_create failed:" << std::strerror(errno);
+        return -1;
+    }
+    const char *p = data.constData();
+    size_t left = static_cast<size_t>(data.size());
+    while (left > 0) {
+        const ssize_t n = ::write(memfd, p, left);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0) {
+            ::close(memfd);
+            return -1;
+        }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+    if (::fcntl(memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) != 0) {
+        ::close(memfd);
+        return -1;
+    }
+    return memfd;
+#else
+    Q_UNUSED(data);
+    return -1;
+#endif
+}
+
+QByteArray UnixSocket::readBlock(int memfd) {
+#ifdef Q_OS_LINUX
+    const int required = F_SEAL_SHRINK | F_SEAL_WRITE;
+    struct stat info;
+    if ((::fcntl(memfd, F_GET_SEALS) & required) != required || ::fstat(memfd, &info) != 0
+            || info.st_size <= 0 || info.st_size > 0x7fffffff) {
+        qWarning() << "Unix socket dropped an unsealed or invalid block";
+        return QByteArray();
+    }
+    QByteArray block;
+    block.resize(static_cast<int>(info.st_size));
+    qint64 done = 0;
+    while (done < block.size()) {
+        const ssize_t n = ::pread(memfd, block.data() + done, static_cast<size_t>(block.size() - done), done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return QByteArray();
+        done += n;
+    }
+    return block;
+#else
+    Q_UNUSED(memfd);
+    return QByteArray();
+#endif
+}
+
+
+//read into pooled chunks until the socket is drained. SeqPacket gets one message per chunk,
+//a message carrying a descriptor is replaced by the block behind it
+void UnixSocket::reciveData(int connectionId) {
+#ifdef Q_OS_UNIX
+    try {
+        static const QMetaMethod dataReadySignal = QMetaMethod::fromSignal(&UnixSocket::dataReady);
+        static const QMetaMethod dataReceivedSignal = QMetaMethod::fromSignal(&UnixSocket::dataReceived);
+        const bool seqPacket = socketMode == Mode::SeqPacket;
+        //a slot may disconnect or reconnect, which reassigns rxPool and leaves chunk dangling
+        const quint64 current = generation;
+        auto closedBySlot = [this, current]() { return generation != current; };
+
+        for (;;) {
+            Connection *conn = connectionFor(connectionId);
+            if (!conn)
+                return; // a slot closed the connection
+            QByteArray &chunk = rxPool.acquire();
+            chunk.resize(rxPool.chunkSize());
+
+            iovec iov;
+            iov.iov_base = chunk.data();
+            iov.iov_len = static_cast<size_t>(chunk.size());
+            union {
+                char buf[CMSG_SPACE(sizeof(int) * 4)];
+                cmsghdr align;
+            } control;
+            msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            if (seqPacket) {
+                msg.msg_control = control.buf;
+                msg.msg_controllen = sizeof(control.buf);
+            }
+
+            ssize_t got;
+            do {
+#ifdef MSG_CMSG_CLOEXEC
+                got = ::recvmsg(conn->fd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+#else
+                got = ::recvmsg(conn->fd, &msg, MSG_DONTWAIT);
+#endif
+            } while (got < 0 && errno == EINTR);
+
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                chunk.resize(0);
+                return;
+            }
+            if (got <= 0) {
+                chunk.resize(0);
+                if (got < 0)
+                    emit errorOccurredSignal(QString("Unix socket read failed: ") + std::strerror(errno));
+                closeConnection(connectionId); // peer closed
+                return;
+            }
+            chunk.resize(static_cast<int>(got));
+
+            int memfd = -1;
+            if (seqPacket) {
+                for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+                        continue;
+                    const int count = static_cast<int>((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+                    for (int i = 0; i < count; ++i) {
+                        int received;
+                        std::memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                        if (memfd < 0)
+                            memfd = received;
+                        else
+                            ::close(received); // only one block per message is expected
+                    }
+                }
+                if (msg.msg_flags & MSG_TRUNC) {
+                    ++rxDropped; // larger than maxMessageSize
+                    if (memfd >= 0)
+                        ::close(memfd);
+                    chunk.resize(0);
+                    continue;
+                }
+            }
+
+            QByteArray block;
+            if (memfd >= 0) {
+                block = readBlock(memfd);
+                ::close(memfd);
+                chunk.resize(0);
+                if (block.isEmpty())
+                    continue;
+                ++fdBlocksReceived;
+            }
+            const QByteArray &data = memfd >= 0 ? block : chunk;
+            PacketTrace::record(traceLink, PacketTrace::Direction::Rx, data);
+            if (connectionId > 0 && isSignalConnected(dataReceivedSignal)) {
+                emit dataReceived(connectionId, data);
+                if (closedBySlot())
+                    return;
+            }
+            if (isSignalConnected(dataReadySignal)) { // no copy is pinned when nobody listens
+                emit dataReady(data);
+                if (closedBySlot())
+                    return;
+            }
+            if (!seqPacket && got < rxPool.chunkSize())
+                return; // drained, the notifier fires again for anything that arrives later
+        }
+    } catch (...) {
+        qCritical() << "Exception in reciveData()";
+    }
+#else
+    Q_UNUSED(connectionId);
+#endif
+}
+
+
+//Server role ---------------------------
+
+//accept everything that is pending in one go, each connection gets an id
+void UnixSocket::acceptConnections() {
+#ifdef Q_OS_UNIX
+    try {
+        while (listenFd >= 0) {
+            const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR)
+                    continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                    qWarning() << "Unix socket accept failed:" << std::strerror(errno);
+                break;
+            }
+            const int id = nextConnectionId++;
+            Connection &conn = connections[id];
+            openConnection(conn, fd, id);
+            qInfo() << "Unix socket client" << id << "connected";
+            emit clientConnected(id);
+        }
+    } catch (...) {
+        qCritical() << "Exception in acceptConnections()";
+    }
+#endif
+}
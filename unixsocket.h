@@ -0,0 +1,124 @@
+#ifndef UNIXSOCKET_H
+#define UNIXSOCKET_H
+
+#include <QObject>
+#include <QSocketNotifier>
+#include <QHash>
+#include <QList>
+#include <iostream>
+#include "rxbufferpool.h"
+#include "packettrace.h"
+
+// Use std namespace for cout/cerr as in the original file
+using std::cout;
+using std::cerr;
+using std::endl;
+
+//Unix domain socket transport for processes on the same host, no TCP/IP stack on the path.
+//Stream behaves like Tcp (dataReady carries whatever was read), SeqPacket keeps message boundaries
+//so every dataReady is exactly one sendData. in SeqPacket mode blocks of at least
+//setFdPassingThreshold() bytes are written once into a sealed memfd and only the descriptor is sent
+//(SCM_RIGHTS), which replaces the two copies through the socket buffer with one write and one read.
+//a path starting with '@' is bound in the Linux abstract namespace, no file is created.
+class UnixSocket : public QObject
+{
+    Q_OBJECT
+public:
+    explicit UnixSocket(QObject *parent = nullptr);
+    ~UnixSocket();
+
+    enum class Role {
+        Client,
+        Server
+    };
+
+    enum class Mode {
+        Stream,     // SOCK_STREAM
+        SeqPacket   // SOCK_SEQPACKET, message boundaries kept
+    };
+
+    bool connectDevice(
+                       const std::string &path = "/tmp/commmodule.sock",
+                       Role role = Role::Client,
+                       Mode mode = Mode::Stream,
+                       int maxMessageSize = 64 * 1024); // SeqPacket: larger messages are dropped on receive
+
+    // Public methods
+    void disconnectDevice();
+    void sendData(const QByteArray &data); // Server role: sent to every connection
+
+    // Server role, connections are identified by an id handed out on accept
+    void sendData(int connectionId, const QByteArray &data);
+    void closeConnection(int connectionId);
+    QList<int> connectionIds() const { return connections.keys(); }
+    int connectionCount() const { return connections.size(); }
+
+    void setFdPassingThreshold(int bytes); // SeqPacket only, 0 = off
+    int fdPassingThreshold() const { return fdThreshold; }
+
+    bool isOpen() const { return client.fd >= 0 || listenFd >= 0; }
+    int pendingWrites() const; // messages waiting for socket buffer space
+    quint64 blocksSentByFd() const { return fdBlocksSent; }
+    quint64 blocksReceivedByFd() const { return fdBlocksReceived; }
+    quint64 messagesDropped() const { return rxDropped; } // SeqPacket messages larger than maxMessageSize
+    quint64 rxAllocationCount() const { return rxPool.allocationCount(); }
+
+signals:
+    void dataReady(const QByteArray &data);
+    void readReady();
+    void errorOccurredSignal(const QString &msg);
+
+    // Server role, per connection attribution (dataReady is emitted as well)
+    void clientConnected(int connectionId);
+    void clientDisconnected(int connectionId);
+    void dataReceived(int connectionId, const QByteArray &data);
+
+private slots:
+    void acceptConnections();
+
+private:
+    // A message that did not fit into the socket buffer, memfd >= 0 if it goes as a descriptor
+    struct Outgoing {
+        QByteArray data;
+        int memfd = -1;
+    };
+
+    // The client socket or one accepted socket
+    struct Connection {
+        int fd = -1;
+        QSocketNotifier *readNotifier = nullptr;
+        QSocketNotifier *writeNotifier = nullptr;
+        QList<Outgoing> pending;
+        int pendingOffset = 0; // Stream: bytes of pending.first() already written
+    };
+
+    void openConnection(Connection &conn, int fd, int connectionId);
+    void shutdownConnection(Connection &conn);
+    void reciveData(int connectionId);
+    bool writeData(Connection &conn, const QByteArray &data); // false: the connection failed
+    bool writePending(Connection &conn);
+    int writeMessage(int fd, const char *data, int size); // bytes written, 0 on EAGAIN, -1 on error
+    int sendDescriptor(int fd, int memfd); // 1 sent, 0 on EAGAIN, -1 on error
+    int createBlock(const QByteArray &data);
+    QByteArray readBlock(int memfd);
+    Connection *connectionFor(int connectionId);
+
+    Connection client; // Client role, id 0
+    QHash<int, Connection> connections;
+    int nextConnectionId = 1;
+    int listenFd = -1;
+    QSocketNotifier *listenNotifier = nullptr;
+    std::string boundPath; // unlinked on disconnect, empty for the abstract namespace
+
+    Mode socketMode = Mode::Stream;
+    int maxMessage = 64 * 1024;
+    int fdThreshold = 0;
+    RxBufferPool rxPool;
+    quint64 fdBlocksSent = 0;
+    quint64 fdBlocksReceived = 0;
+    quint64 rxDropped = 0;
+    quint64 generation = 0; // bumped on every close, see reciveData
+    quint16 traceLink;
+};
+
+#endif // UNIXSOCKET_H